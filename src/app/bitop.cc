@@ -21,123 +21,338 @@
 
 #include "app/bitop.hh"
 
+#include <algorithm>
 #include <bit>
-#include <functional>
+#include <memory>
+#include <vector>
+
+#include "common/memory.hh"
+#include "common/specs.hh"
+
+#if HEXBED_X86_SIMD
+#include <immintrin.h>
+#endif
 
 namespace hexbed {
 
-template <typename T>
-static bool doBitwiseBinaryOp_(HexBedDocument& document, bufsize offset,
-                               bufsize count, const_bytespan second,
-                               const T& op) {
-    return document.map(offset, count,
-                        [op, second](bufoffset offset, bytespan span) -> bool {
-                            bufoffset i = offset;
-                            for (byte& b : span)
-                                b = op(b, second[i++ % second.size()]);
-                            return true;
-                        });
-}
+// every op below works on single bytes and, if SIMD is available, on
+// 16 or 32 bytes at a time. the 8-bit lane shifts x86 lacks are done on
+// 16-bit lanes and the bits that crossed over are masked off
 
-template <typename T>
-static bool doBitwiseUnaryOp_(HexBedDocument& document, bufsize offset,
-                              bufsize count, const T& op) {
-    return document.map(offset, count,
-                        [op](bufoffset offset, bytespan span) -> bool {
-                            for (byte& b : span) b = op(b);
-                            return true;
-                        });
-}
+struct AddOp {
+    byte operator()(byte a, byte b) const noexcept { return a + b; }
+#if HEXBED_X86_SIMD
+    __m128i operator()(__m128i a, __m128i b) const noexcept {
+        return _mm_add_epi8(a, b);
+    }
+    HEXBED_TARGET_AVX2 __m256i operator()(__m256i a, __m256i b) const noexcept {
+        return _mm256_add_epi8(a, b);
+    }
+#endif
+};
 
-template <typename T>
-static bool doBitwiseShiftOp_(HexBedDocument& document, bufsize offset,
-                              bufsize count, unsigned sc, const T& op) {
-    return document.map(offset, count,
-                        [op, sc](bufoffset offset, bytespan span) -> bool {
-                            for (byte& b : span) b = op(b, sc);
-                            return true;
-                        });
+struct AndOp {
+    byte operator()(byte a, byte b) const noexcept { return a & b; }
+#if HEXBED_X86_SIMD
+    __m128i operator()(__m128i a, __m128i b) const noexcept {
+        return _mm_and_si128(a, b);
+    }
+    HEXBED_TARGET_AVX2 __m256i operator()(__m256i a, __m256i b) const noexcept {
+        return _mm256_and_si256(a, b);
+    }
+#endif
+};
+
+struct OrOp {
+    byte operator()(byte a, byte b) const noexcept { return a | b; }
+#if HEXBED_X86_SIMD
+    __m128i operator()(__m128i a, __m128i b) const noexcept {
+        return _mm_or_si128(a, b);
+    }
+    HEXBED_TARGET_AVX2 __m256i operator()(__m256i a, __m256i b) const noexcept {
+        return _mm256_or_si256(a, b);
+    }
+#endif
+};
+
+struct XorOp {
+    byte operator()(byte a, byte b) const noexcept { return a ^ b; }
+#if HEXBED_X86_SIMD
+    __m128i operator()(__m128i a, __m128i b) const noexcept {
+        return _mm_xor_si128(a, b);
+    }
+    HEXBED_TARGET_AVX2 __m256i operator()(__m256i a, __m256i b) const noexcept {
+        return _mm256_xor_si256(a, b);
+    }
+#endif
+};
+
+struct NotOp {
+    byte operator()(byte v) const noexcept { return ~v; }
+#if HEXBED_X86_SIMD
+    __m128i operator()(__m128i v) const noexcept {
+        return _mm_xor_si128(v, _mm_set1_epi8(-1));
+    }
+    HEXBED_TARGET_AVX2 __m256i operator()(__m256i v) const noexcept {
+        return _mm256_xor_si256(v, _mm256_set1_epi8(-1));
+    }
+#endif
+};
+
+struct NibbleSwapOp {
+    byte operator()(byte v) const noexcept {
+        return (v & 0xF0) >> 4 | (v & 0x0F) << 4;
+    }
+#if HEXBED_X86_SIMD
+    __m128i operator()(__m128i v) const noexcept {
+        __m128i lo = _mm_set1_epi8(0x0F);
+        return _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, 4), lo),
+                            _mm_slli_epi16(_mm_and_si128(v, lo), 4));
+    }
+    HEXBED_TARGET_AVX2 __m256i operator()(__m256i v) const noexcept {
+        __m256i lo = _mm256_set1_epi8(0x0F);
+        return _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(v, 4), lo),
+                               _mm256_slli_epi16(_mm256_and_si256(v, lo), 4));
+    }
+#endif
+};
+
+#if HEXBED_X86_SIMD
+static inline __m128i swapBitsSSE2(__m128i v, int s, char m) noexcept {
+    __m128i lo = _mm_set1_epi8(m);
+    return _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, s), lo),
+                        _mm_slli_epi16(_mm_and_si128(v, lo), s));
 }
+#endif
 
-template <typename T, typename Ts>
+struct BitReverseOp {
+    byte operator()(byte v) const noexcept {
+        v = (v & 0xF0) >> 4 | (v & 0x0F) << 4;
+        v = (v & 0xCC) >> 2 | (v & 0x33) << 2;
+        v = (v & 0xAA) >> 1 | (v & 0x55) << 1;
+        return v;
+    }
+#if HEXBED_X86_SIMD
+    __m128i operator()(__m128i v) const noexcept {
+        v = swapBitsSSE2(v, 4, 0x0F);
+        v = swapBitsSSE2(v, 2, 0x33);
+        return swapBitsSSE2(v, 1, 0x55);
+    }
+    // reverse each nibble with a table lookup and swap them
+    HEXBED_TARGET_AVX2 __m256i operator()(__m256i v) const noexcept {
+        __m256i lo = _mm256_set1_epi8(0x0F);
+        __m256i revlo = _mm256_setr_epi8(
+            0x00, 0x08, 0x04, 0x0C, 0x02, 0x0A, 0x06, 0x0E, 0x01, 0x09, 0x05,
+            0x0D, 0x03, 0x0B, 0x07, 0x0F, 0x00, 0x08, 0x04, 0x0C, 0x02, 0x0A,
+            0x06, 0x0E, 0x01, 0x09, 0x05, 0x0D, 0x03, 0x0B, 0x07, 0x0F);
+        __m256i revhi = _mm256_slli_epi16(revlo, 4);
+        __m256i h = _mm256_and_si256(_mm256_srli_epi16(v, 4), lo);
+        return _mm256_or_si256(
+            _mm256_shuffle_epi8(revhi, _mm256_and_si256(v, lo)),
+            _mm256_shuffle_epi8(revlo, h));
+    }
+#endif
+};
+
+// shift counts must be at most 8
 struct ShiftLeftOp {
-    T operator()(const T& v, const Ts& s) const noexcept { return v << s; }
+    unsigned s;
+    byte operator()(byte v) const noexcept { return v << s; }
+#if HEXBED_X86_SIMD
+    __m128i operator()(__m128i v) const noexcept {
+        return _mm_and_si128(_mm_slli_epi16(v, s),
+                             _mm_set1_epi8(static_cast<char>(0xFF << s)));
+    }
+    HEXBED_TARGET_AVX2 __m256i operator()(__m256i v) const noexcept {
+        return _mm256_and_si256(_mm256_slli_epi16(v, s),
+                                _mm256_set1_epi8(static_cast<char>(0xFF << s)));
+    }
+#endif
 };
 
-template <typename T, typename Ts>
 struct ShiftRightOp {
-    T operator()(const T& v, const Ts& s) const noexcept { return v >> s; }
+    unsigned s;
+    byte operator()(byte v) const noexcept { return v >> s; }
+#if HEXBED_X86_SIMD
+    __m128i operator()(__m128i v) const noexcept {
+        return _mm_and_si128(_mm_srli_epi16(v, s),
+                             _mm_set1_epi8(static_cast<char>(0xFF >> s)));
+    }
+    HEXBED_TARGET_AVX2 __m256i operator()(__m256i v) const noexcept {
+        return _mm256_and_si256(_mm256_srli_epi16(v, s),
+                                _mm256_set1_epi8(static_cast<char>(0xFF >> s)));
+    }
+#endif
 };
 
-template <typename T, typename Ts>
+// (v >> s ^ m) - m with m = 0x80 >> s sign-extends the shifted byte.
+// shift counts must be at most 7
 struct ShiftRightArithmOp {
-    T operator()(const T& v, const Ts& s) const noexcept {
-        return v & std::bit_floor<T>(std::numeric_limits<T>::max())
-                   ? ((v >> s) | ~(T(~0) >> s))
-                   : v;
+    unsigned s;
+    byte operator()(byte v) const noexcept {
+        byte m = 0x80 >> s;
+        return ((v >> s) ^ m) - m;
     }
+#if HEXBED_X86_SIMD
+    __m128i operator()(__m128i v) const noexcept {
+        __m128i m = _mm_set1_epi8(static_cast<char>(0x80 >> s));
+        v = ShiftRightOp{s}(v);
+        return _mm_sub_epi8(_mm_xor_si128(v, m), m);
+    }
+    HEXBED_TARGET_AVX2 __m256i operator()(__m256i v) const noexcept {
+        __m256i m = _mm256_set1_epi8(static_cast<char>(0x80 >> s));
+        v = ShiftRightOp{s}(v);
+        return _mm256_sub_epi8(_mm256_xor_si256(v, m), m);
+    }
+#endif
 };
 
-template <typename T, typename Ts>
+// rotate counts must be below 8
 struct RotateLeftOp {
-    T operator()(const T& v, const Ts& s) const noexcept {
-        return std::rotl(v, s);
+    unsigned s;
+    byte operator()(byte v) const noexcept { return std::rotl(v, s); }
+#if HEXBED_X86_SIMD
+    __m128i operator()(__m128i v) const noexcept {
+        return _mm_or_si128(ShiftLeftOp{s}(v), ShiftRightOp{8 - s}(v));
     }
-};
-
-template <typename T, typename Ts>
-struct RotateRightOp {
-    T operator()(const T& v, const Ts& s) const noexcept {
-        return std::rotr(v, s);
+    HEXBED_TARGET_AVX2 __m256i operator()(__m256i v) const noexcept {
+        return _mm256_or_si256(ShiftLeftOp{s}(v), ShiftRightOp{8 - s}(v));
     }
+#endif
 };
 
 template <typename T>
-static constexpr T loNibbleMask;
+static void bitwiseUnaryScalar(byte* p, bufsize n, const T& op) noexcept {
+    for (bufsize i = 0; i < n; ++i) p[i] = op(p[i]);
+}
 
-template <>
-constexpr byte loNibbleMask<byte> = 0x0F;
+template <typename T>
+static void bitwiseBinaryScalar(byte* p, bufsize n, const byte* key,
+                                bufsize period, bufsize q,
+                                const T& op) noexcept {
+    for (bufsize i = 0; i < n; ++i) {
+        p[i] = op(p[i], key[q]);
+        if (++q == period) q = 0;
+    }
+}
 
+#if HEXBED_X86_SIMD
 template <typename T>
-static constexpr T hiNibbleMask = loNibbleMask<T> << 4;
+static void bitwiseUnarySSE2(byte* p, bufsize n, const T& op) noexcept {
+    bufsize i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i* v = reinterpret_cast<__m128i*>(p + i);
+        _mm_storeu_si128(v, op(_mm_loadu_si128(v)));
+    }
+    bitwiseUnaryScalar(p + i, n - i, op);
+}
 
 template <typename T>
-struct NibbleSwapOp {
-    T operator()(const T& v) const noexcept {
-        return (v & hiNibbleMask<T>) >> 4 | (v & loNibbleMask<T>) << 4;
+HEXBED_TARGET_AVX2 static void bitwiseUnaryAVX2(byte* p, bufsize n,
+                                                const T& op) noexcept {
+    bufsize i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i* v = reinterpret_cast<__m256i*>(p + i);
+        _mm256_storeu_si256(v, op(_mm256_loadu_si256(v)));
     }
-};
+    bitwiseUnaryScalar(p + i, n - i, op);
+}
 
 template <typename T>
-struct BitReverseOp {};
+static void bitwiseBinarySSE2(byte* p, bufsize n, const byte* key,
+                              bufsize period, bufsize q,
+                              const T& op) noexcept {
+    bufsize i = 0, step = 16 % period;
+    for (; i + 16 <= n; i += 16) {
+        __m128i* v = reinterpret_cast<__m128i*>(p + i);
+        __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + q));
+        _mm_storeu_si128(v, op(_mm_loadu_si128(v), k));
+        if ((q += step) >= period) q -= period;
+    }
+    bitwiseBinaryScalar(p + i, n - i, key, period, q, op);
+}
 
-template <>
-struct BitReverseOp<byte> {
-    byte operator()(const byte& v_) const noexcept {
-        byte v = v_;
-        v = (v & 0xF0) >> 4 | (v & 0x0F) << 4;
-        v = (v & 0xCC) >> 2 | (v & 0x33) << 2;
-        v = (v & 0xAA) >> 1 | (v & 0x55) << 1;
-        return v;
+template <typename T>
+HEXBED_TARGET_AVX2 static void bitwiseBinaryAVX2(byte* p, bufsize n,
+                                                 const byte* key,
+                                                 bufsize period, bufsize q,
+                                                 const T& op) noexcept {
+    bufsize i = 0, step = 32 % period;
+    for (; i + 32 <= n; i += 32) {
+        __m256i* v = reinterpret_cast<__m256i*>(p + i);
+        __m256i k =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key + q));
+        _mm256_storeu_si256(v, op(_mm256_loadu_si256(v), k));
+        if ((q += step) >= period) q -= period;
     }
-};
+    bitwiseBinaryScalar(p + i, n - i, key, period, q, op);
+}
+#endif
+
+template <typename T>
+static void bitwiseUnary(byte* p, bufsize n, const T& op) noexcept {
+#if HEXBED_X86_SIMD
+    if (hasAVX2) return bitwiseUnaryAVX2(p, n, op);
+    return bitwiseUnarySSE2(p, n, op);
+#else
+    return bitwiseUnaryScalar(p, n, op);
+#endif
+}
+
+// key holds period bytes of the second operand starting at phase 0 and
+// then 32 more, so that a vector load from any phase needs no wrapping
+template <typename T>
+static void bitwiseBinary(byte* p, bufsize n, const byte* key, bufsize period,
+                          bufsize q, const T& op) noexcept {
+#if HEXBED_X86_SIMD
+    if (hasAVX2) return bitwiseBinaryAVX2(p, n, key, period, q, op);
+    return bitwiseBinarySSE2(p, n, key, period, q, op);
+#else
+    return bitwiseBinaryScalar(p, n, key, period, q, op);
+#endif
+}
+
+static constexpr bufsize BITWISE_KEY_SLACK = 32;
+
+template <typename T>
+static bool doBitwiseBinaryOp_(HexBedDocument& document, bufsize offset,
+                               bufsize count, const_bytespan second,
+                               const T& op) {
+    bufsize period = second.size();
+    if (!period) return false;
+    auto key = std::make_shared<std::vector<byte>>(period + BITWISE_KEY_SLACK);
+    memFillRepeat(key->data(), period, second.data(), key->size());
+    return document.map(offset, count,
+                        [op, key, period](bufoffset offset, bytespan span) {
+                            bitwiseBinary(span.data(), span.size(),
+                                          key->data(), period,
+                                          offset % period, op);
+                            return true;
+                        });
+}
+
+template <typename T>
+static bool doBitwiseUnaryOp_(HexBedDocument& document, bufsize offset,
+                              bufsize count, const T& op) {
+    return document.map(offset, count,
+                        [op](bufoffset offset, bytespan span) -> bool {
+                            bitwiseUnary(span.data(), span.size(), op);
+                            return true;
+                        });
+}
 
 bool doBitwiseBinaryOp(HexBedDocument& document, bufsize offset, bufsize count,
                        const_bytespan second, BitwiseBinaryOp op) {
     using enum BitwiseBinaryOp;
     switch (op) {
     case Add:
-        return doBitwiseBinaryOp_(document, offset, count, second,
-                                  std::plus<byte>());
+        return doBitwiseBinaryOp_(document, offset, count, second, AddOp());
     case And:
-        return doBitwiseBinaryOp_(document, offset, count, second,
-                                  std::bit_and<byte>());
+        return doBitwiseBinaryOp_(document, offset, count, second, AndOp());
     case Or:
-        return doBitwiseBinaryOp_(document, offset, count, second,
-                                  std::bit_or<byte>());
+        return doBitwiseBinaryOp_(document, offset, count, second, OrOp());
     case Xor:
-        return doBitwiseBinaryOp_(document, offset, count, second,
-                                  std::bit_xor<byte>());
+        return doBitwiseBinaryOp_(document, offset, count, second, XorOp());
     default:
         return false;
     }
@@ -148,11 +363,11 @@ bool doBitwiseUnaryOp(HexBedDocument& document, bufsize offset, bufsize count,
     using enum BitwiseUnaryOp;
     switch (op) {
     case Not:
-        return doBitwiseUnaryOp_(document, offset, count, std::bit_not<byte>());
+        return doBitwiseUnaryOp_(document, offset, count, NotOp());
     case NibbleSwap:
-        return doBitwiseUnaryOp_(document, offset, count, NibbleSwapOp<byte>());
+        return doBitwiseUnaryOp_(document, offset, count, NibbleSwapOp());
     case BitReverse:
-        return doBitwiseUnaryOp_(document, offset, count, BitReverseOp<byte>());
+        return doBitwiseUnaryOp_(document, offset, count, BitReverseOp());
     default:
         return false;
     }
@@ -164,20 +379,20 @@ bool doBitwiseShiftOp(HexBedDocument& document, bufsize offset, bufsize count,
     using enum BitwiseShiftOp;
     switch (op) {
     case ShiftLeft:
-        return doBitwiseShiftOp_(document, offset, count, sc,
-                                 ShiftLeftOp<byte, unsigned>());
+        return doBitwiseUnaryOp_(document, offset, count,
+                                 ShiftLeftOp{std::min(sc, 8U)});
     case ShiftRight:
-        return doBitwiseShiftOp_(document, offset, count, sc,
-                                 ShiftRightOp<byte, unsigned>());
+        return doBitwiseUnaryOp_(document, offset, count,
+                                 ShiftRightOp{std::min(sc, 8U)});
     case ShiftRightArithmetic:
-        return doBitwiseShiftOp_(document, offset, count, sc,
-                                 ShiftRightArithmOp<byte, unsigned>());
+        return doBitwiseUnaryOp_(document, offset, count,
+                                 ShiftRightArithmOp{std::min(sc, 7U)});
     case RotateLeft:
-        return doBitwiseShiftOp_(document, offset, count, sc,
-                                 RotateLeftOp<byte, unsigned>());
+        return doBitwiseUnaryOp_(document, offset, count,
+                                 RotateLeftOp{sc % 8});
     case RotateRight:
-        return doBitwiseShiftOp_(document, offset, count, sc,
-                                 RotateRightOp<byte, unsigned>());
+        return doBitwiseUnaryOp_(document, offset, count,
+                                 RotateLeftOp{(8 - sc % 8) % 8});
     default:
         return false;
     }
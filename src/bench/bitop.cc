@@ -0,0 +1,188 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// bench/bitop.cc -- benchmark for the bit operation kernels
+
+// times each bit operation on a document against the per-byte loops it
+// used to run, and checks that both give the same bytes. usage:
+//     hexbed-bench [MiB]
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "app/bitop.hh"
+#include "common/memory.hh"
+#include "file/context.hh"
+#include "file/document.hh"
+
+namespace hexbed {
+
+// charconv wants this from the UI, which the benchmark does not link
+bool isUnicodePrintable(char32_t c) { return false; }
+
+namespace bench {
+
+static bool oldBinary(HexBedDocument& document, const_bytespan second,
+                      const std::function<byte(byte, byte)>& op) {
+    return document.map(0, document.size(),
+                        [op, second](bufoffset offset, bytespan span) -> bool {
+                            bufoffset i = offset;
+                            for (byte& b : span)
+                                b = op(b, second[i++ % second.size()]);
+                            return true;
+                        });
+}
+
+static bool oldUnary(HexBedDocument& document,
+                     const std::function<byte(byte)>& op) {
+    return document.map(0, document.size(),
+                        [op](bufoffset offset, bytespan span) -> bool {
+                            for (byte& b : span) b = op(b);
+                            return true;
+                        });
+}
+
+static byte oldBitReverse(byte v) {
+    v = (v & 0xF0) >> 4 | (v & 0x0F) << 4;
+    v = (v & 0xCC) >> 2 | (v & 0x33) << 2;
+    v = (v & 0xAA) >> 1 | (v & 0x55) << 1;
+    return v;
+}
+
+static constexpr byte KEY[] = {0x13, 0x37, 0xC0, 0xDE, 0x42, 0x99, 0x5A};
+
+struct Case {
+    const char* name;
+    std::function<bool(HexBedDocument&)> before;
+    std::function<bool(HexBedDocument&)> after;
+};
+
+static double timed(HexBedDocument& document,
+                    const std::function<bool(HexBedDocument&)>& fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    if (!fn(document)) {
+        std::fprintf(stderr, "operation failed\n");
+        std::exit(1);
+    }
+    std::chrono::duration<double> t = std::chrono::steady_clock::now() - t0;
+    return t.count();
+}
+
+static bool sameBytes(HexBedDocument& a, HexBedDocument& b) {
+    std::vector<byte> x(1 << 20), y(1 << 20);
+    for (bufoffset o = 0; o < a.size(); o += x.size()) {
+        bufsize n = a.read(o, bytespan(x.data(), x.size()));
+        if (b.read(o, bytespan(y.data(), y.size())) != n) return false;
+        if (!std::equal(x.begin(), x.begin() + n, y.begin())) return false;
+    }
+    return true;
+}
+
+static int run(bufsize mib) {
+    bufsize size = mib << 20;
+    std::vector<byte> data(size);
+    std::mt19937 rng(1);
+    for (byte& b : data) b = static_cast<byte>(rng());
+    auto context = std::make_shared<HexBedContext>();
+    HexBedDocument before(context), after(context);
+    before.insert(0, const_bytespan(data.data(), data.size()));
+    after.insert(0, const_bytespan(data.data(), data.size()));
+    data.clear();
+    data.shrink_to_fit();
+
+    const_bytespan key(KEY, sizeof(KEY));
+    std::vector<Case> cases{
+        {"xor, 7-byte key",
+         [key](HexBedDocument& d) {
+             return oldBinary(d, key, [](byte a, byte b) { return a ^ b; });
+         },
+         [key](HexBedDocument& d) {
+             return doBitwiseBinaryOp(d, 0, d.size(), key,
+                                      BitwiseBinaryOp::Xor);
+         }},
+        {"add, 7-byte key",
+         [key](HexBedDocument& d) {
+             return oldBinary(d, key,
+                              [](byte a, byte b) -> byte { return a + b; });
+         },
+         [key](HexBedDocument& d) {
+             return doBitwiseBinaryOp(d, 0, d.size(), key,
+                                      BitwiseBinaryOp::Add);
+         }},
+        {"not",
+         [](HexBedDocument& d) {
+             return oldUnary(d, [](byte v) -> byte { return ~v; });
+         },
+         [](HexBedDocument& d) {
+             return doBitwiseUnaryOp(d, 0, d.size(), BitwiseUnaryOp::Not);
+         }},
+        {"bit reversal",
+         [](HexBedDocument& d) { return oldUnary(d, oldBitReverse); },
+         [](HexBedDocument& d) {
+             return doBitwiseUnaryOp(d, 0, d.size(),
+                                     BitwiseUnaryOp::BitReverse);
+         }},
+        {"rotate left 3",
+         [](HexBedDocument& d) {
+             return oldUnary(d, [](byte v) { return std::rotl(v, 3); });
+         },
+         [](HexBedDocument& d) {
+             return doBitwiseShiftOp(d, 0, d.size(), 3,
+                                     BitwiseShiftOp::RotateLeft);
+         }},
+    };
+
+#if HEXBED_X86_SIMD
+    std::printf("%llu MiB, AVX2 %s\n", static_cast<unsigned long long>(mib),
+                hasAVX2 ? "yes" : "no");
+#else
+    std::printf("%llu MiB, no x86 SIMD\n",
+                static_cast<unsigned long long>(mib));
+#endif
+    int status = 0;
+    for (const Case& c : cases) {
+        double t0 = timed(before, c.before), t1 = timed(after, c.after);
+        bool same = sameBytes(before, after);
+        if (!same) status = 1;
+        std::printf("%-16s %7.2f -> %7.2f GB/s%s\n", c.name, size / t0 / 1e9,
+                    size / t1 / 1e9, same ? "" : "  MISMATCH");
+    }
+    return status;
+}
+
+};  // namespace bench
+
+};  // namespace hexbed
+
+int main(int argc, char** argv) {
+    unsigned long mib = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    if (!mib) {
+        std::fprintf(stderr, "usage: %s [MiB]\n", argv[0]);
+        return 2;
+    }
+    return hexbed::bench::run(mib);
+}
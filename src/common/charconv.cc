@@ -507,7 +507,7 @@ CharacterEncoding getBuiltinCharacterEncodingByName(const string& name) {
 
 CharEncodeInputFunction charEncodeFromArray(std::size_t n,
                                             const char32_t* arr) {
-    return [&n, &arr](u32span s) -> bufsize {
+    return [n, arr](u32span s) mutable -> bufsize {
         std::size_t r = std::min<std::size_t>(n, s.size());
         for (std::size_t i = 0; i < r; ++i, --n) s[i] = *arr++;
         return r;
@@ -515,11 +515,10 @@ CharEncodeInputFunction charEncodeFromArray(std::size_t n,
 }
 
 CharEncodeInputFunction charEncodeFromString(std::u32string s) {
-    std::size_t n = s.size();
-    const char32_t* arr = s.data();
-    return [&n, &arr](u32span s) -> bufsize {
-        std::size_t r = std::min<std::size_t>(n, s.size());
-        for (std::size_t i = 0; i < r; ++i, --n) s[i] = *arr++;
+    return [str = std::move(s), p = std::size_t(0)](u32span s) mutable
+           -> bufsize {
+        std::size_t r = std::min<std::size_t>(str.size() - p, s.size());
+        for (std::size_t i = 0; i < r; ++i) s[i] = str[p++];
         return r;
     };
 }
@@ -529,14 +528,14 @@ CharEncodeOutputFunction charEncodeToNull() {
 }
 
 CharEncodeOutputFunction charEncodeToArray(std::size_t n, byte* arr) {
-    return [&n, &arr](const_bytespan s) {
+    return [n, arr](const_bytespan s) mutable {
         std::size_t r = std::min<std::size_t>(n, s.size());
         for (std::size_t i = 0; i < r; ++i, --n) *arr++ = s[i];
     };
 }
 
 CharDecodeInputFunction charDecodeFromArray(std::size_t n, const byte* arr) {
-    return [&n, &arr](bytespan s) -> bufsize {
+    return [n, arr](bytespan s) mutable -> bufsize {
         std::size_t r = std::min<std::size_t>(n, s.size());
         for (std::size_t i = 0; i < r; ++i, --n) s[i] = *arr++;
         return r;
@@ -61,6 +61,9 @@ void Configuration::loadValues() {
     values_.showColumnTypes = loadIntRange("showColumnTypes", 3, 1, 3);
     values_.backupFiles = loadBool("backupFiles", true);
     values_.utfMode = loadIntRange("utfMode", 0, 4, 0);
+    values_.decompressFiles = loadBool("decompressFiles", true);
+    values_.streamMaximum = loadIntRange("streamMaximum", 4096, 1,
+                                         std::numeric_limits<int>::max());
 }
 
 void Configuration::saveValues() {
@@ -87,6 +90,8 @@ void Configuration::saveValues() {
     saveInt("showColumnTypes", values_.showColumnTypes);
     saveBool("backupFiles", values_.backupFiles);
     saveInt("utfMode", values_.utfMode);
+    saveBool("decompressFiles", values_.decompressFiles);
+    saveInt("streamMaximum", values_.streamMaximum);
 }
 
 long Configuration::loadColor(const string& key, long def) {
@@ -57,6 +57,8 @@ struct ConfigurationValues {
     long showColumnTypes;
     bool backupFiles;
     long utfMode;
+    bool decompressFiles;
+    long streamMaximum;
 };
 
 class Configuration {
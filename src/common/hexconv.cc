@@ -134,6 +134,27 @@ bool hexToBytes(bufsize& len, byte* data, const string& text) {
     return true;
 }
 
+bool hexToMaskedBytes(std::vector<byte>& value, std::vector<byte>& mask,
+                      const string& text) {
+    byte v = 0, m = 0;
+    bool nibble = false;
+    value.clear();
+    mask.clear();
+    for (strchar c : text) {
+        if (c_isspace(c)) continue;
+        int d = c == CHAR('?') ? 0 : hexDigitToNum(c);
+        if (d < 0) return false;
+        v = (v << 4) | d;
+        m = (m << 4) | (c == CHAR('?') ? 0 : 0xF);
+        if (nibble) {
+            value.push_back(v);
+            mask.push_back(m);
+        }
+        nibble = !nibble;
+    }
+    return !nibble;
+}
+
 bool convertBaseFrom(bufsize& out, stringview text, unsigned base) {
     bufsize o = 0, oo = 0;
     if (text.empty()) return false;
@@ -38,6 +38,9 @@ void fastByteConvX(strchar* out, const strchar* hex, byte b);
 string hexFromBytes(bufsize len, const byte* data, bool upper,
                     bool cont = false);
 bool hexToBytes(bufsize& len, byte* data, const string& text);
+// ? stands for any nibble; mask has the bits that must match
+bool hexToMaskedBytes(std::vector<byte>& value, std::vector<byte>& mask,
+                      const string& text);
 
 bool convertBaseFrom(bufsize& out, stringview text, unsigned base);
 string convertBaseTo(bufsize in, unsigned base, bool upper);
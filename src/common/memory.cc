@@ -22,9 +22,16 @@
 #include "common/memory.hh"
 
 #include <algorithm>
+#include <bit>
 #include <cstring>
 #include <iterator>
 
+#include "common/specs.hh"
+
+#if HEXBED_X86_SIMD
+#include <immintrin.h>
+#endif
+
 namespace hexbed {
 
 bufsize memCopy(byte* edi, const byte* esi, bufsize ecx) noexcept {
@@ -151,4 +158,353 @@ const byte* memFindLast2(const byte* start, const byte* end, byte c1,
     return p1 ? (p2 ? std::max(p1, p2) : p1) : p2;
 }
 
+static const byte* memFindPairScalar(const byte* start, const byte* end,
+                                     bufsize i, byte c1, bufsize j,
+                                     byte c2) noexcept {
+    const byte* p = start + i;
+    while ((p = memFindFirst(p, end + i, c1))) {
+        if ((p - i)[j] == c2) return p - i;
+        ++p;
+    }
+    return nullptr;
+}
+
+static const byte* memFindPairLastScalar(const byte* start, const byte* end,
+                                         bufsize i, byte c1, bufsize j,
+                                         byte c2) noexcept {
+    const byte* p = end + i;
+    while ((p = memFindLast(start + i, p, c1)))
+        if ((p - i)[j] == c2) return p - i;
+    return nullptr;
+}
+
+static const byte* memFindPairMaskedScalar(const byte* start, const byte* end,
+                                           bufsize i, byte c1, byte m1,
+                                           bufsize j, byte c2,
+                                           byte m2) noexcept {
+    if (m1 == 0xFF && m2 == 0xFF)
+        return memFindPairScalar(start, end, i, c1, j, c2);
+    for (const byte* p = start; p < end; ++p)
+        if ((p[i] & m1) == c1 && (p[j] & m2) == c2) return p;
+    return nullptr;
+}
+
+static const byte* memFindPairMaskedLastScalar(const byte* start,
+                                               const byte* end, bufsize i,
+                                               byte c1, byte m1, bufsize j,
+                                               byte c2, byte m2) noexcept {
+    if (m1 == 0xFF && m2 == 0xFF)
+        return memFindPairLastScalar(start, end, i, c1, j, c2);
+    for (const byte* p = end; p > start;) {
+        --p;
+        if ((p[i] & m1) == c1 && (p[j] & m2) == c2) return p;
+    }
+    return nullptr;
+}
+
+#if HEXBED_X86_SIMD
+static const byte* memFindPairSSE2(const byte* start, const byte* end,
+                                   bufsize i, byte c1, byte m1, bufsize j,
+                                   byte c2, byte m2) noexcept {
+    const __m128i v1 = _mm_set1_epi8(static_cast<char>(c1));
+    const __m128i v2 = _mm_set1_epi8(static_cast<char>(c2));
+    const __m128i k1 = _mm_set1_epi8(static_cast<char>(m1));
+    const __m128i k2 = _mm_set1_epi8(static_cast<char>(m2));
+    const byte* p = start;
+    for (; end - p >= 16; p += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + j));
+        unsigned m = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(x, k1), v1),
+                          _mm_cmpeq_epi8(_mm_and_si128(y, k2), v2)));
+        if (m) return p + __builtin_ctz(m);
+    }
+    return memFindPairMaskedScalar(p, end, i, c1, m1, j, c2, m2);
+}
+
+static const byte* memFindPairLastSSE2(const byte* start, const byte* end,
+                                       bufsize i, byte c1, byte m1, bufsize j,
+                                       byte c2, byte m2) noexcept {
+    const __m128i v1 = _mm_set1_epi8(static_cast<char>(c1));
+    const __m128i v2 = _mm_set1_epi8(static_cast<char>(c2));
+    const __m128i k1 = _mm_set1_epi8(static_cast<char>(m1));
+    const __m128i k2 = _mm_set1_epi8(static_cast<char>(m2));
+    const byte* p = end;
+    while (p - start >= 16) {
+        p -= 16;
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + j));
+        unsigned m = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(x, k1), v1),
+                          _mm_cmpeq_epi8(_mm_and_si128(y, k2), v2)));
+        if (m) return p + (31 - __builtin_clz(m));
+    }
+    return memFindPairMaskedLastScalar(start, p, i, c1, m1, j, c2, m2);
+}
+
+static bool memEqualMaskedSSE2(const byte* a, const byte* b,
+                               const byte* mask, bufsize n) noexcept {
+    for (; n >= 16; a += 16, b += 16, mask += 16, n -= 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+        __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask));
+        __m128i d = _mm_and_si128(_mm_xor_si128(x, y), k);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(d, _mm_setzero_si128())) !=
+            0xFFFF)
+            return false;
+    }
+    while (n--)
+        if ((*a++ ^ *b++) & *mask++) return false;
+    return true;
+}
+
+HEXBED_TARGET_AVX2
+static const byte* memFindPairAVX2(const byte* start, const byte* end,
+                                   bufsize i, byte c1, byte m1, bufsize j,
+                                   byte c2, byte m2) noexcept {
+    const __m256i v1 = _mm256_set1_epi8(static_cast<char>(c1));
+    const __m256i v2 = _mm256_set1_epi8(static_cast<char>(c2));
+    const __m256i k1 = _mm256_set1_epi8(static_cast<char>(m1));
+    const __m256i k2 = _mm256_set1_epi8(static_cast<char>(m2));
+    const byte* p = start;
+    for (; end - p >= 32; p += 32) {
+        __m256i x =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i y =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + j));
+        unsigned m = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(x, k1), v1),
+                             _mm256_cmpeq_epi8(_mm256_and_si256(y, k2), v2))));
+        if (m) return p + __builtin_ctz(m);
+    }
+    return memFindPairSSE2(p, end, i, c1, m1, j, c2, m2);
+}
+
+HEXBED_TARGET_AVX2
+static const byte* memFindPairLastAVX2(const byte* start, const byte* end,
+                                       bufsize i, byte c1, byte m1, bufsize j,
+                                       byte c2, byte m2) noexcept {
+    const __m256i v1 = _mm256_set1_epi8(static_cast<char>(c1));
+    const __m256i v2 = _mm256_set1_epi8(static_cast<char>(c2));
+    const __m256i k1 = _mm256_set1_epi8(static_cast<char>(m1));
+    const __m256i k2 = _mm256_set1_epi8(static_cast<char>(m2));
+    const byte* p = end;
+    while (p - start >= 32) {
+        p -= 32;
+        __m256i x =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i y =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + j));
+        unsigned m = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(x, k1), v1),
+                             _mm256_cmpeq_epi8(_mm256_and_si256(y, k2), v2))));
+        if (m) return p + (31 - __builtin_clz(m));
+    }
+    return memFindPairLastSSE2(start, p, i, c1, m1, j, c2, m2);
+}
+
+HEXBED_TARGET_AVX2
+static bool memEqualMaskedAVX2(const byte* a, const byte* b,
+                               const byte* mask, bufsize n) noexcept {
+    for (; n >= 32; a += 32, b += 32, mask += 32, n -= 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+        __m256i k =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask));
+        if (!_mm256_testz_si256(_mm256_xor_si256(x, y), k)) return false;
+    }
+    return memEqualMaskedSSE2(a, b, mask, n);
+}
+
+static std::uint64_t memCompareLineSSE2(const byte* a,
+                                        const byte* b) noexcept {
+    std::uint64_t m = 0;
+    for (int k = 0; k < 4; ++k) {
+        __m128i x =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 16 * k));
+        __m128i y =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 16 * k));
+        m |= static_cast<std::uint64_t>(static_cast<unsigned>(
+                 _mm_movemask_epi8(_mm_cmpeq_epi8(x, y))))
+             << (16 * k);
+    }
+    return m;
+}
+
+HEXBED_TARGET_AVX2
+static void memCompareLinesAVX2(const byte* data, bufsize lines,
+                                const byte* pattern, bufsize period,
+                                std::uint64_t* masks) noexcept {
+    for (bufsize l = 0, q = 0; l < lines; ++l, data += 64) {
+        const byte* b = pattern + q;
+        __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        __m256i x1 =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32));
+        __m256i y0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+        __m256i y1 =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 32));
+        std::uint32_t m0 = static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(x0, y0)));
+        std::uint32_t m1 = static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(x1, y1)));
+        masks[l] = m0 | static_cast<std::uint64_t>(m1) << 32;
+        if ((q += 64) == period) q = 0;
+    }
+}
+
+HEXBED_TARGET_AVX2
+static const byte* memFindFirstOfAVX2(const byte* start, const byte* end,
+                                      const ByteClass& cls) noexcept {
+    const __m256i lo = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(cls.lo)));
+    const __m256i hi = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(cls.hi)));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+    const byte* p = start;
+    for (; end - p >= 32; p += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i l = _mm256_shuffle_epi8(lo, _mm256_and_si256(x, nibble));
+        __m256i h = _mm256_shuffle_epi8(
+            hi, _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble));
+        std::uint32_t m = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_and_si256(l, h), zero)));
+        for (; m; m &= m - 1) {
+            const byte* q = p + std::countr_zero(m);
+            if (cls.members[*q]) return q;
+        }
+    }
+    for (; p < end; ++p)
+        if (cls.members[*p]) return p;
+    return nullptr;
+}
+
+static bool detectAVX2() noexcept {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+const bool hasAVX2 = detectAVX2();
+#endif
+
+const byte* memFindPair(const byte* start, const byte* end, bufsize i,
+                        byte c1, bufsize j, byte c2) noexcept {
+    if (start >= end) return nullptr;
+#if HEXBED_X86_SIMD
+    if (hasAVX2) return memFindPairAVX2(start, end, i, c1, 0xFF, j, c2, 0xFF);
+    return memFindPairSSE2(start, end, i, c1, 0xFF, j, c2, 0xFF);
+#else
+    return memFindPairScalar(start, end, i, c1, j, c2);
+#endif
+}
+
+const byte* memFindPairLast(const byte* start, const byte* end, bufsize i,
+                            byte c1, bufsize j, byte c2) noexcept {
+    if (start >= end) return nullptr;
+#if HEXBED_X86_SIMD
+    if (hasAVX2)
+        return memFindPairLastAVX2(start, end, i, c1, 0xFF, j, c2, 0xFF);
+    return memFindPairLastSSE2(start, end, i, c1, 0xFF, j, c2, 0xFF);
+#else
+    return memFindPairLastScalar(start, end, i, c1, j, c2);
+#endif
+}
+
+const byte* memFindPairMasked(const byte* start, const byte* end, bufsize i,
+                              byte c1, byte m1, bufsize j, byte c2,
+                              byte m2) noexcept {
+    if (start >= end) return nullptr;
+#if HEXBED_X86_SIMD
+    if (hasAVX2) return memFindPairAVX2(start, end, i, c1, m1, j, c2, m2);
+    return memFindPairSSE2(start, end, i, c1, m1, j, c2, m2);
+#else
+    return memFindPairMaskedScalar(start, end, i, c1, m1, j, c2, m2);
+#endif
+}
+
+const byte* memFindPairMaskedLast(const byte* start, const byte* end,
+                                  bufsize i, byte c1, byte m1, bufsize j,
+                                  byte c2, byte m2) noexcept {
+    if (start >= end) return nullptr;
+#if HEXBED_X86_SIMD
+    if (hasAVX2) return memFindPairLastAVX2(start, end, i, c1, m1, j, c2, m2);
+    return memFindPairLastSSE2(start, end, i, c1, m1, j, c2, m2);
+#else
+    return memFindPairMaskedLastScalar(start, end, i, c1, m1, j, c2, m2);
+#endif
+}
+
+static std::uint64_t memCompareLineScalar(const byte* a, const byte* b,
+                                          bufsize n) noexcept {
+    std::uint64_t m = 0;
+    for (bufsize k = 0; k < n; ++k)
+        m |= static_cast<std::uint64_t>(a[k] == b[k]) << k;
+    return m;
+}
+
+void memCompareLines(const byte* data, bufsize n, const byte* pattern,
+                     bufsize period, std::uint64_t* masks) noexcept {
+    bufsize lines = n / 64, q = 0;
+#if HEXBED_X86_SIMD
+    if (hasAVX2) {
+        memCompareLinesAVX2(data, lines, pattern, period, masks);
+        q = lines * 64 % period;
+    } else {
+        for (bufsize l = 0; l < lines; ++l) {
+            masks[l] = memCompareLineSSE2(data + l * 64, pattern + q);
+            if ((q += 64) == period) q = 0;
+        }
+    }
+#else
+    for (bufsize l = 0; l < lines; ++l) {
+        masks[l] = memCompareLineScalar(data + l * 64, pattern + q, 64);
+        if ((q += 64) == period) q = 0;
+    }
+#endif
+    if (n % 64)
+        masks[lines] =
+            memCompareLineScalar(data + lines * 64, pattern + q, n % 64);
+}
+
+bool memEqualMasked(const byte* a, const byte* b, const byte* mask,
+                    bufsize n) noexcept {
+#if HEXBED_X86_SIMD
+    if (hasAVX2) return memEqualMaskedAVX2(a, b, mask, n);
+    return memEqualMaskedSSE2(a, b, mask, n);
+#else
+    while (n--)
+        if ((*a++ ^ *b++) & *mask++) return false;
+    return true;
+#endif
+}
+
+void memMakeByteClass(ByteClass& cls, const bool* members) noexcept {
+    std::fill(std::begin(cls.lo), std::end(cls.lo), 0);
+    std::fill(std::begin(cls.hi), std::end(cls.hi), 0);
+    std::copy(members, members + 256, cls.members);
+    unsigned bucket = 0;
+    for (unsigned h = 0; h < 16; ++h) {
+        bool any = false;
+        for (unsigned l = 0; l < 16; ++l) {
+            if (!members[h << 4 | l]) continue;
+            cls.lo[l] |= byte(1) << bucket;
+            any = true;
+        }
+        if (!any) continue;
+        cls.hi[h] = byte(1) << bucket;
+        bucket = (bucket + 1) % 8;
+    }
+}
+
+const byte* memFindFirstOf(const byte* start, const byte* end,
+                           const ByteClass& cls) noexcept {
+    if (start >= end) return nullptr;
+#if HEXBED_X86_SIMD
+    if (hasAVX2) return memFindFirstOfAVX2(start, end, cls);
+#endif
+    for (const byte* p = start; p < end; ++p)
+        if (cls.members[*p]) return p;
+    return nullptr;
+}
+
 };  // namespace hexbed
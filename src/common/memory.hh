@@ -22,10 +22,18 @@
 #ifndef HEXBED_COMMON_MEMORY_HH
 #define HEXBED_COMMON_MEMORY_HH
 
+#include <cstdint>
+
+#include "common/specs.hh"
 #include "common/types.hh"
 
 namespace hexbed {
 
+#if HEXBED_X86_SIMD
+// whether the CPU runs the AVX2 kernels; the SSE2 ones always run
+extern const bool hasAVX2;
+#endif
+
 bufsize memCopy(byte* edi, const byte* esi, bufsize ecx) noexcept;
 bufsize memCopyBack(byte* edi, const byte* esi, bufsize ecx) noexcept;
 bufsize memMove(byte* edi, const byte* esi, bufsize ecx) noexcept;
@@ -40,6 +48,41 @@ const byte* memFindFirst2(const byte* start, const byte* end, byte c1,
                           byte c2) noexcept;
 const byte* memFindLast2(const byte* start, const byte* end, byte c1,
                          byte c2) noexcept;
+// find p in [start, end) where p[i] == c1 and p[j] == c2. reads up to
+// end[max(i, j) - 1]
+const byte* memFindPair(const byte* start, const byte* end, bufsize i,
+                        byte c1, bufsize j, byte c2) noexcept;
+const byte* memFindPairLast(const byte* start, const byte* end, bufsize i,
+                            byte c1, bufsize j, byte c2) noexcept;
+// as above, but with (p[i] & m1) == c1 and (p[j] & m2) == c2
+const byte* memFindPairMasked(const byte* start, const byte* end, bufsize i,
+                              byte c1, byte m1, bufsize j, byte c2,
+                              byte m2) noexcept;
+const byte* memFindPairMaskedLast(const byte* start, const byte* end,
+                                  bufsize i, byte c1, byte m1, bufsize j,
+                                  byte c2, byte m2) noexcept;
+// true if a and b are equal in every bit set in mask
+bool memEqualMasked(const byte* a, const byte* b, const byte* mask,
+                    bufsize n) noexcept;
+// compares n bytes of data against pattern, which repeats every period
+// bytes (a multiple of 64), one 64-byte line at a time. bit k of masks[l]
+// is set if data[64 * l + k] matches; bits past n are clear
+void memCompareLines(const byte* data, bufsize n, const byte* pattern,
+                     bufsize period, std::uint64_t* masks) noexcept;
+
+// a set of bytes for memFindFirstOf. the bytes are put in eight buckets by
+// their high nibble, and a byte may be in the set if the buckets for both
+// of its nibbles match. that is exact for up to eight different high
+// nibbles; other candidates are checked against members
+struct ByteClass {
+    alignas(16) byte lo[16];
+    alignas(16) byte hi[16];
+    bool members[256];
+};
+void memMakeByteClass(ByteClass& cls, const bool* members) noexcept;
+// first byte in [start, end) that is in the set, or null
+const byte* memFindFirstOf(const byte* start, const byte* end,
+                           const ByteClass& cls) noexcept;
 };  // namespace hexbed
 
 #endif /* HEXBED_COMMON_MEMORY_HH */
@@ -34,4 +34,11 @@
 #define HEXBED_UNLIKELY(x) (x)
 #endif
 
+// x86 SIMD kernels, picked at runtime with __builtin_cpu_supports
+#if defined(__GNUC__) && \
+    (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define HEXBED_X86_SIMD 1
+#define HEXBED_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
 #endif /* HEXBED_COMMON_SPECS_HH */
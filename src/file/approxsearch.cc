@@ -0,0 +1,178 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/approxsearch.cc -- impl for approximate (k-difference) searching
+
+#include "file/approxsearch.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace hexbed {
+
+// how often the scans check whether they should stop
+constexpr bufsize APPROXIMATE_STOP_MASK = 0xFFFF;
+
+ApproximatePattern::ApproximatePattern(const_bytespan needle, bufsize k,
+                                       ApproximateMetric metric)
+    : m_(needle.size()), k_(k), metric_(metric) {
+    if (!m_) throw std::invalid_argument("the needle is empty");
+    if (m_ > MAXIMUM_LENGTH)
+        throw std::invalid_argument("the needle is too long");
+    if (k_ >= m_)
+        throw std::invalid_argument("the needle is too short for k");
+    words_ = (m_ + WORD_BITS - 1) / WORD_BITS;
+    eq_.assign(256 * words_, 0);
+    eqReverse_.assign(256 * words_, 0);
+    for (bufsize i = 0; i < m_; ++i) {
+        Word bit = Word(1) << (i % WORD_BITS);
+        eq_[needle[i] * words_ + i / WORD_BITS] |= bit;
+        eqReverse_[needle[m_ - 1 - i] * words_ + i / WORD_BITS] |= bit;
+    }
+}
+
+void ApproximatePattern::scan(const byte* data, bufsize n, bufsize from,
+                              bufoffset base,
+                              std::vector<ApproximateMatch>& out,
+                              const std::function<bool()>& stop) const {
+    if (metric_ == ApproximateMetric::Edit)
+        scanEdit(data, n, from, base, out, stop);
+    else
+        scanHamming(data, n, from, base, out, stop);
+}
+
+// bit i of r[d] is set if the needle up to i matches the text up to the
+// current byte with at most d substitutions
+void ApproximatePattern::scanHamming(
+    const byte* data, bufsize n, bufsize from, bufoffset base,
+    std::vector<ApproximateMatch>& out,
+    const std::function<bool()>& stop) const {
+    std::size_t W = words_, last = W - 1;
+    Word high = Word(1) << ((m_ - 1) % WORD_BITS);
+    std::vector<Word> r((k_ + 1) * W, 0);
+    for (bufsize j = 0; j < n; ++j) {
+        if (!(j & APPROXIMATE_STOP_MASK) && stop()) return;
+        const Word* eq = &eq_[data[j] * W];
+        // downwards, so that r[d - 1] still has its previous value
+        for (bufsize d = k_ + 1; d-- > 0;) {
+            Word* rd = &r[d * W];
+            Word carry = 1;
+            if (d) {
+                const Word* rp = &r[(d - 1) * W];
+                Word carryp = 1;
+                for (std::size_t w = 0; w < W; ++w) {
+                    Word v = rd[w], p = rp[w];
+                    rd[w] = (((v << 1) | carry) & eq[w]) | (p << 1) | carryp;
+                    carry = v >> (WORD_BITS - 1);
+                    carryp = p >> (WORD_BITS - 1);
+                }
+            } else {
+                for (std::size_t w = 0; w < W; ++w) {
+                    Word v = rd[w];
+                    rd[w] = ((v << 1) | carry) & eq[w];
+                    carry = v >> (WORD_BITS - 1);
+                }
+            }
+        }
+        if (j < from || !(r[k_ * W + last] & high)) continue;
+        bufsize d = 0;
+        while (!(r[d * W + last] & high)) ++d;
+        out.push_back(ApproximateMatch{base + j + 1 - m_, m_, d});
+    }
+}
+
+// one step of Myers' algorithm over a 64-row block, given the horizontal
+// delta coming in at its top and returning the one going out at high
+static inline int myersAdvance(std::uint64_t& pv, std::uint64_t& mv,
+                               std::uint64_t eq, std::uint64_t high,
+                               int hin) noexcept {
+    std::uint64_t xv = eq | mv;
+    if (hin < 0) eq |= 1;
+    std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+    std::uint64_t ph = mv | ~(xh | pv);
+    std::uint64_t mh = pv & xh;
+    int hout = (ph & high) ? 1 : (mh & high) ? -1 : 0;
+    ph <<= 1;
+    mh <<= 1;
+    if (hin < 0)
+        mh |= 1;
+    else if (hin > 0)
+        ph |= 1;
+    pv = mh | ~(xv | ph);
+    mv = ph & xv;
+    return hout;
+}
+
+void ApproximatePattern::scanEdit(const byte* data, bufsize n, bufsize from,
+                                  bufoffset base,
+                                  std::vector<ApproximateMatch>& out,
+                                  const std::function<bool()>& stop) const {
+    std::size_t W = words_, last = W - 1;
+    Word top = Word(1) << (WORD_BITS - 1);
+    Word high = Word(1) << ((m_ - 1) % WORD_BITS);
+    std::vector<Word> pv(W, ~Word(0)), mv(W, 0);
+    bufsize score = m_, bestEnd = 0, best = 0;
+    bool run = false;
+    auto report = [&]() {
+        bufsize z = editLength(data, bestEnd, best);
+        out.push_back(ApproximateMatch{base + bestEnd + 1 - z, z, best});
+    };
+    for (bufsize j = 0; j < n; ++j) {
+        if (!(j & APPROXIMATE_STOP_MASK) && stop()) return;
+        const Word* eq = &eq_[data[j] * W];
+        // the top row is all zeros, since a match may start anywhere
+        int h = 0;
+        for (std::size_t w = 0; w < W; ++w)
+            h = myersAdvance(pv[w], mv[w], eq[w], w == last ? high : top, h);
+        score += h;
+        if (score <= k_ && j >= from) {
+            if (!run || score < best) best = score, bestEnd = j;
+            run = true;
+        } else if (run) {
+            report();
+            run = false;
+        }
+    }
+    if (run) report();
+}
+
+// runs the reversed needle backwards from the end, anchored there, and
+// picks the length closest to that of the needle with the distance
+bufsize ApproximatePattern::editLength(const byte* data, bufsize j,
+                                       bufsize distance) const noexcept {
+    std::size_t W = words_, last = W - 1;
+    Word top = Word(1) << (WORD_BITS - 1);
+    Word high = Word(1) << ((m_ - 1) % WORD_BITS);
+    std::vector<Word> pv(W, ~Word(0)), mv(W, 0);
+    bufsize score = m_, length = 0, diff = SIZE_MAX;
+    bufsize t = 0, tmax = std::min<bufsize>(j + 1, m_ + k_);
+    while (t < tmax) {
+        const Word* eq = &eqReverse_[data[j - t++] * W];
+        // the top row grows by one per byte, since the start is fixed
+        int h = 1;
+        for (std::size_t w = 0; w < W; ++w)
+            h = myersAdvance(pv[w], mv[w], eq[w], w == last ? high : top, h);
+        score += h;
+        bufsize dt = t > m_ ? t - m_ : m_ - t;
+        if (score == distance && dt < diff) length = t, diff = dt;
+    }
+    return length ? length : std::min(m_, j + 1);
+}
+
+};  // namespace hexbed
@@ -0,0 +1,100 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/approxsearch.hh -- header for approximate (k-difference) searching
+
+#ifndef HEXBED_FILE_APPROXSEARCH_HH
+#define HEXBED_FILE_APPROXSEARCH_HH
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "common/types.hh"
+
+namespace hexbed {
+
+enum class ApproximateMetric {
+    // substitutions only
+    Hamming,
+    // substitutions, insertions and deletions
+    Edit
+};
+
+struct ApproximateMatch {
+    bufoffset offset;
+    bufsize length;
+    bufsize distance;
+};
+
+// bit-parallel matching of a needle with at most k differences, with
+// one bit per needle byte: Wu-Manber for Hamming distance and Myers'
+// algorithm for edit distance
+class ApproximatePattern {
+  public:
+    static constexpr bufsize MAXIMUM_LENGTH = 4096;
+
+    // throws std::invalid_argument if the needle is empty, longer than
+    // MAXIMUM_LENGTH or not longer than k
+    ApproximatePattern(const_bytespan needle, bufsize k,
+                       ApproximateMetric metric);
+
+    inline bufsize size() const noexcept { return m_; }
+    inline bufsize maxDistance() const noexcept { return k_; }
+    inline ApproximateMetric metric() const noexcept { return metric_; }
+    // how many bytes before the first end offset a block must start at
+    // to find every match ending there
+    inline bufsize reach() const noexcept {
+        return metric_ == ApproximateMetric::Edit ? m_ + k_ - 1 : m_ - 1;
+    }
+
+    // scans the n bytes at data, which start at document offset base, and
+    // adds the matches that end at or after data + from. a run of
+    // overlapping edit distance matches is reported once, at the best end
+    void scan(const byte* data, bufsize n, bufsize from, bufoffset base,
+              std::vector<ApproximateMatch>& out,
+              const std::function<bool()>& stop) const;
+
+  private:
+    using Word = std::uint64_t;
+    static constexpr unsigned WORD_BITS = 64;
+
+    void scanHamming(const byte* data, bufsize n, bufsize from,
+                     bufoffset base, std::vector<ApproximateMatch>& out,
+                     const std::function<bool()>& stop) const;
+    void scanEdit(const byte* data, bufsize n, bufsize from, bufoffset base,
+                  std::vector<ApproximateMatch>& out,
+                  const std::function<bool()>& stop) const;
+    // length of the best match of the needle ending at data + j
+    bufsize editLength(const byte* data, bufsize j,
+                       bufsize distance) const noexcept;
+
+    bufsize m_;
+    bufsize k_;
+    ApproximateMetric metric_;
+    std::size_t words_;
+    // bit i of word i / 64 is set in eq_[c] if needle[i] == c, and in
+    // eqReverse_[c] if needle[m - 1 - i] == c
+    std::vector<Word> eq_;
+    std::vector<Word> eqReverse_;
+};
+
+};  // namespace hexbed
+
+#endif /* HEXBED_FILE_APPROXSEARCH_HH */
@@ -166,11 +166,11 @@ static bufsize ftell_massive_(std::FILE* f) {
     }
 }
 
-static int fseekto_massive(std::FILE* f, bufsize o) {
+int fseekto_massive(std::FILE* f, bufsize o) {
     return fseekto_massive_<int>(f, o);
 }
 
-static bufsize ftell_massive(std::FILE* f) { return ftell_massive_<int>(f); }
+bufsize ftell_massive(std::FILE* f) { return ftell_massive_<int>(f); }
 
 static bufsize fcopy(std::FILE* wf, std::FILE* rf, bufsize n) {
     byte buf[BUFSIZ];
@@ -405,4 +405,10 @@ void HexBedBufferFile::writeCopy(HexBedContext& ctx, WriteCallback write,
 
 bufsize HexBedBufferFile::size() const noexcept { return sz_; }
 
+bufsize HexBedBufferFile::refresh() {
+    if (!f_) throw system_io_error("file is closed");
+    updateSize();
+    return sz_;
+}
+
 };  // namespace hexbed
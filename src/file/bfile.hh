@@ -50,6 +50,9 @@ FILE_unique_ptr freopen_unique(const pathstring& filename, const char* mode,
 FILE_unique_ptr freopen_unique(const std::filesystem::path& filename,
                                const char* mode, FILE_unique_ptr& fp);
 
+int fseekto_massive(std::FILE* f, bufsize o);
+bufsize ftell_massive(std::FILE* f);
+
 FILE_unique_ptr fopen_replace_before(const std::filesystem::path& filename,
                                      std::filesystem::path& tempfilename,
                                      bool backup);
@@ -71,6 +74,7 @@ class HexBedBufferFile : public HexBedBuffer {
                    const std::filesystem::path& filename);
     // bufsize size() noexcept;
     bufsize size() const noexcept;
+    bufsize refresh();
 
   private:
     bufsize sz_;
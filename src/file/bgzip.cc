@@ -0,0 +1,423 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/bgzip.cc -- impl for the gzip file buffer class
+
+#include "file/bgzip.hh"
+
+#if HAS_ZLIB
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <new>
+
+#include "common/buffer.hh"
+#include "common/error.hh"
+#include "common/logger.hh"
+#include "common/memory.hh"
+
+namespace hexbed {
+
+static constexpr bufsize GZIP_CHUNK = 65536;
+static constexpr char GZIP_INDEX_MAGIC[8] = {'H', 'B', 'G', 'Z',
+                                             'I', 'D', 'X', '1'};
+// gzip or zlib header, detected automatically
+static constexpr int GZIP_WBITS_HEADER = 15 + 32;
+// raw deflate data
+static constexpr int GZIP_WBITS_RAW = -15;
+// size of the gzip member trailer (CRC-32 and ISIZE)
+static constexpr bufsize GZIP_TRAILER = 8;
+
+[[noreturn]] static void throwZlibError(int ret, const z_stream& strm) {
+    if (ret == Z_MEM_ERROR) throw std::bad_alloc();
+    throw system_io_error(strm.msg ? strm.msg
+                                   : "invalid or corrupted compressed data");
+}
+
+struct InflateGuard {
+    z_stream& strm;
+    ~InflateGuard() { inflateEnd(&strm); }
+};
+
+bool isGzipFile(const std::filesystem::path& filename) {
+    FILE_unique_ptr f = fopen_unique(filename, "rb");
+    if (!f) return false;
+    byte magic[2];
+    return std::fread(magic, 1, sizeof(magic), f.get()) == sizeof(magic) &&
+           magic[0] == 0x1F && magic[1] == 0x8B;
+}
+
+std::filesystem::path getGzipIndexFilename(std::filesystem::path fn) {
+    fn += pathstring(".hbidx");
+    return fn;
+}
+
+HexBedBufferGzip::HexBedBufferGzip(HexBedContext& ctx,
+                                   const std::filesystem::path& filename)
+    : filename_(filename),
+      f_((errno = 0, fopen_unique(filename, "rb"))),
+      strm_{},
+      inbuf_(std::make_unique<byte[]>(GZIP_CHUNK)),
+      cache_(std::make_unique<byte[]>(GZIP_CACHE)) {
+    if (!f_) throw errno_to_exception(errno);
+    errno = 0;
+    if (std::fseek(f_.get(), 0, SEEK_END)) throw errno_to_exception(errno);
+    insz_ = ftell_massive(f_.get());
+    std::filesystem::path idxfn = getGzipIndexFilename(filename);
+    if (!loadIndex(idxfn)) {
+        HexBedTask task(&ctx, insz_, true);
+        task.run([this](HexBedTask& task) { buildIndex(task); });
+        if (task.isCancelled())
+            throw system_io_error("indexing the compressed file was cancelled");
+        // small files are quick enough to index every time
+        if (insz_ >= GZIP_INDEX_SPAN) saveIndex(idxfn);
+    }
+    int ret = inflateInit2(&strm_, GZIP_WBITS_HEADER);
+    if (ret != Z_OK) throwZlibError(ret, strm_);
+}
+
+HexBedBufferGzip::~HexBedBufferGzip() noexcept { inflateEnd(&strm_); }
+
+void HexBedBufferGzip::buildIndex(HexBedTask& task) {
+    z_stream strm{};
+    int ret = inflateInit2(&strm, GZIP_WBITS_HEADER);
+    if (ret != Z_OK) throwZlibError(ret, strm);
+    InflateGuard guard{strm};
+    auto window = std::make_unique<byte[]>(GZIP_WINDOW);
+    byte* input = inbuf_.get();
+    bufsize totin = 0, totout = 0, last = 0;
+    std::FILE* f = f_.get();
+
+    index_.clear();
+    index_.push_back(GzipAccessPoint{0, 0, 0, true, {}});
+    errno = 0;
+    if (std::fseek(f, 0, SEEK_SET)) throw errno_to_exception(errno);
+    auto refill = [&strm, input, f, &task, &totin]() -> bool {
+        errno = 0;
+        strm.avail_in = std::fread(input, 1, GZIP_CHUNK, f);
+        if (std::ferror(f)) throw errno_to_exception(errno);
+        strm.next_in = input;
+        task.progress(totin + strm.avail_in);
+        return strm.avail_in > 0;
+    };
+
+    for (;;) {
+        if (task.isCancelled()) return;
+        if (!strm.avail_in && !refill())
+            throw system_io_error("unexpected end of compressed data");
+        if (!strm.avail_out) {
+            strm.avail_out = GZIP_WINDOW;
+            strm.next_out = window.get();
+        }
+        totin += strm.avail_in;
+        totout += strm.avail_out;
+        ret = inflate(&strm, Z_BLOCK);
+        totin -= strm.avail_in;
+        totout -= strm.avail_out;
+        if (ret == Z_NEED_DICT) ret = Z_DATA_ERROR;
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+            throwZlibError(ret, strm);
+        if (ret == Z_STREAM_END) {
+            // another gzip member may follow; anything else is ignored
+            if (!strm.avail_in && !refill()) break;
+            if (strm.next_in[0] != 0x1F) break;
+            inflateReset(&strm);
+            index_.push_back(GzipAccessPoint{totout, totin, 0, true, {}});
+            last = totout;
+            continue;
+        }
+        // at a block boundary that isn't the last one
+        if ((strm.data_type & 128) && !(strm.data_type & 64) &&
+            totout - last > GZIP_INDEX_SPAN) {
+            GzipAccessPoint point{totout, totin, strm.data_type & 7, false,
+                                  std::vector<byte>(GZIP_WINDOW)};
+            bufsize left = strm.avail_out;
+            byte* w = point.window.data();
+            if (left) memCopy(w, window.get() + GZIP_WINDOW - left, left);
+            if (left < GZIP_WINDOW)
+                memCopy(w + left, window.get(), GZIP_WINDOW - left);
+            index_.push_back(std::move(point));
+            last = totout;
+        }
+    }
+    sz_ = totout;
+}
+
+template <typename T>
+static void putRaw(std::ostream& os, const T& v) {
+    os.write(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+template <typename T>
+static bool getRaw(std::istream& is, T& v) {
+    return static_cast<bool>(is.read(reinterpret_cast<char*>(&v), sizeof(v)));
+}
+
+static std::int64_t getModifiedTime(const std::filesystem::path& fn) {
+    std::error_code ec;
+    auto t = std::filesystem::last_write_time(fn, ec);
+    return ec ? 0 : static_cast<std::int64_t>(t.time_since_epoch().count());
+}
+
+bool HexBedBufferGzip::loadIndex(const std::filesystem::path& fn) {
+    std::ifstream is(fn, std::ios::binary);
+    if (!is) return false;
+    char magic[sizeof(GZIP_INDEX_MAGIC)];
+    std::uint64_t insz, span, sz, n;
+    std::int64_t mtime;
+    if (!is.read(magic, sizeof(magic)) ||
+        !std::equal(magic, magic + sizeof(magic), GZIP_INDEX_MAGIC) ||
+        !getRaw(is, insz) || !getRaw(is, mtime) || !getRaw(is, span) ||
+        !getRaw(is, sz) || !getRaw(is, n))
+        return false;
+    if (insz != insz_ || mtime != getModifiedTime(filename_) ||
+        span != GZIP_INDEX_SPAN || !n)
+        return false;
+    std::vector<GzipAccessPoint> index;
+    for (std::uint64_t i = 0; i < n; ++i) {
+        std::uint64_t out, in;
+        std::uint8_t bits, member;
+        if (!getRaw(is, out) || !getRaw(is, in) || !getRaw(is, bits) ||
+            !getRaw(is, member) || bits > 7 || out > sz || in > insz)
+            return false;
+        // seek() relies on the access points being in order
+        if (!index.empty() &&
+            (out < index.back().out || in < index.back().in))
+            return false;
+        GzipAccessPoint point{out, in, bits, member != 0, {}};
+        if (!member) {
+            point.window.resize(GZIP_WINDOW);
+            if (!is.read(reinterpret_cast<char*>(point.window.data()),
+                         GZIP_WINDOW))
+                return false;
+        }
+        index.push_back(std::move(point));
+    }
+    if (index.front().out) return false;
+    index_ = std::move(index);
+    sz_ = sz;
+    LOG_DEBUG("loaded gzip index with %zu access points", index_.size());
+    return true;
+}
+
+void HexBedBufferGzip::saveIndex(const std::filesystem::path& fn) {
+    {
+        std::ofstream os(fn, std::ios::binary | std::ios::trunc);
+        if (os) {
+            os.write(GZIP_INDEX_MAGIC, sizeof(GZIP_INDEX_MAGIC));
+            putRaw<std::uint64_t>(os, insz_);
+            putRaw<std::int64_t>(os, getModifiedTime(filename_));
+            putRaw<std::uint64_t>(os, GZIP_INDEX_SPAN);
+            putRaw<std::uint64_t>(os, sz_);
+            putRaw<std::uint64_t>(os, index_.size());
+            for (const GzipAccessPoint& point : index_) {
+                putRaw<std::uint64_t>(os, point.out);
+                putRaw<std::uint64_t>(os, point.in);
+                putRaw<std::uint8_t>(os, point.bits);
+                putRaw<std::uint8_t>(os, point.member ? 1 : 0);
+                if (!point.member)
+                    os.write(reinterpret_cast<const char*>(point.window.data()),
+                             GZIP_WINDOW);
+            }
+            if (os.flush()) return;
+        }
+    }
+    LOG_WARN("could not save gzip index");
+    std::error_code ec;
+    std::filesystem::remove(fn, ec);
+}
+
+void HexBedBufferGzip::resetStream(int windowBits) {
+    int ret = inflateReset2(&strm_, windowBits);
+    if (ret != Z_OK) throwZlibError(ret, strm_);
+}
+
+void HexBedBufferGzip::seek(bufsize offset) {
+    auto after = [](bufsize o, const GzipAccessPoint& p) { return o < p.out; };
+    if (active_ && offset >= cur_) {
+        // keep decompressing if there is no access point in between
+        auto it = std::upper_bound(index_.begin(), index_.end(), cur_, after);
+        if (it == index_.end() || it->out > offset) {
+            if (offset > cur_) inflateInto(nullptr, offset - cur_);
+            return;
+        }
+    }
+    auto it = std::upper_bound(index_.begin(), index_.end(), offset, after);
+    HEXBED_ASSERT(it != index_.begin());
+    const GzipAccessPoint& point = *--it;
+    active_ = false;
+    errno = 0;
+    if (fseekto_massive(f_.get(), point.bits ? point.in - 1 : point.in))
+        throw errno_to_exception(errno);
+    strm_.avail_in = 0;
+    resetStream(point.member ? GZIP_WBITS_HEADER : GZIP_WBITS_RAW);
+    if (point.bits) {
+        int c = std::fgetc(f_.get());
+        if (c == EOF) throw system_io_error("unexpected end of compressed data");
+        inflatePrime(&strm_, point.bits, c >> (8 - point.bits));
+    }
+    if (!point.member)
+        inflateSetDictionary(&strm_, point.window.data(), GZIP_WINDOW);
+    cur_ = point.out;
+    eof_ = false;
+    raw_ = !point.member;
+    skip_ = 0;
+    active_ = true;
+    if (offset > cur_) inflateInto(nullptr, offset - cur_);
+}
+
+bufsize HexBedBufferGzip::inflateInto(byte* out, bufsize n) {
+    byte scratch[BUFFER_SIZE];
+    bufsize done = 0;
+    while (done < n && !eof_) {
+        if (!strm_.avail_in) {
+            errno = 0;
+            strm_.avail_in = std::fread(inbuf_.get(), 1, GZIP_CHUNK, f_.get());
+            if (std::ferror(f_.get())) throw errno_to_exception(errno);
+            if (!strm_.avail_in) {
+                eof_ = true;
+                break;
+            }
+            strm_.next_in = inbuf_.get();
+        }
+        if (skip_) {
+            bufsize z = std::min<bufsize>(skip_, strm_.avail_in);
+            strm_.next_in += z;
+            strm_.avail_in -= z;
+            skip_ -= z;
+            continue;
+        }
+        bufsize want = std::min<bufsize>(n - done, UINT_MAX);
+        if (out) {
+            strm_.next_out = out + done;
+        } else {
+            strm_.next_out = scratch;
+            want = std::min<bufsize>(want, sizeof(scratch));
+        }
+        strm_.avail_out = want;
+        int ret = inflate(&strm_, Z_NO_FLUSH);
+        bufsize got = want - strm_.avail_out;
+        done += got;
+        cur_ += got;
+        if (ret == Z_STREAM_END) {
+            if (cur_ >= sz_) {
+                eof_ = true;
+            } else {
+                // raw deflate leaves the trailer of the member unread
+                if (raw_) skip_ = GZIP_TRAILER;
+                raw_ = false;
+                resetStream(GZIP_WBITS_HEADER);
+            }
+        } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            active_ = false;
+            throwZlibError(ret == Z_NEED_DICT ? Z_DATA_ERROR : ret, strm_);
+        }
+    }
+    return done;
+}
+
+void HexBedBufferGzip::fillCache(bufsize offset) {
+    bufsize base = offset - offset % GZIP_CACHE;
+    cacheLen_ = 0;
+    seek(base);
+    cacheOff_ = base;
+    cacheLen_ =
+        inflateInto(cache_.get(), std::min<bufsize>(GZIP_CACHE, sz_ - base));
+}
+
+bufsize HexBedBufferGzip::read(bufoffset offset, bytespan data) {
+    if (!f_) throw system_io_error("file is closed");
+    if (offset >= sz_) return 0;
+    bufsize n = std::min<bufsize>(data.size(), sz_ - offset), done = 0;
+    while (done < n) {
+        bufsize o = offset + done;
+        if (o < cacheOff_ || o >= cacheOff_ + cacheLen_) fillCache(o);
+        if (o >= cacheOff_ + cacheLen_) break;
+        bufsize k = std::min<bufsize>(n - done, cacheOff_ + cacheLen_ - o);
+        memCopy(data.data() + done, cache_.get() + (o - cacheOff_), k);
+        done += k;
+    }
+    return done;
+}
+
+class HexBedBufferGzipVbuf : public VirtualBuffer {
+  public:
+    HexBedBufferGzipVbuf(HexBedBuffer& buf, std::FILE* wf)
+        : buf_(buf), wf_(wf) {}
+    void raw(bufsize n, const byte* r) {
+        errno = 0;
+        if (!std::fwrite(r, n, 1, wf_)) throw errno_to_exception(errno);
+    }
+    void copy(bufsize n, bufsize o) {
+        byte tmp[BUFFER_SIZE];
+        while (n) {
+            bufsize r = buf_.read(o, bytespan(tmp, std::min<bufsize>(n, sizeof(tmp))));
+            if (!r) throw system_io_error("unexpected end of compressed data");
+            raw(r, tmp);
+            o += r, n -= r;
+        }
+    }
+
+  private:
+    HexBedBuffer& buf_;
+    std::FILE* wf_;
+};
+
+void HexBedBufferGzip::write(HexBedContext& ctx, WriteCallback write,
+                             const std::filesystem::path& filename) {
+    throw system_io_error("compressed files cannot be saved in place");
+}
+
+void HexBedBufferGzip::writeOverlay(HexBedContext& ctx, WriteCallback write,
+                                    const std::filesystem::path& filename) {
+    throw system_io_error("compressed files cannot be saved in place");
+}
+
+void HexBedBufferGzip::writeNew(HexBedContext& ctx, WriteCallback write,
+                                const std::filesystem::path& filename) {
+    if (!f_) throw system_io_error("file is closed");
+    if (filename == filename_)
+        throw system_io_error("compressed files cannot be saved in place");
+    if (ctx.shouldBackup()) makeBackupOf(ctx, filename);
+    errno = 0;
+    auto fp = fopen_unique(filename, "wb");
+    if (!fp) throw errno_to_exception(errno);
+
+    HexBedBufferGzipVbuf vbuf(*this, fp.get());
+    write(vbuf);
+
+    errno = 0;
+    if (std::fflush(fp.get())) throw errno_to_exception(errno);
+}
+
+void HexBedBufferGzip::writeCopy(HexBedContext& ctx, WriteCallback write,
+                                 const std::filesystem::path& filename) {
+    writeNew(ctx, write, filename);
+}
+
+bufsize HexBedBufferGzip::size() const noexcept { return sz_; }
+
+bool HexBedBufferGzip::readOnly() const noexcept { return true; }
+
+};  // namespace hexbed
+
+#endif /* HAS_ZLIB */
@@ -0,0 +1,113 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/bgzip.hh -- header for the gzip file buffer class
+
+#ifndef HEXBED_FILE_BGZIP_HH
+#define HEXBED_FILE_BGZIP_HH
+
+#if HAS_ZLIB
+
+#include <zlib.h>
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "file/bfile.hh"
+#include "file/context.hh"
+#include "file/document.hh"
+#include "file/task.hh"
+
+namespace hexbed {
+
+// how much decompressed data there is at most between access points
+constexpr bufsize GZIP_INDEX_SPAN = 4UL << 20;
+// size of a deflate window
+constexpr bufsize GZIP_WINDOW = 32768;
+// how much decompressed data is kept around for reads, aligned to its size
+constexpr bufsize GZIP_CACHE = 1UL << 20;
+
+struct GzipAccessPoint {
+    // offset in decompressed data
+    bufsize out;
+    // offset in compressed data
+    bufsize in;
+    // if nonzero, this many bits of the byte at in - 1 must be primed
+    int bits;
+    // a new gzip member begins at this point; no window is needed
+    bool member;
+    std::vector<byte> window;
+};
+
+bool isGzipFile(const std::filesystem::path& filename);
+std::filesystem::path getGzipIndexFilename(std::filesystem::path fn);
+
+class HexBedBufferGzip : public HexBedBuffer {
+  public:
+    HexBedBufferGzip(HexBedContext& ctx, const std::filesystem::path& filename);
+    ~HexBedBufferGzip() noexcept;
+    bufsize read(bufoffset offset, bytespan data);
+    void write(HexBedContext& ctx, WriteCallback write,
+               const std::filesystem::path& filename);
+    void writeOverlay(HexBedContext& ctx, WriteCallback write,
+                      const std::filesystem::path& filename);
+    void writeNew(HexBedContext& ctx, WriteCallback write,
+                  const std::filesystem::path& filename);
+    void writeCopy(HexBedContext& ctx, WriteCallback write,
+                   const std::filesystem::path& filename);
+    bufsize size() const noexcept;
+    bool readOnly() const noexcept;
+
+  private:
+    std::filesystem::path filename_;
+    FILE_unique_ptr f_;
+    bufsize sz_{0};
+    bufsize insz_{0};
+    std::vector<GzipAccessPoint> index_;
+    z_stream strm_;
+    bool active_{false};
+    bool eof_{false};
+    // true if positioned within a raw deflate stream
+    bool raw_{false};
+    // bytes of input to skip before inflating more
+    bufsize skip_{0};
+    // decompressed offset the stream is positioned at
+    bufsize cur_{0};
+    std::unique_ptr<byte[]> inbuf_;
+    // recently decompressed data, so that reads going backwards do not
+    // inflate again from the access point every time
+    std::unique_ptr<byte[]> cache_;
+    bufsize cacheOff_{0};
+    bufsize cacheLen_{0};
+
+    void buildIndex(HexBedTask& task);
+    bool loadIndex(const std::filesystem::path& fn);
+    void saveIndex(const std::filesystem::path& fn);
+    void seek(bufsize offset);
+    bufsize inflateInto(byte* out, bufsize n);
+    void fillCache(bufsize offset);
+    void resetStream(int windowBits);
+};
+
+};  // namespace hexbed
+
+#endif /* HAS_ZLIB */
+
+#endif /* HEXBED_FILE_BGZIP_HH */
@@ -0,0 +1,179 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/bitsearch.cc -- impl for bit-aligned pattern search
+
+#include "file/bitsearch.hh"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+#include "file/document.hh"
+#include "file/search.hh"
+
+namespace hexbed {
+
+bool bitsFromString(std::vector<bool>& bits, const string& text) {
+    bits.clear();
+    for (strchar c : text) {
+        if (c == '0' || c == '1')
+            bits.push_back(c == '1');
+        else if (c != ' ' && c != '_')
+            return false;
+    }
+    return !bits.empty();
+}
+
+// every shift gets its own masked pattern, so that each can be found with
+// the same paired-byte filter as wildcard searches
+BitPattern::BitPattern(const std::vector<bool>& bits) : length_(bits.size()) {
+    if (!length_) throw std::invalid_argument("empty bit pattern");
+    if (length_ > MAXIMUM_LENGTH)
+        throw std::invalid_argument("bit pattern too long");
+    for (unsigned s = 0; s < 8; ++s) {
+        bufsize z = (s + length_ + 7) / 8;
+        std::vector<byte> value(z), mask(z);
+        for (bufsize i = 0; i < length_; ++i) {
+            bufsize b = s + i;
+            byte m = static_cast<byte>(0x80U >> (b % 8));
+            mask[b / 8] |= m;
+            if (bits[i]) value[b / 8] |= m;
+        }
+        variants_[s] = MaskedPattern(std::move(value), std::move(mask));
+    }
+}
+
+// byte offsets [lo, hi) at which a match of the given shift lies within
+// the bits [start, end)
+static void bitShiftRange(const BitPattern& pattern, unsigned s,
+                          bufsize start, bufsize end, bufsize& lo,
+                          bufsize& hi) {
+    bufsize n = pattern.length();
+    lo = start > s ? (start - s + 7) / 8 : 0;
+    hi = end >= s + n ? (end - s - n) / 8 + 1 : 0;
+}
+
+// as in searchForwardMasked, windows overlap by span() - 1 bytes. only the
+// last window may report matches past that overlap, since a match with a
+// longer variant could be found before them in the next window
+BitSearchResult searchForwardBits(HexBedTask& task,
+                                  const HexBedDocument& document,
+                                  bufsize start, bufsize end,
+                                  const BitPattern& pattern) {
+    bufsize z = pattern.span(), c = getPreferredSearchBufferSize(z), r, rr;
+    if (start >= end || end - start < pattern.length())
+        return BitSearchResult{};
+    bufsize o = start / 8, e = (end + 7) / 8;
+    std::unique_ptr<byte[]> buffer = std::make_unique<byte[]>(c);
+    byte* bp = buffer.get();
+    while ((rr = std::min(e - o, c)) &&
+           (r = document.read(o, bytespan(bp, rr)))) {
+        if (task.isCancelled()) break;
+        bool last = r < rr || o + r >= e;
+        BitSearchResult res{};
+        for (unsigned s = 0; s < 8; ++s) {
+            const MaskedPattern& variant = pattern.variant(s);
+            bufsize lo, hi, zz = last ? variant.size() : z;
+            if (r < zz) continue;
+            bitShiftRange(pattern, s, start, end, lo, hi);
+            lo = std::max(lo, o);
+            hi = std::min(hi, o + r - zz + 1);
+            if (res) hi = std::min(hi, res.offset);
+            if (lo >= hi) continue;
+            const byte* p =
+                findMaskedForward(bp + (lo - o), bp + (hi - o), variant);
+            if (p) res = BitSearchResult{true, o + (p - bp), s};
+        }
+        if (res || last) return res;
+        o += r - z + 1;
+    }
+    return BitSearchResult{};
+}
+
+BitSearchResult searchBackwardBits(HexBedTask& task,
+                                   const HexBedDocument& document,
+                                   bufsize start, bufsize end,
+                                   const BitPattern& pattern) {
+    bufsize z = pattern.span(), c = getPreferredSearchBufferSize(z), r;
+    if (start >= end || end - start < pattern.length())
+        return BitSearchResult{};
+    bufsize lo = start / 8, hi = (end + 7) / 8;
+    std::unique_ptr<byte[]> buffer = std::make_unique<byte[]>(c);
+    byte* bp = buffer.get();
+    while (hi > lo) {
+        bufsize wlo = hi - lo > c ? hi - c : lo;
+        if ((r = document.read(wlo, bytespan(bp, hi - wlo))) < hi - wlo)
+            break;
+        if (task.isCancelled()) break;
+        BitSearchResult res{};
+        for (unsigned s = 0; s < 8; ++s) {
+            const MaskedPattern& variant = pattern.variant(s);
+            bufsize slo, shi;
+            if (r < variant.size()) continue;
+            bitShiftRange(pattern, s, start, end, slo, shi);
+            slo = std::max(slo, wlo);
+            if (res) slo = std::max(slo, res.offset);
+            shi = std::min(shi, hi - variant.size() + 1);
+            if (slo >= shi) continue;
+            const byte* p =
+                findMaskedBackward(bp + (slo - wlo), bp + (shi - wlo), variant);
+            if (p) res = BitSearchResult{true, wlo + (p - bp), s};
+        }
+        if (res) return res;
+        if (wlo == lo) break;
+        hi = wlo + z - 1;
+    }
+    return BitSearchResult{};
+}
+
+void searchAllBits(HexBedTask& task, const HexBedDocument& document,
+                   bufsize start, bufsize end, const BitPattern& pattern,
+                   const BitPattern::Callback& found) {
+    bufsize z = pattern.span(), c = getPreferredSearchBufferSize(z), r, rr;
+    if (start >= end || end - start < pattern.length()) return;
+    bufsize o = start / 8, e = (end + 7) / 8;
+    std::unique_ptr<byte[]> buffer = std::make_unique<byte[]>(c);
+    byte* bp = buffer.get();
+    std::vector<bufsize> bits;
+    while ((rr = std::min(e - o, c)) &&
+           (r = document.read(o, bytespan(bp, rr)))) {
+        if (task.isCancelled()) break;
+        bool last = r < rr || o + r >= e;
+        bits.clear();
+        for (unsigned s = 0; s < 8; ++s) {
+            const MaskedPattern& variant = pattern.variant(s);
+            bufsize lo, hi, zz = last ? variant.size() : z;
+            if (r < zz) continue;
+            bitShiftRange(pattern, s, start, end, lo, hi);
+            lo = std::max(lo, o);
+            hi = std::min(hi, o + r - zz + 1);
+            if (lo >= hi) continue;
+            const byte* p = bp + (lo - o);
+            while ((p = findMaskedForward(p, bp + (hi - o), variant)))
+                bits.push_back((o + (p++ - bp)) * 8 + s);
+        }
+        std::sort(bits.begin(), bits.end());
+        for (bufsize b : bits) found(b / 8, static_cast<unsigned>(b % 8));
+        if (last) break;
+        o += r - z + 1;
+    }
+}
+
+};  // namespace hexbed
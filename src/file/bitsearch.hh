@@ -0,0 +1,84 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/bitsearch.hh -- header for bit-aligned pattern search
+
+#ifndef HEXBED_FILE_BITSEARCH_HH
+#define HEXBED_FILE_BITSEARCH_HH
+
+#include <functional>
+#include <vector>
+
+#include "common/types.hh"
+#include "file/document-fwd.hh"
+#include "file/masksearch.hh"
+#include "file/task.hh"
+
+namespace hexbed {
+
+// bits are numbered from the most significant bit of the first byte, so
+// that bit b is in byte b / 8 with a shift of b % 8
+bool bitsFromString(std::vector<bool>& bits, const string& text);
+
+class BitPattern {
+  public:
+    static constexpr bufsize MAXIMUM_LENGTH = 65536;
+    using Callback = std::function<void(bufoffset offset, unsigned shift)>;
+
+    explicit BitPattern(const std::vector<bool>& bits);
+
+    inline bufsize length() const noexcept { return length_; }
+    // the most bytes that a match can cover
+    inline bufsize span() const noexcept { return variants_[7].size(); }
+    // the pattern as it lies when it starts shift bits into a byte
+    inline const MaskedPattern& variant(unsigned shift) const noexcept {
+        return variants_[shift];
+    }
+
+  private:
+    bufsize length_;
+    MaskedPattern variants_[8];
+};
+
+struct BitSearchResult {
+    bool found{false};
+    bufoffset offset{0};
+    unsigned shift{0};
+
+    inline operator bool() const noexcept { return found; }
+};
+
+// start and end are bit positions; matches lie wholly within [start, end)
+BitSearchResult searchForwardBits(HexBedTask& task,
+                                  const HexBedDocument& document,
+                                  bufsize start, bufsize end,
+                                  const BitPattern& pattern);
+BitSearchResult searchBackwardBits(HexBedTask& task,
+                                   const HexBedDocument& document,
+                                   bufsize start, bufsize end,
+                                   const BitPattern& pattern);
+// calls found for every match within [start, end) in ascending order of
+// bit position. matches may overlap
+void searchAllBits(HexBedTask& task, const HexBedDocument& document,
+                   bufsize start, bufsize end, const BitPattern& pattern,
+                   const BitPattern::Callback& found);
+
+};  // namespace hexbed
+
+#endif /* HEXBED_FILE_BITSEARCH_HH */
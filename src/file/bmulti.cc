@@ -0,0 +1,279 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/bmulti.cc -- impl for the concatenated multi-file document buffer
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "file/bmulti.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "common/buffer.hh"
+#include "common/error.hh"
+#include "common/logger.hh"
+
+#if defined(_POSIX_VERSION)
+#include <sys/types.h>
+#include <unistd.h>
+#define HAVE_TRUNCATE 1
+#else
+#define HAVE_TRUNCATE 0
+#endif
+
+namespace hexbed {
+
+std::vector<std::filesystem::path> findSplitParts(
+    const std::filesystem::path& filename) {
+    std::vector<std::filesystem::path> parts;
+    pathstring ext = filename.extension().native();
+    // ".001", ".0001", ...
+    if (ext.size() < 4) return parts;
+    std::size_t width = ext.size() - 1;
+    for (std::size_t i = 1; i < ext.size(); ++i)
+        if (ext[i] < '0' || ext[i] > '9') return parts;
+    if (std::stoull(filename.extension().string().substr(1)) != 1)
+        return parts;
+
+    std::filesystem::path stem = filename;
+    stem.replace_extension();
+    for (unsigned long long i = 1;; ++i) {
+        std::string num = std::to_string(i);
+        if (num.size() > width) break;
+        num.insert(0, width - num.size(), '0');
+        std::filesystem::path part = stem;
+        part += "." + num;
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(part, ec)) break;
+        parts.push_back(std::move(part));
+    }
+    if (parts.size() < 2) parts.clear();
+    return parts;
+}
+
+HexBedBufferMulti::HexBedBufferMulti(
+    const std::vector<std::filesystem::path>& parts) {
+    if (parts.empty()) throw std::invalid_argument("no files given");
+    parts_.reserve(parts.size());
+    for (const std::filesystem::path& path : parts) {
+        errno = 0;
+        FILE_unique_ptr f = fopen_unique(path, "rb");
+        if (!f) throw errno_to_exception(errno);
+        errno = 0;
+        if (std::fseek(f.get(), 0, SEEK_END)) throw errno_to_exception(errno);
+        bufsize n = ftell_massive(f.get());
+        if (n == BUFSIZE_MAX) throw errno_to_exception(errno);
+        parts_.push_back(Part{path, std::move(f), sz_, n});
+        sz_ += n;
+    }
+}
+
+std::size_t HexBedBufferMulti::partAt(bufoffset offset) const noexcept {
+    auto it = std::upper_bound(
+        parts_.begin(), parts_.end(), offset,
+        [](bufoffset o, const Part& part) { return o < part.offset; });
+    return static_cast<std::size_t>(it - parts_.begin()) - 1;
+}
+
+bufsize HexBedBufferMulti::read(bufoffset offset, bytespan data) {
+    bufsize o = 0, n = data.size();
+    if (offset >= sz_) return 0;
+    for (std::size_t i = partAt(offset); n && i < parts_.size(); ++i) {
+        Part& part = parts_[i];
+        if (!part.f) throw system_io_error("file is closed");
+        bufsize p = offset + o - part.offset;
+        if (p >= part.size) continue;
+        bufsize c = std::min<bufsize>(n, part.size - p);
+        errno = 0;
+        if (fseekto_massive(part.f.get(), p)) throw errno_to_exception(errno);
+        bufsize r = std::fread(data.data() + o, 1, c, part.f.get());
+        if (r < c && std::ferror(part.f.get()))
+            throw errno_to_exception(errno);
+        o += r, n -= r;
+        if (r < c) break;
+    }
+    return o;
+}
+
+// splits a linear output stream across the parts at their old boundaries
+class HexBedBufferMultiVbuf : public VirtualBuffer {
+  public:
+    HexBedBufferMultiVbuf(HexBedBuffer& src,
+                          const std::vector<HexBedBufferMulti::Part>& parts,
+                          const std::vector<std::FILE*>& outs, bool overlay)
+        : src_(src), parts_(parts), outs_(outs), overlay_(overlay) {}
+    void raw(bufsize n, const byte* r) {
+        while (n) {
+            std::size_t k = seekPart();
+            bufsize c = std::min<bufsize>(n, room(k));
+            std::FILE* f = outs_[k];
+            errno = 0;
+            if (overlay_ &&
+                fseekto_massive(f, pos_ - parts_[k].offset))
+                throw errno_to_exception(errno);
+            if (!std::fwrite(r, c, 1, f)) throw errno_to_exception(errno);
+            r += c, n -= c, pos_ += c;
+        }
+    }
+    void copy(bufsize n, bufsize o) {
+        if (overlay_) {
+            HEXBED_ASSERT(pos_ == o);
+            pos_ += n;
+            return;
+        }
+        byte tmp[BUFFER_SIZE];
+        while (n) {
+            bufsize r = src_.read(
+                o, bytespan(tmp, std::min<bufsize>(n, sizeof(tmp))));
+            if (!r) throw system_io_error("unexpected end of file");
+            raw(r, tmp);
+            o += r, n -= r;
+        }
+    }
+    bufsize position() const noexcept { return pos_; }
+
+  private:
+    HexBedBuffer& src_;
+    const std::vector<HexBedBufferMulti::Part>& parts_;
+    const std::vector<std::FILE*>& outs_;
+    bool overlay_;
+    std::size_t part_{0};
+    bufsize pos_{0};
+
+    bufsize room(std::size_t k) const noexcept {
+        if (k + 1 == parts_.size()) return BUFSIZE_MAX;
+        bufsize end = parts_[k].offset + parts_[k].size;
+        return pos_ < end ? end - pos_ : 0;
+    }
+    std::size_t seekPart() noexcept {
+        while (!room(part_)) ++part_;
+        return part_;
+    }
+};
+
+void HexBedBufferMulti::write(HexBedContext& ctx, WriteCallback write,
+                              const std::filesystem::path& filename) {
+    bool backup = ctx.shouldBackup();
+    std::vector<FILE_unique_ptr> fps;
+    std::vector<std::filesystem::path> tmpfns;
+    std::vector<std::FILE*> outs;
+    fps.reserve(parts_.size());
+    tmpfns.reserve(parts_.size());
+    outs.reserve(parts_.size());
+    try {
+        for (const Part& part : parts_) {
+            if (!part.f) throw system_io_error("file is closed");
+            std::filesystem::path& tmpfn = tmpfns.emplace_back();
+            fps.push_back(fopen_replace_before(part.path, tmpfn, backup));
+            outs.push_back(fps.back().get());
+        }
+
+        HexBedBufferMultiVbuf vbuf(*this, parts_, outs, false);
+        write(vbuf);
+
+        for (FILE_unique_ptr& fp : fps) {
+            errno = 0;
+            if (std::fflush(fp.get())) throw errno_to_exception(errno);
+        }
+    } catch (...) {
+        // do not leave temporary files lying around
+        fps.clear();
+        for (std::size_t i = 0; i < tmpfns.size(); ++i) {
+            std::error_code ec;
+            if (tmpfns[i] != parts_[i].path)
+                std::filesystem::remove(tmpfns[i], ec);
+        }
+        throw;
+    }
+
+    // close the original files and replace them
+    for (Part& part : parts_) part.f = nullptr;
+    for (std::size_t i = 0; i < parts_.size(); ++i)
+        fopen_replace_after(parts_[i].path, tmpfns[i], backup,
+                            std::move(fps[i]));
+}
+
+void HexBedBufferMulti::writeOverlay(HexBedContext& ctx, WriteCallback write,
+                                     const std::filesystem::path& filename) {
+#if HAVE_TRUNCATE
+    if (ctx.shouldBackup())
+        for (const Part& part : parts_) makeBackupOf(ctx, part.path);
+    std::vector<FILE_unique_ptr> fps;
+    std::vector<std::FILE*> outs;
+    fps.reserve(parts_.size());
+    outs.reserve(parts_.size());
+    for (Part& part : parts_) {
+        if (!part.f) throw system_io_error("file is closed");
+        errno = 0;
+        FILE_unique_ptr fp = fopen_unique(part.path, "r+b");
+        if (!fp) throw errno_to_exception(errno);
+        std::setvbuf(fp.get(), nullptr, _IONBF, 0);
+        outs.push_back(fp.get());
+        fps.push_back(std::move(fp));
+    }
+
+    HexBedBufferMultiVbuf vbuf(*this, parts_, outs, true);
+    write(vbuf);
+
+    bufsize end = vbuf.position();
+    for (std::size_t i = 0; i < parts_.size(); ++i) {
+        const Part& part = parts_[i];
+        bufsize n = end > part.offset ? end - part.offset : 0;
+        if (i + 1 < parts_.size()) n = std::min(n, part.size);
+        if (n < part.size) {
+            errno = 0;
+            if (::ftruncate(fileno(outs[i]), n))
+                throw errno_to_exception(errno);
+        }
+        errno = 0;
+        if (std::fflush(outs[i])) throw errno_to_exception(errno);
+    }
+#else
+    HexBedBufferMulti::write(ctx, write, filename);
+#endif
+}
+
+void HexBedBufferMulti::writeNew(HexBedContext& ctx, WriteCallback write,
+                                 const std::filesystem::path& filename) {
+    if (ctx.shouldBackup()) makeBackupOf(ctx, filename);
+    errno = 0;
+    auto fp = fopen_unique(filename, "wb");
+    if (!fp) throw errno_to_exception(errno);
+
+    // everything goes into one file
+    std::vector<Part> whole;
+    whole.push_back(Part{filename, nullptr, 0, sz_});
+    std::vector<std::FILE*> outs{fp.get()};
+    HexBedBufferMultiVbuf vbuf(*this, whole, outs, false);
+    write(vbuf);
+
+    errno = 0;
+    if (std::fflush(fp.get())) throw errno_to_exception(errno);
+}
+
+void HexBedBufferMulti::writeCopy(HexBedContext& ctx, WriteCallback write,
+                                  const std::filesystem::path& filename) {
+    writeNew(ctx, write, filename);
+}
+
+bufsize HexBedBufferMulti::size() const noexcept { return sz_; }
+
+};  // namespace hexbed
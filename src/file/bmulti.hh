@@ -0,0 +1,72 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/bmulti.hh -- header for the concatenated multi-file document buffer
+
+#ifndef HEXBED_FILE_BMULTI_HH
+#define HEXBED_FILE_BMULTI_HH
+
+#include <filesystem>
+#include <vector>
+
+#include "file/bfile.hh"
+#include "file/context.hh"
+#include "file/document.hh"
+
+namespace hexbed {
+
+// if filename looks like the first part of a split file (name.001),
+// returns all consecutive parts, otherwise returns an empty list
+std::vector<std::filesystem::path> findSplitParts(
+    const std::filesystem::path& filename);
+
+// presents several files as one contiguous buffer. edits are written back
+// into the parts; every part keeps its size except the last one, which
+// absorbs any change in the total size
+class HexBedBufferMulti : public HexBedBuffer {
+  public:
+    HexBedBufferMulti(const std::vector<std::filesystem::path>& parts);
+    bufsize read(bufoffset offset, bytespan data);
+    void write(HexBedContext& ctx, WriteCallback write,
+               const std::filesystem::path& filename);
+    void writeOverlay(HexBedContext& ctx, WriteCallback write,
+                      const std::filesystem::path& filename);
+    void writeNew(HexBedContext& ctx, WriteCallback write,
+                  const std::filesystem::path& filename);
+    void writeCopy(HexBedContext& ctx, WriteCallback write,
+                   const std::filesystem::path& filename);
+    bufsize size() const noexcept;
+
+    struct Part {
+        std::filesystem::path path;
+        FILE_unique_ptr f;
+        bufsize offset;
+        bufsize size;
+    };
+
+  private:
+    std::vector<Part> parts_;
+    bufsize sz_{0};
+
+    std::size_t partAt(bufoffset offset) const noexcept;
+};
+
+};  // namespace hexbed
+
+#endif /* HEXBED_FILE_BMULTI_HH */
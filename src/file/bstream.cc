@@ -0,0 +1,229 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/bstream.cc -- impl for the streamed input buffer class
+
+#include "file/bstream.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <memory>
+#include <new>
+
+#include "app/config.hh"
+#include "common/buffer.hh"
+#include "common/error.hh"
+#include "common/logger.hh"
+
+#if HEXBED_STREAM_OK
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#endif
+
+namespace hexbed {
+
+bool isStdinPath(const std::filesystem::path& filename) {
+    return filename.native() == std::filesystem::path::string_type{'-'};
+}
+
+bool isStreamPath(const std::filesystem::path& filename) {
+    if (isStdinPath(filename)) return true;
+    std::error_code ec;
+    auto status = std::filesystem::status(filename, ec);
+    if (ec) return false;
+    return std::filesystem::is_fifo(status) ||
+           std::filesystem::is_socket(status) ||
+           std::filesystem::is_character_file(status);
+}
+
+#if HEXBED_STREAM_OK
+
+static constexpr bufsize STREAM_CHUNK = 65536;
+// how often the reader thread checks whether it should stop
+static constexpr int STREAM_POLL_MS = 100;
+
+HexBedBufferStream::HexBedBufferStream(const std::filesystem::path& filename)
+    : spill_((errno = 0, FILE_unique_ptr(std::tmpfile(), [](std::FILE* fp) {
+                  return fp ? std::fclose(fp) : 0;
+              }))),
+      cap_(static_cast<bufsize>(config().streamMaximum) << 20) {
+    if (!spill_) throw errno_to_exception(errno);
+    if (isStdinPath(filename)) {
+        in_ = STDIN_FILENO;
+    } else {
+        // do not block if a FIFO does not have a writer yet
+        errno = 0;
+        in_ = ::open(filename.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (in_ == -1) throw errno_to_exception(errno);
+        closeIn_ = true;
+    }
+    thread_ = std::thread([this] {
+        // anything thrown here would terminate the program, so it becomes
+        // an error reported by refresh() instead
+        try {
+            pump();
+        } catch (const std::bad_alloc&) {
+            error_.store(ENOMEM);
+        } catch (...) {
+            error_.store(EIO);
+        }
+        done_.store(true);
+    });
+}
+
+HexBedBufferStream::~HexBedBufferStream() noexcept {
+    stop_.store(true);
+    if (thread_.joinable()) thread_.join();
+    if (closeIn_) ::close(in_);
+}
+
+void HexBedBufferStream::pump() {
+    auto buf = std::make_unique<byte[]>(STREAM_CHUNK);
+    int fd = fileno(spill_.get());
+    bufsize off = 0;
+    while (!stop_.load()) {
+        if (off >= cap_) {
+            LOG_WARN("stopped reading stream at the size limit");
+            error_.store(EFBIG);
+            break;
+        }
+        struct pollfd pfd {
+            in_, POLLIN, 0
+        };
+        int p = ::poll(&pfd, 1, STREAM_POLL_MS);
+        if (p < 0) {
+            if (errno == EINTR) continue;
+            error_.store(errno);
+            break;
+        }
+        if (!p) continue;
+        ssize_t r =
+            ::read(in_, buf.get(), std::min<bufsize>(STREAM_CHUNK, cap_ - off));
+        if (r < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            error_.store(errno);
+            break;
+        }
+        if (!r) break;
+        const byte* q = buf.get();
+        while (r > 0) {
+            ssize_t w = ::pwrite(fd, q, r, off);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                error_.store(errno);
+                return;
+            }
+            q += w, r -= w, off += w;
+        }
+        received_.store(off);
+    }
+}
+
+bufsize HexBedBufferStream::read(bufoffset offset, bytespan data) {
+    bufsize sz = sz_.load();
+    if (offset >= sz) return 0;
+    bufsize n = std::min<bufsize>(data.size(), sz - offset), o = 0;
+    int fd = fileno(spill_.get());
+    while (o < n) {
+        errno = 0;
+        ssize_t r = ::pread(fd, data.data() + o, n - o, offset + o);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            throw errno_to_exception(errno);
+        }
+        if (!r) break;
+        o += r;
+    }
+    return o;
+}
+
+bufsize HexBedBufferStream::refresh() {
+    bufsize now = received_.load();
+    if (now == sz_.load()) {
+        int e = error_.exchange(0);
+        if (e) throw errno_to_exception(e);
+    }
+    sz_.store(now);
+    return now;
+}
+
+bool HexBedBufferStream::growing() const noexcept { return !done_.load(); }
+
+bool HexBedBufferStream::seekable() const noexcept { return false; }
+
+class HexBedBufferStreamVbuf : public VirtualBuffer {
+  public:
+    HexBedBufferStreamVbuf(HexBedBuffer& buf, std::FILE* wf)
+        : buf_(buf), wf_(wf) {}
+    void raw(bufsize n, const byte* r) {
+        errno = 0;
+        if (!std::fwrite(r, n, 1, wf_)) throw errno_to_exception(errno);
+    }
+    void copy(bufsize n, bufsize o) {
+        byte tmp[BUFFER_SIZE];
+        while (n) {
+            bufsize r =
+                buf_.read(o, bytespan(tmp, std::min<bufsize>(n, sizeof(tmp))));
+            if (!r) throw system_io_error("unexpected end of stream");
+            raw(r, tmp);
+            o += r, n -= r;
+        }
+    }
+
+  private:
+    HexBedBuffer& buf_;
+    std::FILE* wf_;
+};
+
+void HexBedBufferStream::write(HexBedContext& ctx, WriteCallback write,
+                               const std::filesystem::path& filename) {
+    throw system_io_error("streamed input cannot be saved in place");
+}
+
+void HexBedBufferStream::writeOverlay(HexBedContext& ctx, WriteCallback write,
+                                      const std::filesystem::path& filename) {
+    throw system_io_error("streamed input cannot be saved in place");
+}
+
+void HexBedBufferStream::writeNew(HexBedContext& ctx, WriteCallback write,
+                                  const std::filesystem::path& filename) {
+    if (ctx.shouldBackup()) makeBackupOf(ctx, filename);
+    errno = 0;
+    auto fp = fopen_unique(filename, "wb");
+    if (!fp) throw errno_to_exception(errno);
+
+    HexBedBufferStreamVbuf vbuf(*this, fp.get());
+    write(vbuf);
+
+    errno = 0;
+    if (std::fflush(fp.get())) throw errno_to_exception(errno);
+}
+
+void HexBedBufferStream::writeCopy(HexBedContext& ctx, WriteCallback write,
+                                   const std::filesystem::path& filename) {
+    writeNew(ctx, write, filename);
+}
+
+bufsize HexBedBufferStream::size() const noexcept { return sz_.load(); }
+
+#endif
+
+};  // namespace hexbed
@@ -0,0 +1,90 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/bstream.hh -- header for the streamed input buffer class
+
+#ifndef HEXBED_FILE_BSTREAM_HH
+#define HEXBED_FILE_BSTREAM_HH
+
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+#include "file/bfile.hh"
+#include "file/context.hh"
+#include "file/document.hh"
+
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+#include <unistd.h>
+#endif
+
+#if defined(_POSIX_VERSION)
+#define HEXBED_STREAM_OK 1
+#endif
+
+namespace hexbed {
+
+// the file name used to refer to standard input
+bool isStdinPath(const std::filesystem::path& filename);
+// true for standard input, pipes, sockets and other non-seekable files
+bool isStreamPath(const std::filesystem::path& filename);
+
+#if HEXBED_STREAM_OK
+
+// reads a non-seekable source on a background thread and spills everything
+// received into a temporary file, so that memory use stays constant
+class HexBedBufferStream : public HexBedBuffer {
+  public:
+    HexBedBufferStream(const std::filesystem::path& filename);
+    ~HexBedBufferStream() noexcept;
+    bufsize read(bufoffset offset, bytespan data);
+    void write(HexBedContext& ctx, WriteCallback write,
+               const std::filesystem::path& filename);
+    void writeOverlay(HexBedContext& ctx, WriteCallback write,
+                      const std::filesystem::path& filename);
+    void writeNew(HexBedContext& ctx, WriteCallback write,
+                  const std::filesystem::path& filename);
+    void writeCopy(HexBedContext& ctx, WriteCallback write,
+                   const std::filesystem::path& filename);
+    bufsize size() const noexcept;
+    bufsize refresh();
+    bool growing() const noexcept;
+    bool seekable() const noexcept;
+
+  private:
+    FILE_unique_ptr spill_;
+    int in_{-1};
+    bool closeIn_{false};
+    // no more than this much is read from the source
+    bufsize cap_;
+    std::atomic<bufsize> sz_{0};
+    std::atomic<bufsize> received_{0};
+    std::atomic<int> error_{0};
+    std::atomic<bool> done_{false};
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+
+    void pump();
+};
+
+#endif
+
+};  // namespace hexbed
+
+#endif /* HEXBED_FILE_BSTREAM_HH */
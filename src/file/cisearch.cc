@@ -21,12 +21,13 @@
 
 #include "file/cisearch.hh"
 
-#include <sstream>
+#include <algorithm>
+#include <bit>
+#include <memory>
+#include <new>
 
 #include "app/encoding.hh"
-#include "common/buffer.hh"
 #include "common/caseconv.hh"
-#include "common/logger.hh"
 #include "common/memory.hh"
 #include "file/document.hh"
 #include "file/search.hh"
@@ -34,132 +35,202 @@
 namespace hexbed {
 
 CaseInsensitivePattern::CaseInsensitivePattern()
-    : encoding(getCharacterEncodingByName(STRING(""))),
-      pattern(),
-      headLowerLen(0),
-      headUpperLen(0) {}
+    : minLength(0),
+      maxLength(0),
+      impossible(false),
+      filter1(0),
+      value1(0),
+      mask1(0),
+      filter2(0),
+      value2(0),
+      mask2(0) {}
 
 static std::size_t encodeOneChar(const CharacterEncoding& enc, char32_t c,
                                  std::size_t n, byte* b) {
-    CharEncodeStatus status =
-        enc.encode(charEncodeFromArray(1, &c), charEncodeToArray(n, b));
-    return status.ok ? status.wroteBytes : 0;
+    bool pending = true;
+    std::size_t len = 0;
+    CharEncodeStatus status = enc.encode(
+        [&](u32span s) -> bufsize {
+            if (!pending || s.empty()) return 0;
+            s[0] = c, pending = false;
+            return 1;
+        },
+        [&](const_bytespan s) {
+            std::size_t r = std::min(n - len, s.size());
+            std::copy(s.begin(), s.begin() + r, b + len);
+            len += r;
+        });
+    return status.ok ? len : 0;
+}
+
+// how many characters are looked at as possible forms of each character
+static constexpr std::size_t CASELESS_FORMS = 6;
+
+struct CaselessFilter {
+    bufsize offset;
+    byte value;
+    byte mask;
+};
+
+// the bits on which all of the given bytes agree
+template <typename F>
+static CaselessFilter caselessFilter(bufsize offset, F&& each) {
+    bool any = false;
+    byte first = 0, diff = 0;
+    each([&](byte b) {
+        if (!any) first = b, any = true;
+        diff |= b ^ first;
+    });
+    byte mask = ~diff;
+    return CaselessFilter{offset, static_cast<byte>(first & mask), mask};
 }
 
 CaseInsensitivePattern::CaseInsensitivePattern(const string& encname,
                                                const std::wstring& text_)
-    : encoding(getCharacterEncodingByName(encname)) {
+    : CaseInsensitivePattern() {
+    CharacterEncoding encoding = getCharacterEncodingByName(encname);
     std::u32string text = wstringToU32string(text_);
-    pattern = textCaseFold(text);
-    headUpperLen = encodeOneChar(encoding, textCaseUpper(text)[0],
-                                 sizeof(headUpper), headUpper);
-    headLowerLen = encodeOneChar(encoding, textCaseLower(text)[0],
-                                 sizeof(headLower), headLower);
-}
+    std::u32string folded = textCaseFold(text);
+    std::size_t n = folded.size();
+    const std::u32string forms[CASELESS_FORMS] = {
+        folded,           textCaseUpper(folded), textCaseLower(folded),
+        text,             textCaseUpper(text),   textCaseLower(text)};
+
+    // collect the characters that fold to each pattern character
+    std::u32string candidates;
+    candidates.reserve(n * CASELESS_FORMS);
+    for (std::size_t i = 0; i < n; ++i)
+        for (const std::u32string& form : forms)
+            candidates.push_back(form.size() == n ? form[i] : folded[i]);
+    std::u32string candidatesFolded = textCaseFold(candidates);
+    if (candidatesFolded.size() != candidates.size())
+        candidatesFolded = candidates;
 
-static std::u32string readU32String(const HexBedDocument& document,
-                                    bufsize offset, bufsize wantedLength,
-                                    bufsize& readBytes,
-                                    CaseInsensitivePattern& pattern) {
-    byte buf[BUFFER_SIZE];
-    bufsize r;
-    u32ostringstream us;
-    bufsize readchars = 0;
-    bufsize leftover = 0;
-    bufsize total = 0;
-    while ((r = document.read(offset,
-                              bytespan{buf + leftover, buf + sizeof(buf)}))) {
-        CharDecodeStatus status = pattern.encoding.decode(
-            charDecodeFromArray(r + leftover, buf), charDecodeToStream(us));
-        readchars += status.wroteChars;
-        leftover = r - status.readBytes;
-        total += status.readBytes;
-        offset += status.readBytes;
-        if (!status.ok) break;
-        if (readchars >= wantedLength) {
-            std::u32string folded = textCaseFold(us.str());
-            if (folded.length() >= wantedLength) {
-                readBytes = total;
-                return folded;
+    byte buf[MBCS_CHAR_MAX];
+    units.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        Unit& unit = units[i];
+        unit.minLength = unit.maxLength = 0;
+        for (std::size_t k = i * CASELESS_FORMS; k < (i + 1) * CASELESS_FORMS;
+             ++k) {
+            if (candidatesFolded[k] != folded[i]) continue;
+            std::size_t len =
+                encodeOneChar(encoding, candidates[k], sizeof(buf), buf);
+            if (!len) continue;
+            if (len == 1) {
+                unit.single.set(buf[0]);
+            } else {
+                std::vector<byte> seq(buf, buf + len);
+                if (std::find(unit.multi.begin(), unit.multi.end(), seq) ==
+                    unit.multi.end())
+                    unit.multi.push_back(std::move(seq));
             }
         }
-        if (leftover) memMove(buf, buf + status.readBytes, leftover);
+        bufsize lo = unit.single.any() ? 1 : 0, hi = lo;
+        for (const std::vector<byte>& seq : unit.multi) {
+            if (!lo || seq.size() < lo) lo = seq.size();
+            if (seq.size() > hi) hi = seq.size();
+        }
+        if (!hi) impossible = true;
+        unit.minLength = lo;
+        unit.maxLength = hi;
+        minLength += lo;
+        maxLength += hi;
+    }
+    if (impossible || units.empty()) return;
+
+    // pick the two most selective bytes at fixed offsets from the start
+    std::vector<CaselessFilter> filters;
+    bufsize offset = 0;
+    for (const Unit& unit : units) {
+        for (bufsize k = 0; k < unit.minLength; ++k)
+            filters.push_back(
+                caselessFilter(offset + k, [&unit, k](auto&& visit) {
+                    if (!k)
+                        for (unsigned b = 0; b < 256; ++b)
+                            if (unit.single[b]) visit(static_cast<byte>(b));
+                    for (const std::vector<byte>& seq : unit.multi)
+                        visit(seq[k]);
+                }));
+        if (unit.minLength != unit.maxLength) break;
+        offset += unit.minLength;
     }
-    readBytes = total;
-    return textCaseFold(us.str());
+    auto score = [](const CaselessFilter& f) { return std::popcount(f.mask); };
+    std::size_t best = 0, next = 0;
+    for (std::size_t i = 1; i < filters.size(); ++i)
+        if (score(filters[i]) > score(filters[best])) best = i;
+    for (std::size_t i = 0; i < filters.size(); ++i)
+        if (i != best &&
+            (next == best || score(filters[i]) > score(filters[next])))
+            next = i;
+    filter1 = filters[best].offset;
+    value1 = filters[best].value;
+    mask1 = filters[best].mask;
+    filter2 = filters[next].offset;
+    value2 = filters[next].value;
+    mask2 = filters[next].mask;
 }
 
-static bool equalsCaseInsensitive(const HexBedDocument& document,
-                                  bufsize offset,
-                                  CaseInsensitivePattern& pattern,
-                                  bufsize& length) {
-    std::size_t expected = pattern.pattern.length();
-    std::u32string compareString =
-        readU32String(document, offset, expected + 1, length, pattern);
-    if (compareString.size() < expected) return false;
-    if (std::u32string_view(compareString.data(), expected) !=
-        std::u32string_view(pattern.pattern.data(), expected))
-        return false;
-    if (expected < compareString.size())
-        length -=
-            pattern.encoding
-                .encode(charEncodeFromArray(compareString.size() - expected,
-                                            compareString.data()),
-                        charEncodeToNull())
-                .wroteBytes;
+bool CaseInsensitivePattern::matchAt(const byte* p, const byte* end,
+                                     bufsize& length) const noexcept {
+    const byte* q = p;
+    for (const Unit& unit : units) {
+        if (q >= end) return false;
+        if (unit.single[*q]) {
+            ++q;
+            continue;
+        }
+        bool found = false;
+        for (const std::vector<byte>& seq : unit.multi) {
+            if (static_cast<std::size_t>(end - q) >= seq.size() &&
+                std::equal(seq.begin(), seq.end(), q)) {
+                q += seq.size();
+                found = true;
+                break;
+            }
+        }
+        if (!found) return false;
+    }
+    length = q - p;
     return true;
 }
 
+static std::unique_ptr<byte[]> allocateSearchBuffer(bufsize z, bufsize& c) {
+    byte* bp = new (std::nothrow) byte[(c = getPreferredSearchBufferSize(z))];
+    if (!bp) bp = new byte[(c = getMinimalSearchBufferSize(z))];
+    return std::unique_ptr<byte[]>(bp);
+}
+
+// windows overlap by maxLength - 1 bytes. a match starting in the overlap
+// is only looked for in the window where it fits whole, or in the window
+// that reaches the end of the range
 SearchResult searchForwardCaseless(HexBedTask& task,
                                    const HexBedDocument& document,
                                    bufsize start, bufsize end,
-                                   CaseInsensitivePattern& pattern) {
-    const_bytespan udata{pattern.headUpper, pattern.headUpperLen};
-    const_bytespan ldata{pattern.headLower, pattern.headLowerLen};
-    bufsize r, rr, o = start, z = std::max(udata.size(), ldata.size()), c, hc;
+                                   const CaseInsensitivePattern& pattern) {
+    const CaseInsensitivePattern& p = pattern;
+    bufsize z = p.maxLength, y = p.minLength, c, r, rr, o = start;
     if (start >= end) return SearchResult{};
-    if (!z) return SearchResult{SearchResultType::Full, start};
-    bufsize mins = getMinimalSearchBufferSize(z),
-            prefs = getPreferredSearchBufferSize(z);
-    byte* bp = new (std::nothrow) byte[(c = prefs)];
-    if (!bp) bp = new byte[(c = mins)];
-    std::unique_ptr<byte[]> buffer(bp);
-    hc = c >> 1;
-    byte* flippers[2];
-    flippers[0] = bp;
-    flippers[1] = bp + hc;
-    byte* flip = flippers[0];
-    int flipindex = 1;
-
-    SearchResult2 pres{};
-    while ((rr = std::min(end - o, hc)),
-           (r = document.read(o, bytespan(flip, rr)))) {
+    if (p.units.empty()) return SearchResult{SearchResultType::Full, start};
+    if (p.impossible || end - start < y) return SearchResult{};
+    bufsize f = std::max(p.filter1, p.filter2) + 1;
+    std::unique_ptr<byte[]> buffer = allocateSearchBuffer(z, c);
+    byte* bp = buffer.get();
+    while ((rr = std::min(end - o, c)) >= y &&
+           (r = document.read(o, bytespan(bp, rr))) >= y) {
         if (task.isCancelled()) break;
-        if (pres.type == SearchResultType::Partial) {
-            pres = searchFullForward2(hc, flippers[flipindex], r, flip,
-                                      pattern.headLowerLen, pattern.headLower,
-                                      pattern.headUpperLen, pattern.headUpper,
-                                      pres.offset, pres.secondary);
-            if (pres) {
-                bufsize oo = o + pres.offset, sl;
-                if (equalsCaseInsensitive(document, oo, pattern, sl))
-                    return SearchResult{SearchResultType::Full, oo, sl};
-            }
-        }
-        pres = searchPartialForward2(r, flip, pattern.headLowerLen,
-                                     pattern.headLower, pattern.headUpperLen,
-                                     pattern.headUpper, r == hc);
-        if (pres.type == SearchResultType::Full) {
-            bufsize oo = o + pres.offset, sl;
-            if (equalsCaseInsensitive(document, oo, pattern, sl))
-                return SearchResult{SearchResultType::Full, oo, sl};
+        bool last = r < rr || o + r >= end;
+        const byte* s = bp;
+        const byte* e = bp + (last ? r - f + 1 : r - z + 1);
+        bufsize n;
+        while ((s = memFindPairMasked(s, e, p.filter1, p.value1, p.mask1,
+                                      p.filter2, p.value2, p.mask2))) {
+            if (p.matchAt(s, bp + r, n))
+                return SearchResult{SearchResultType::Full, o + (s - bp), n};
+            ++s;
         }
-        if (pres.type == SearchResultType::Partial) {
-            flip = flippers[flipindex];
-            flipindex = flipindex ^ 1;
-        }
-        if (r < rr) break;
-        o += r;
+        if (last) break;
+        o += r - z + 1;
     }
     return SearchResult{};
 }
@@ -167,52 +238,30 @@ SearchResult searchForwardCaseless(HexBedTask& task,
 SearchResult searchBackwardCaseless(HexBedTask& task,
                                     const HexBedDocument& document,
                                     bufsize start, bufsize end,
-                                    CaseInsensitivePattern& pattern) {
-    const_bytespan udata{pattern.headUpper, pattern.headUpperLen};
-    const_bytespan ldata{pattern.headLower, pattern.headLowerLen};
-    bufsize r, rr, o = end, z = std::max(udata.size(), ldata.size()), c, hc;
+                                    const CaseInsensitivePattern& pattern) {
+    const CaseInsensitivePattern& p = pattern;
+    bufsize z = p.maxLength, y = p.minLength, c, r, hi = end;
     if (start >= end) return SearchResult{};
-    if (!z) return SearchResult{SearchResultType::Full, end};
-    bufsize mins = getMinimalSearchBufferSize(z),
-            prefs = getPreferredSearchBufferSize(z);
-    byte* bp = new (std::nothrow) byte[(c = prefs)];
-    if (!bp) bp = new byte[(c = mins)];
-    std::unique_ptr<byte[]> buffer(bp);
-    hc = c >> 1;
-    byte* flippers[2];
-    flippers[0] = bp;
-    flippers[1] = bp + hc;
-    byte* flip = flippers[0];
-    int flipindex = 1;
-
-    SearchResult2 pres{};
-    while ((rr = std::min(o - start, hc)) &&
-           rr == (r = document.read(o - rr, bytespan(flip, rr)))) {
+    if (p.units.empty()) return SearchResult{SearchResultType::Full, end};
+    if (p.impossible || end - start < y) return SearchResult{};
+    bufsize f = std::max(p.filter1, p.filter2) + 1;
+    std::unique_ptr<byte[]> buffer = allocateSearchBuffer(z, c);
+    byte* bp = buffer.get();
+    bool first = true;
+    while (hi - start >= y) {
+        bufsize lo = hi - start > c ? hi - c : start;
+        if ((r = document.read(lo, bytespan(bp, hi - lo))) < hi - lo) break;
         if (task.isCancelled()) break;
-        o -= r;
-        if (pres.type == SearchResultType::Partial) {
-            pres = searchFullBackward2(hc, flippers[flipindex], r, flip,
-                                       pattern.headLowerLen, pattern.headLower,
-                                       pattern.headUpperLen, pattern.headUpper,
-                                       pres.offset, pres.secondary);
-            if (pres) {
-                bufsize oo = o + pres.offset - z + 1, sl;
-                if (equalsCaseInsensitive(document, oo, pattern, sl))
-                    return SearchResult{SearchResultType::Full, oo, sl};
-            }
-        }
-        pres = searchPartialBackward2(r, flip, pattern.headLowerLen,
-                                      pattern.headLower, pattern.headUpperLen,
-                                      pattern.headUpper, o > 0);
-        if (pres.type == SearchResultType::Full) {
-            bufsize oo = o + pres.offset - z + 1, sl;
-            if (equalsCaseInsensitive(document, oo, pattern, sl))
-                return SearchResult{SearchResultType::Full, oo, sl};
-        }
-        if (pres.type == SearchResultType::Partial) {
-            flip = flippers[flipindex];
-            flipindex = flipindex ^ 1;
-        }
+        if (!first && r < z) break;
+        const byte* s = bp + (first ? r - f + 1 : r - z + 1);
+        bufsize n;
+        while ((s = memFindPairMaskedLast(bp, s, p.filter1, p.value1, p.mask1,
+                                          p.filter2, p.value2, p.mask2)))
+            if (p.matchAt(s, bp + r, n))
+                return SearchResult{SearchResultType::Full, lo + (s - bp), n};
+        if (lo == start) break;
+        hi = lo + z - 1;
+        first = false;
     }
     return SearchResult{};
 }
@@ -22,6 +22,9 @@
 #ifndef HEXBED_FILE_CISEARCH_HH
 #define HEXBED_FILE_CISEARCH_HH
 
+#include <bitset>
+#include <vector>
+
 #include "common/charconv.hh"
 #include "file/document-fwd.hh"
 #include "file/search.hh"
@@ -33,23 +36,42 @@ struct CaseInsensitivePattern {
     CaseInsensitivePattern();
     CaseInsensitivePattern(const string& encoding, const std::wstring& text);
 
-    CharacterEncoding encoding;
-    std::u32string pattern;
-    bufsize headLowerLen;
-    byte headLower[MBCS_CHAR_MAX];
-    bufsize headUpperLen;
-    byte headUpper[MBCS_CHAR_MAX];
+    // one character of the pattern, as the encoded forms of every
+    // character that folds to it
+    struct Unit {
+        std::bitset<256> single;
+        std::vector<std::vector<byte>> multi;
+        bufsize minLength;
+        bufsize maxLength;
+    };
+
+    // checks for a match at p, not reading past end
+    bool matchAt(const byte* p, const byte* end,
+                 bufsize& length) const noexcept;
+
+    std::vector<Unit> units;
+    bufsize minLength;
+    bufsize maxLength;
+    // some character has no encoded form
+    bool impossible;
+    // every match has (p[filter] & mask) == value for these two bytes
+    bufsize filter1;
+    byte value1;
+    byte mask1;
+    bufsize filter2;
+    byte value2;
+    byte mask2;
 };
 
 SearchResult searchForwardCaseless(HexBedTask& task,
                                    const HexBedDocument& document,
                                    bufsize start, bufsize end,
-                                   CaseInsensitivePattern& pattern);
+                                   const CaseInsensitivePattern& pattern);
 SearchResult searchBackwardCaseless(HexBedTask& task,
                                     const HexBedDocument& document,
                                     bufsize start, bufsize end,
-                                    CaseInsensitivePattern& pattern);
+                                    const CaseInsensitivePattern& pattern);
 
 };  // namespace hexbed
 
-#endif /* HEXBED_FILE_SEARCH_HH */
+#endif /* HEXBED_FILE_CISEARCH_HH */
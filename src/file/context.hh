@@ -47,6 +47,13 @@ class HexBedContext {
                                              bufsize start) {}
     inline virtual void announceBytesChanged(HexBedDocument* doc, bufsize start,
                                              bufsize length) {}
+    // the bytes at [start, start + oldLength) were replaced by newLength
+    // bytes, and everything after them moved along
+    inline virtual void announceBytesResized(HexBedDocument* doc,
+                                             bufsize start, bufsize oldLength,
+                                             bufsize newLength) {
+        announceBytesChanged(doc, start);
+    }
     inline virtual void announceUndoChange(HexBedDocument* doc) {}
 
     inline virtual ~HexBedContext() {}
@@ -21,15 +21,26 @@
 
 #include "file/document.hh"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
+#include <map>
+#include <mutex>
 #include <new>
+#include <thread>
 
 #include "app/config.hh"
 #include "common/buffer.hh"
+#include "common/logger.hh"
 #include "common/memory.hh"
 #include "file/bfile.hh"
+#include "file/bgzip.hh"
+#include "file/bmulti.hh"
 //#include "file/bmmap.hh"
 #include "file/bnew.hh"
+#include "file/bstream.hh"
 
 namespace hexbed {
 
@@ -40,6 +51,14 @@ const T* const_this(T* p) {
 
 bufsize HexBedBuffer::size() noexcept { return const_this(this)->size(); }
 
+bufsize HexBedBuffer::refresh() { return size(); }
+
+bool HexBedBuffer::readOnly() const noexcept { return false; }
+
+bool HexBedBuffer::growing() const noexcept { return false; }
+
+bool HexBedBuffer::seekable() const noexcept { return true; }
+
 static std::unique_ptr<HexBedBuffer> bufferNew() {
     return std::make_unique<HexBedBufferNew>();
 }
@@ -51,7 +70,7 @@ static std::unique_ptr<HexBedBuffer> bufferNew() {
     }
 
 static std::unique_ptr<HexBedBuffer> bufferOpen(
-    const std::filesystem::path& filename) {
+    HexBedContext& ctx, const std::filesystem::path& filename) {
     [[maybe_unused]] bool szknown;
     [[maybe_unused]] bufsize sz;
     try {
@@ -61,14 +80,197 @@ static std::unique_ptr<HexBedBuffer> bufferOpen(
         sz = 0;
         szknown = false;
     }
+#if HEXBED_STREAM_OK
+    if (isStreamPath(filename))
+        return std::make_unique<HexBedBufferStream>(filename);
+#endif
+#if HAS_ZLIB
+    if (config().decompressFiles && isGzipFile(filename)) {
+        // a corrupt or truncated file can still be opened as is
+        try {
+            return std::make_unique<HexBedBufferGzip>(ctx, filename);
+        } catch (const std::bad_alloc&) {
+            throw;
+        } catch (const std::exception& e) {
+            LOG_WARN("could not decompress file, opening as is: %s", e.what());
+        }
+    }
+#endif
 #if HEXBED_MMAP_OK
     TRY_OPEN(HexBedBufferMmap, filename);
 #endif
     return std::make_unique<HexBedBufferFile>(filename);
 }
 
+static std::unique_ptr<HexBedBuffer> bufferOpen(
+    HexBedContext& ctx, const std::filesystem::path& filename,
+    const std::vector<std::filesystem::path>& parts) {
+    if (!parts.empty()) return std::make_unique<HexBedBufferMulti>(parts);
+    return bufferOpen(ctx, filename);
+}
+
+using PinMap = std::map<std::filesystem::path, unsigned>;
+static std::mutex pinLock;
+static PinMap pinned;
+
+static std::filesystem::path pinKey(const std::filesystem::path& filename) {
+    std::error_code ec;
+    std::filesystem::path key = std::filesystem::weakly_canonical(filename, ec);
+    return ec ? filename : key;
+}
+
+static std::shared_ptr<void> pinFiles(
+    const std::vector<std::filesystem::path>& files) {
+    std::vector<std::filesystem::path> keys;
+    for (const std::filesystem::path& file : files)
+        keys.push_back(pinKey(file));
+    {
+        std::lock_guard lock(pinLock);
+        for (const std::filesystem::path& key : keys) ++pinned[key];
+    }
+    return std::shared_ptr<void>(nullptr, [keys](void*) {
+        std::lock_guard lock(pinLock);
+        for (const std::filesystem::path& key : keys) {
+            auto it = pinned.find(key);
+            if (it != pinned.end() && !--it->second) pinned.erase(it);
+        }
+    });
+}
+
+bool isSourcePinned(const std::filesystem::path& filename) {
+    std::filesystem::path key = pinKey(filename);
+    std::lock_guard lock(pinLock);
+    return pinned.contains(key);
+}
+
+std::shared_ptr<HexBedSource> openFileSource(
+    const std::filesystem::path& filename) {
+    auto source = std::make_shared<HexBedSource>();
+    source->buffer = std::make_shared<HexBedBufferFile>(filename);
+    source->pin = pinFiles({filename});
+    return source;
+}
+
+bufsize HexBedSlice::size() const noexcept {
+    bufsize n = 0;
+    for (const Piece& piece : pieces) n += piece.size;
+    return n;
+}
+
+class HexBedSourceReader {
+  public:
+    HexBedSourceReader(const HexBedDocument& doc) : doc_(doc) {}
+    bufsize read(bufoffset offset, bytespan data) const {
+        return doc_.readSource(offset, data);
+    }
+    byte operator()(bufsize off) const {
+        byte b;
+        [[maybe_unused]] bufsize z = read(off, {&b, 1});
+        HEXBED_ASSERT(z);
+        return b;
+    }
+
+  private:
+    const HexBedDocument& doc_;
+};
+
+// materializes data from secondary sources when saving
+class HexBedSourceWriteBuffer : public VirtualBuffer {
+  public:
+    HexBedSourceWriteBuffer(VirtualBuffer& out, HexBedSourceReader& in)
+        : out_(out), in_(in) {}
+    void raw(bufsize n, const byte* r) { out_.raw(n, r); }
+    void copy(bufsize n, bufsize o) {
+        if (o < SOURCE_BASE) return out_.copy(n, o);
+        byte tmp[BUFFER_SIZE];
+        while (n) {
+            bufsize r =
+                in_.read(o, bytespan(tmp, std::min<bufsize>(n, sizeof(tmp))));
+            if (!r)
+                throw std::runtime_error("could not read everything we need!");
+            out_.raw(r, tmp);
+            o += r, n -= r;
+        }
+    }
+
+  private:
+    VirtualBuffer& out_;
+    HexBedSourceReader& in_;
+};
+
 void HexBedDocument::grow() {}
 
+bufsize HexBedDocument::readSource(bufoffset offset, bytespan data) const {
+    if (offset < SOURCE_BASE) return buffer_->read(offset, data);
+    auto it = std::upper_bound(
+        sources_.begin(), sources_.end(), offset,
+        [](bufoffset o, const SourceEntry& e) { return o < e.base; });
+    HEXBED_ASSERT(it != sources_.begin(), "reading unknown source");
+    --it;
+    return it->source->buffer->read(offset - it->base, data);
+}
+
+bufoffset HexBedDocument::sourceBase(
+    const std::shared_ptr<HexBedSource>& source) {
+    for (const SourceEntry& e : sources_)
+        if (e.source == source) return e.base;
+    bufoffset base = SOURCE_BASE;
+    if (!sources_.empty()) {
+        const SourceEntry& e = sources_.back();
+        // leave a gap so that pieces from different sources never merge
+        base = e.base + e.source->buffer->size() + 1;
+    }
+    sources_.push_back(SourceEntry{base, source});
+    return base;
+}
+
+void HexBedDocument::pruneSources() {
+    // only called once the tree is cleared, so that the undo history is
+    // all that can still refer to the sources
+    std::vector<bool> used(sources_.size());
+    for (const HexBedUndoEntry& entry : undos_) {
+        const std::vector<HexBedUndoStripe>& stripes = entry.oldStripes;
+        for (std::size_t i = 0; i < stripes.size(); ++i) {
+            if (!stripes[i].original()) continue;
+            bufoffset o = stripes[++i].raw();
+            if (o < SOURCE_BASE) continue;
+            auto it = std::upper_bound(
+                sources_.begin(), sources_.end(), o,
+                [](bufoffset o, const SourceEntry& e) { return o < e.base; });
+            used[it - sources_.begin() - 1] = true;
+        }
+    }
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < sources_.size(); ++i)
+        if (used[i]) sources_[j++] = std::move(sources_[i]);
+    sources_.resize(j);
+}
+
+std::vector<std::filesystem::path> HexBedDocument::ownFiles() const {
+    if (!parts_.empty()) return parts_;
+    if (!filename_.empty()) return {filename_};
+    return {};
+}
+
+std::shared_ptr<HexBedSource> HexBedDocument::ownSource() {
+    if (!ownSource_) {
+        auto source = std::make_shared<HexBedSource>();
+        if (filed() && !readOnly_) {
+            // our buffer may be closed or written in place on save,
+            // so others get a buffer of their own
+            if (parts_.empty())
+                source->buffer = std::make_shared<HexBedBufferFile>(filename_);
+            else
+                source->buffer = std::make_shared<HexBedBufferMulti>(parts_);
+        } else {
+            source->buffer = buffer_;
+        }
+        source->pin = pinFiles(ownFiles());
+        ownSource_ = std::move(source);
+    }
+    return ownSource_;
+}
+
 HexBedDocument::HexBedDocument(std::shared_ptr<HexBedContext> ctx)
     : context_(ctx), filename_(), buffer_(bufferNew()), treble_(0) {}
 
@@ -81,16 +283,27 @@ HexBedDocument::HexBedDocument(std::shared_ptr<HexBedContext> ctx,
                                bool readOnly)
     : context_(ctx),
       filename_(filename),
-      buffer_(bufferOpen(filename)),
+      buffer_(bufferOpen(*ctx, filename)),
       treble_(buffer_->size()),
-      readOnly_(readOnly) {
+      readOnly_(readOnly || buffer_->readOnly()) {
     // LOG_TRACE("opened file as %s", typeid(*buffer_.get()).name());
 }
 
+HexBedDocument::HexBedDocument(std::shared_ptr<HexBedContext> ctx,
+                               const std::vector<std::filesystem::path>& parts,
+                               bool readOnly)
+    : context_(ctx),
+      filename_(parts.empty() ? std::filesystem::path() : parts.front()),
+      parts_(parts),
+      buffer_(bufferOpen(*ctx, filename_, parts_)),
+      treble_(buffer_->size()),
+      readOnly_(readOnly || buffer_->readOnly()) {}
+
 HexBedDocument::~HexBedDocument() {}
 
 bufsize HexBedDocument::read(bufoffset offset, bytespan data) const {
-    return treble_.read(*buffer_, data.data(), offset, data.size());
+    HexBedSourceReader reader(*this);
+    return treble_.read(reader, data.data(), offset, data.size());
 }
 
 bool HexBedDocument::canUndo() const noexcept {
@@ -153,26 +366,19 @@ HexBedUndoEntry& UndoToken::entry() noexcept {
 
 class UndoWriter {
   public:
-    UndoWriter(HexBedBuffer& buf, std::vector<byte>& b,
-               std::vector<HexBedUndoStripe>& s)
-        : buf(buf), b(b), s(s) {}
+    UndoWriter(std::vector<byte>& b, std::vector<HexBedUndoStripe>& s)
+        : b(b), s(s) {}
     void raw(bufsize n, const byte* r) {
         bufsize z = b.size();
         b.resize(z + n);
         memCopy(b.data() + z, r, n);
         addStripe<false>(n, 0);
     }
-    void copy(bufsize n, bufsize o) {
-        bufsize z = b.size();
-        b.resize(z + n);
-        z = buf.read(o, bytespan{b.data() + z, n});
-        if (z < n)
-            throw std::runtime_error("could not read everything we need!");
-        addStripe<true>(n, o);
-    }
+    // sources only change when the document is saved, so a reference
+    // will do until then (see HexBedUndoEntry::detach)
+    void copy(bufsize n, bufsize o) { addStripe<true>(n, o); }
 
   private:
-    HexBedBuffer& buf;
     std::vector<byte>& b;
     std::vector<HexBedUndoStripe>& s;
 
@@ -189,23 +395,9 @@ class UndoWriter {
     }
 };
 
-struct ByteReader {
-  public:
-    ByteReader(HexBedBuffer& buf) : buf(buf){};
-    byte operator()(bufsize off) {
-        byte b;
-        [[maybe_unused]] bufsize z = buf.read(off, {&b, 1});
-        HEXBED_ASSERT(z);
-        return b;
-    }
-
-  private:
-    HexBedBuffer& buf;
-};
-
 UndoToken HexBedDocument::addUndoReplaceOne(bufsize off) {
     if (!config().undoHistoryMaximum) return UndoToken();
-    ByteReader reader(*buffer_);
+    HexBedSourceReader reader(*this);
     auto result = treble_.readByte(reader, off);
     return addUndo(HexBedUndoEntry{
         .type = result.original ? HexBedUndoType::ReplaceOneOriginal
@@ -223,7 +415,7 @@ UndoToken HexBedDocument::addUndoReplaceMany(bufsize off, bufsize cnt) {
     if (!config().undoHistoryMaximum) return UndoToken();
     std::vector<byte> vecb;
     std::vector<HexBedUndoStripe> vecs;
-    UndoWriter writer(*buffer_, vecb, vecs);
+    UndoWriter writer(vecb, vecs);
     [[maybe_unused]] bufsize z = treble_.render(writer, off, cnt);
     HEXBED_ASSERT(z == cnt);
     vecb.shrink_to_fit();
@@ -243,7 +435,7 @@ UndoToken HexBedDocument::addUndoReplaceDiffSize(bufsize off, bufsize old,
     if (!config().undoHistoryMaximum) return UndoToken();
     std::vector<byte> vecb;
     std::vector<HexBedUndoStripe> vecs;
-    UndoWriter writer(*buffer_, vecb, vecs);
+    UndoWriter writer(vecb, vecs);
     treble_.render(writer, off, old);
     vecb.shrink_to_fit();
     vecs.shrink_to_fit();
@@ -273,7 +465,7 @@ UndoToken HexBedDocument::addUndoRemove(bufsize off, bufsize cnt) {
     if (!config().undoHistoryMaximum) return UndoToken();
     std::vector<byte> vecb;
     std::vector<HexBedUndoStripe> vecs;
-    UndoWriter writer(*buffer_, vecb, vecs);
+    UndoWriter writer(vecb, vecs);
     [[maybe_unused]] bufsize z = treble_.render(writer, off, cnt);
     HEXBED_ASSERT(z == cnt);
     vecb.shrink_to_fit();
@@ -288,6 +480,20 @@ UndoToken HexBedDocument::addUndoRemove(bufsize off, bufsize cnt) {
                                    .oldStripes = std::move(vecs)});
 }
 
+UndoToken HexBedDocument::addUndoMove(bufsize off, bufsize cnt,
+                                      bufsize target) {
+    if (!config().undoHistoryMaximum) return UndoToken();
+    return addUndo(HexBedUndoEntry{.type = HexBedUndoType::Move,
+                                   .oldValue = 0,
+                                   .wasDirty = dirty_,
+                                   .compress = false,
+                                   .offset = off,
+                                   .size = cnt,
+                                   .oldValues = {},
+                                   .oldStripes = {},
+                                   .target = target});
+}
+
 bool HexBedDocument::compareEqual(bufoffset offset, bufoffset size,
                                   const_bytespan data) {
     bufsize z = 64, rr, r, c, o = offset;
@@ -308,11 +514,11 @@ bool HexBedDocument::compareEqual(bufoffset offset, bufoffset size,
     return true;
 }
 
-SearchResult HexBedDocument::searchForward(HexBedTask& task, bufoffset start,
-                                           bufoffset end, const_bytespan data) {
+template <typename Reader, typename Stop>
+static SearchResult searchForwardBlocks(Reader&& read, Stop&& stop,
+                                        bufoffset start, bufoffset end,
+                                        const_bytespan data) {
     bufsize r, rr, o = start, z = data.size(), c, hc;
-    if (start >= end) return SearchResult{};
-    if (!z) return SearchResult{SearchResultType::Full, z, start};
     bufsize mins = getMinimalSearchBufferSize(z),
             prefs = getPreferredSearchBufferSize(z);
     byte* bp = new (std::nothrow) byte[(c = prefs)];
@@ -328,12 +534,14 @@ SearchResult HexBedDocument::searchForward(HexBedTask& task, bufoffset start,
 
     SearchResult pres{};
     while ((rr = std::min(end - o, hc)), (r = read(o, bytespan(flip, rr)))) {
-        if (task.isCancelled()) break;
+        if (stop()) break;
         if (pres.type == SearchResultType::Partial) {
+            // the offset is within the previous block
             pres = searchFullForward(hc, flippers[flipindex], r, flip, z, si,
                                      pres.offset);
             if (pres)
-                return SearchResult{SearchResultType::Full, o + pres.offset, z};
+                return SearchResult{SearchResultType::Full,
+                                    o - hc + pres.offset, z};
         }
         pres = searchPartialForward(r, flip, z, si, r == hc);
         if (pres.type == SearchResultType::Full)
@@ -348,12 +556,11 @@ SearchResult HexBedDocument::searchForward(HexBedTask& task, bufoffset start,
     return SearchResult{};
 }
 
-SearchResult HexBedDocument::searchBackward(HexBedTask& task, bufoffset start,
-                                            bufoffset end,
-                                            const_bytespan data) {
+template <typename Reader, typename Stop>
+static SearchResult searchBackwardBlocks(Reader&& read, Stop&& stop,
+                                         bufoffset start, bufoffset end,
+                                         const_bytespan data) {
     bufsize r, rr, o = end, z = data.size(), c, hc;
-    if (start >= end) return SearchResult{};
-    if (!z) return SearchResult{SearchResultType::Full, end};
     bufsize mins = getMinimalSearchBufferSize(z),
             prefs = getPreferredSearchBufferSize(z);
     byte* bp = new (std::nothrow) byte[(c = prefs)];
@@ -370,16 +577,17 @@ SearchResult HexBedDocument::searchBackward(HexBedTask& task, bufoffset start,
     SearchResult pres{};
     while ((rr = std::min(o - start, hc)) &&
            rr == (r = read(o - rr, bytespan(flip, rr)))) {
-        if (task.isCancelled()) break;
+        if (stop()) break;
         o -= r;
         if (pres.type == SearchResultType::Partial) {
+            // the offset is within the previous block, which follows this one
             pres = searchFullBackward(hc, flippers[flipindex], r, flip, z, si,
                                       pres.offset);
             if (pres)
                 return SearchResult{SearchResultType::Full,
-                                    o + pres.offset - z + 1, z};
+                                    o + r + pres.offset - z + 1, z};
         }
-        pres = searchPartialBackward(r, flip, z, si, o > 0);
+        pres = searchPartialBackward(r, flip, z, si, o > start);
         if (pres.type == SearchResultType::Full)
             return SearchResult{SearchResultType::Full, o + pres.offset - z + 1,
                                 z};
@@ -391,6 +599,117 @@ SearchResult HexBedDocument::searchBackward(HexBedTask& task, bufoffset start,
     return SearchResult{};
 }
 
+#if HEXBED_MULTITHREADED
+// ranges shorter than this are not worth splitting between threads
+constexpr bufsize PARALLEL_SEARCH_MIN = 16ULL << 20;
+constexpr bufsize PARALLEL_SEARCH_CHUNK = 4ULL << 20;
+
+static unsigned searchThreadCount(bufsize range) {
+    if (range < PARALLEL_SEARCH_MIN) return 1;
+    unsigned n = std::thread::hardware_concurrency();
+    bufsize chunks =
+        (range + PARALLEL_SEARCH_CHUNK - 1) / PARALLEL_SEARCH_CHUNK;
+    return static_cast<unsigned>(std::min<bufsize>(n ? n : 1, chunks));
+}
+
+// splits [start, end) into chunks that overlap by one byte less than the
+// needle, so that every match fits entirely into at least one of them.
+// chunk 0 is the one searched first (at the start for forward searches,
+// at the end for backward), and the match from the lowest-numbered chunk
+// that has one wins, so later chunks give up as soon as an earlier one hits
+template <bool backward>
+static SearchResult searchParallel(const HexBedDocument& doc, HexBedTask& task,
+                                   bufoffset start, bufoffset end,
+                                   const_bytespan data, unsigned threads) {
+    bufsize z = data.size(), span = PARALLEL_SEARCH_CHUNK + z - 1;
+    std::size_t chunks = (end - start + PARALLEL_SEARCH_CHUNK - 1) /
+                         PARALLEL_SEARCH_CHUNK;
+    std::vector<SearchResult> results(chunks);
+    std::atomic<std::size_t> next{0}, best{chunks};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex readLock;
+    auto reader = [&](bufoffset o, bytespan b) {
+        std::lock_guard lock(readLock);
+        return doc.read(o, b);
+    };
+    auto worker = [&]() {
+        try {
+            std::size_t i;
+            while ((i = next++) < chunks && i < best.load() && !failed) {
+                auto stop = [&]() {
+                    return task.isCancelled() || failed || best.load() < i;
+                };
+                bufsize k = i * PARALLEL_SEARCH_CHUNK;
+                SearchResult res;
+                if (backward) {
+                    bufoffset hi = end - k;
+                    bufoffset lo = hi - start > span ? hi - span : start;
+                    res = searchBackwardBlocks(reader, stop, lo, hi, data);
+                } else {
+                    bufoffset lo = start + k;
+                    bufoffset hi = end - lo > span ? lo + span : end;
+                    res = searchForwardBlocks(reader, stop, lo, hi, data);
+                }
+                if (res) {
+                    results[i] = res;
+                    std::size_t prev = best.load();
+                    while (i < prev && !best.compare_exchange_weak(prev, i))
+                        ;
+                }
+            }
+        } catch (...) {
+            if (!failed.exchange(true)) error = std::current_exception();
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    try {
+        for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    } catch (...) {
+        failed = true;
+        for (std::thread& t : pool) t.join();
+        throw;
+    }
+    worker();
+    for (std::thread& t : pool) t.join();
+    if (error) std::rethrow_exception(error);
+    std::size_t i = best.load();
+    return i < chunks ? results[i] : SearchResult{};
+}
+#endif
+
+SearchResult HexBedDocument::searchForward(HexBedTask& task, bufoffset start,
+                                           bufoffset end, const_bytespan data) {
+    bufsize z = data.size();
+    if (start >= end) return SearchResult{};
+    if (!z) return SearchResult{SearchResultType::Full, z, start};
+#if HEXBED_MULTITHREADED
+    unsigned threads = searchThreadCount(end - start);
+    if (threads > 1)
+        return searchParallel<false>(*this, task, start, end, data, threads);
+#endif
+    return searchForwardBlocks(
+        [this](bufoffset o, bytespan b) { return read(o, b); },
+        [&task]() { return task.isCancelled(); }, start, end, data);
+}
+
+SearchResult HexBedDocument::searchBackward(HexBedTask& task, bufoffset start,
+                                            bufoffset end,
+                                            const_bytespan data) {
+    bufsize z = data.size();
+    if (start >= end) return SearchResult{};
+    if (!z) return SearchResult{SearchResultType::Full, end};
+#if HEXBED_MULTITHREADED
+    unsigned threads = searchThreadCount(end - start);
+    if (threads > 1)
+        return searchParallel<true>(*this, task, start, end, data, threads);
+#endif
+    return searchBackwardBlocks(
+        [this](bufoffset o, bytespan b) { return read(o, b); },
+        [&task]() { return task.isCancelled(); }, start, end, data);
+}
+
 SearchResult HexBedDocument::searchForwardFull(HexBedTask& task,
                                                bufoffset start, bool wrap,
                                                const_bytespan data) {
@@ -418,6 +737,179 @@ SearchResult HexBedDocument::searchBackwardFull(HexBedTask& task,
     return res;
 }
 
+void HexBedDocument::searchAll(HexBedTask& task, bufoffset start,
+                               bufoffset end, const_bytespan data,
+                               const std::function<void(bufoffset)>& found) {
+    bufsize r, rr, o = start, z = data.size(), c;
+    if (!z || start >= end || end - start < z) return;
+    bufsize mins = getMinimalSearchBufferSize(z),
+            prefs = getPreferredSearchBufferSize(z);
+    byte* bp = new (std::nothrow) byte[(c = prefs)];
+    if (!bp) bp = new byte[(c = mins)];
+    std::unique_ptr<byte[]> buffer(bp);
+    const byte* si = data.data();
+
+    // consecutive blocks overlap by z - 1 bytes, so that every match is
+    // found whole in exactly one of them
+    while ((rr = std::min(end - o, c)) >= z &&
+           (r = read(o, bytespan(bp, rr))) >= z) {
+        if (task.isCancelled()) break;
+        bufsize p = 0;
+        SearchResult res;
+        while (r - p >= z &&
+               (res = searchPartialForward(r - p, bp + p, z, si, false))) {
+            found(o + p + res.offset);
+            p += res.offset + 1;
+        }
+        if (r < rr || o + r >= end) break;
+        o += r - z + 1;
+    }
+}
+
+void HexBedDocument::searchMulti(HexBedTask& task, bufoffset start,
+                                 bufoffset end, const MultiPattern& patterns,
+                                 MultiPattern::State& state,
+                                 const MultiPattern::Callback& found) {
+    bufsize r, rr, o = start, c = getPreferredSearchBufferSize(1);
+    std::unique_ptr<byte[]> buffer = std::make_unique<byte[]>(c);
+    byte* bp = buffer.get();
+    while ((rr = std::min(end - o, c)) && (r = read(o, bytespan(bp, rr)))) {
+        if (task.isCancelled()) break;
+        state = patterns.scan(state, bp, r, o, found);
+        if (r < rr) break;
+        o += r;
+    }
+}
+
+void HexBedDocument::searchNumeric(HexBedTask& task, bufoffset start,
+                                   bufoffset end, const NumericQuery& query,
+                                   const NumericQuery::Callback& found) {
+    bufsize r, rr, o = start, z = query.width(),
+                   c = getPreferredSearchBufferSize(z);
+    if (start >= end || end - start < z) return;
+    std::unique_ptr<byte[]> buffer = std::make_unique<byte[]>(c);
+    byte* bp = buffer.get();
+    // blocks overlap by z - 1 bytes, as in searchAll
+    while ((rr = std::min(end - o, c)) >= z &&
+           (r = read(o, bytespan(bp, rr))) >= z) {
+        if (task.isCancelled()) break;
+        query.scan(bp, r, o, found);
+        if (r < rr || o + r >= end) break;
+        o += r - z + 1;
+    }
+}
+
+constexpr bufsize APPROXIMATE_SEARCH_CHUNK = 1ULL << 20;
+
+// the order the results are ranked in
+static bool approximateBefore(const ApproximateMatch& a,
+                              const ApproximateMatch& b) noexcept {
+    if (a.distance != b.distance) return a.distance < b.distance;
+    if (a.offset != b.offset) return a.offset < b.offset;
+    return a.length < b.length;
+}
+
+static bool approximateSame(const ApproximateMatch& a,
+                            const ApproximateMatch& b) noexcept {
+    return a.offset + a.length == b.offset + b.length &&
+           a.distance == b.distance;
+}
+
+bool HexBedDocument::searchApproximate(
+    HexBedTask& task, bufoffset start, bufoffset end,
+    const ApproximatePattern& pattern, std::size_t limit,
+    std::vector<ApproximateMatch>& results) {
+    results.clear();
+    if (start >= end) return true;
+    bufsize reach = pattern.reach();
+    std::size_t chunks = (end - start + APPROXIMATE_SEARCH_CHUNK - 1) /
+                         APPROXIMATE_SEARCH_CHUNK;
+    std::atomic<std::size_t> next{0};
+    std::atomic<bufsize> done{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex readLock, keepLock;
+    // the best limit matches so far, as a heap with the worst on top. the
+    // whole range is always searched, so that the results do not depend on
+    // the order in which the chunks are done
+    std::size_t count = 0;
+    std::function<bool()> stop = [&]() {
+        return task.isCancelled() || failed;
+    };
+    auto keep = [&](const std::vector<ApproximateMatch>& found) {
+        std::lock_guard lock(keepLock);
+        count += found.size();
+        for (const ApproximateMatch& m : found) {
+            if (results.size() < limit) {
+                results.push_back(m);
+                std::push_heap(results.begin(), results.end(),
+                               approximateBefore);
+            } else if (limit && approximateBefore(m, results.front())) {
+                std::pop_heap(results.begin(), results.end(),
+                              approximateBefore);
+                results.back() = m;
+                std::push_heap(results.begin(), results.end(),
+                               approximateBefore);
+            }
+        }
+    };
+    // every chunk starts reach bytes early, so that it finds the matches
+    // ending within it whole
+    auto worker = [&]() {
+        try {
+            std::vector<byte> buffer;
+            std::vector<ApproximateMatch> found;
+            std::size_t i;
+            while ((i = next++) < chunks && !stop()) {
+                bufoffset lo = start + i * APPROXIMATE_SEARCH_CHUNK;
+                bufoffset hi = end - lo > APPROXIMATE_SEARCH_CHUNK
+                                   ? lo + APPROXIMATE_SEARCH_CHUNK
+                                   : end;
+                bufoffset from = lo - start > reach ? lo - reach : start;
+                buffer.resize(hi - from);
+                bufsize r;
+                {
+                    std::lock_guard lock(readLock);
+                    r = read(from, bytespan(buffer.data(), buffer.size()));
+                }
+                found.clear();
+                pattern.scan(buffer.data(), r, lo - from, from, found, stop);
+                keep(found);
+                task.progress(done += hi - lo);
+            }
+        } catch (...) {
+            if (!failed.exchange(true)) error = std::current_exception();
+        }
+    };
+#if HEXBED_MULTITHREADED
+    unsigned threads = std::thread::hardware_concurrency();
+    threads = static_cast<unsigned>(std::min<bufsize>(threads, chunks));
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    try {
+        for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    } catch (...) {
+        failed = true;
+        for (std::thread& t : pool) t.join();
+        throw;
+    }
+#endif
+    worker();
+#if HEXBED_MULTITHREADED
+    for (std::thread& t : pool) t.join();
+#endif
+    if (error) std::rethrow_exception(error);
+
+    std::sort_heap(results.begin(), results.end(), approximateBefore);
+    // a run of edit distance matches that crosses a chunk boundary is
+    // reported on both sides of it, which are kept as separate matches
+    // unless they end at the same place with the same distance
+    results.erase(std::unique(results.begin(), results.end(),
+                              approximateSame),
+                  results.end());
+    return count <= limit;
+}
+
 template <bool insert, bool adjust>
 void HexBedUndoEntry::replant(HexBedDocument& doc) {
     static_assert(!insert || !adjust);
@@ -427,48 +919,72 @@ void HexBedUndoEntry::replant(HexBedDocument& doc) {
     bufsize n = oldValues.size();
     bufsize cnt = size;
     bufsize oi = oldStripes.size();
-    for (bufsize i = 0; i < oi; ++i) {
-        const auto& pair = oldStripes[i];
-        bufsize z = pair.size();
+    // the range may now hold pieces from elsewhere, so reverting the
+    // overlay in place is not enough to bring back an original stripe
+    auto restore = [&doc](bufsize o, bufsize z, bufsize from) {
+        doc.treble_.remove(o, z);
+        doc.treble_.reinsert(o, z, from);
+    };
+    auto plant = [&](bool orig, bufsize z, bufsize src) {
+        // the bytes of original stripes are not stored
+        bool stored = !orig;
         if constexpr (adjust) {
             if (!ins && cnt < z) {
                 bufsize ll = cnt;
-                if (pair.original())
-                    doc.treble_.revert(off, ll);
+                if (orig)
+                    restore(off, ll, src);
                 else
                     doc.treble_.replace(off, ll, si);
-                si += ll, off += ll, n -= ll, cnt -= ll;
+                if (stored) si += ll, n -= ll;
+                off += ll, cnt -= ll, src += ll;
                 z -= ll;
                 ins = true;
             }
         }
-        if (pair.original()) {
-            ++i;
+        if (orig) {
             if (ins)
-                doc.treble_.reinsert(off, z, oldStripes[i].raw());
+                doc.treble_.reinsert(off, z, src);
             else
-                doc.treble_.revert(off, z);
+                restore(off, z, src);
         } else {
             if (ins)
                 doc.treble_.insert(off, z, si);
             else
                 doc.treble_.replace(off, z, si);
         }
-        si += z, off += z, n -= z, cnt -= z;
-    }
-    if (n) {
-        if (ins)
-            doc.treble_.insert(off, n, si);
-        else
-            doc.treble_.replace(off, n, si);
+        if (stored) si += z, n -= z;
+        off += z, cnt -= z;
+    };
+    for (bufsize i = 0; i < oi; ++i) {
+        const auto& pair = oldStripes[i];
+        bool orig = pair.original();
+        plant(orig, pair.size(), orig ? oldStripes[++i].raw() : 0);
     }
+    // bytes without a stripe, such as once the stripes have been detached
+    if (n) plant(false, n, 0);
     if constexpr (adjust) {
         if (!ins && cnt) doc.treble_.remove(off, cnt);
     }
 }
 
+bufoffset HexBedUndoEntry::moveStart() const noexcept {
+    return std::min(offset, target);
+}
+
+bufsize HexBedUndoEntry::moveSize() const noexcept {
+    return std::max(offset + size, target) - moveStart();
+}
+
+bufsize HexBedUndoEntry::oldSize() const noexcept {
+    bufsize n = oldValues.size();
+    bufsize oi = oldStripes.size();
+    for (bufsize i = 0; i < oi; ++i)
+        if (oldStripes[i].original()) n += oldStripes[i++].size();
+    return n;
+}
+
 byte HexBedUndoEntry::swapValue(HexBedDocument& doc) {
-    ByteReader reader(*doc.buffer_);
+    HexBedSourceReader reader(doc);
     return doc.treble_.readByte(reader, offset).value;
 }
 
@@ -476,7 +992,7 @@ HexBedUndoEntry::HexBedUndoEntrySwapRange HexBedUndoEntry::swapRange(
     HexBedDocument& doc, bool sameSize) {
     std::vector<byte> vecb;
     std::vector<HexBedUndoStripe> vecs;
-    UndoWriter writer(*doc.buffer_, vecb, vecs);
+    UndoWriter writer(vecb, vecs);
     [[maybe_unused]] bufsize z = doc.treble_.render(writer, offset, size);
     if (sameSize) HEXBED_ASSERT(z == size);
     return HexBedUndoEntrySwapRange{.oldValues = std::move(vecb),
@@ -519,24 +1035,33 @@ HexBedRange HexBedUndoEntry::undo(HexBedDocument& doc) {
     }
     case ReplaceDiffSize: {
         HexBedUndoEntrySwapRange range = swapRange(doc, false);
-        bufsize z = oldValues.size();
+        bufsize z = oldSize();
         replant<false, true>(doc);
-        size = z;
+        bufsize was = std::exchange(size, z);
         applySwapRange(range);
-        doc.context_->announceBytesChanged(&doc, offset);
+        doc.context_->announceBytesResized(&doc, offset, was, z);
         return HexBedRange{offset, z};
     }
     case Insert: {
         HexBedUndoEntrySwapRange range = swapRange(doc, true);
         doc.treble_.remove(offset, size);
         applySwapRange(range);
-        doc.context_->announceBytesChanged(&doc, offset);
+        doc.context_->announceBytesResized(&doc, offset, size, 0);
         return HexBedRange{offset, 0};
     }
     case Delete:
         replant<true, false>(doc);
-        doc.context_->announceBytesChanged(&doc, offset);
-        return HexBedRange{offset, oldValues.size()};
+        doc.context_->announceBytesResized(&doc, offset, 0, oldSize());
+        return HexBedRange{offset, oldSize()};
+    case Move: {
+        // move the block back from where it ended up
+        bufoffset now = target > offset ? target - size : target;
+        doc.trebleCopy(now, size, offset < now ? offset : offset + size,
+                       true);
+        doc.context_->announceBytesResized(&doc, moveStart(), moveSize(),
+                                           moveSize());
+        return HexBedRange{offset, size};
+    }
     }
     return HexBedRange{};
 }
@@ -562,24 +1087,31 @@ HexBedRange HexBedUndoEntry::redo(HexBedDocument& doc) {
     }
     case ReplaceDiffSize: {
         HexBedUndoEntrySwapRange range = swapRange(doc, false);
-        bufsize z = oldValues.size();
+        bufsize z = oldSize();
         replant<false, true>(doc);
-        size = z;
+        bufsize was = std::exchange(size, z);
         applySwapRange(range);
-        doc.context_->announceBytesChanged(&doc, offset);
+        doc.context_->announceBytesResized(&doc, offset, was, z);
         return HexBedRange{offset, z};
     }
     case Insert:
         replant<true, false>(doc);
-        doc.context_->announceBytesChanged(&doc, offset);
-        return HexBedRange{offset, oldValues.size()};
+        doc.context_->announceBytesResized(&doc, offset, 0, oldSize());
+        return HexBedRange{offset, oldSize()};
     case Delete: {
         HexBedUndoEntrySwapRange range = swapRange(doc, true);
         doc.treble_.remove(offset, size);
         applySwapRange(range);
-        doc.context_->announceBytesChanged(&doc, offset);
+        doc.context_->announceBytesResized(&doc, offset, size, 0);
         return HexBedRange{offset, 0};
     }
+    case Move: {
+        bufoffset now = target > offset ? target - size : target;
+        doc.trebleCopy(offset, size, target, true);
+        doc.context_->announceBytesResized(&doc, moveStart(), moveSize(),
+                                           moveSize());
+        return HexBedRange{now, size};
+    }
     }
     return HexBedRange{};
 }
@@ -662,6 +1194,127 @@ static constexpr std::size_t best_align =
     std::max<std::size_t>(64, sizeof(std::max_align_t));
 #endif
 
+#if HEXBED_MULTITHREADED
+// ranges shorter than this are mapped on the task thread alone
+constexpr bufsize PARALLEL_MAP_MIN = 8ULL << 20;
+constexpr bufsize PARALLEL_MAP_CHUNK = 1ULL << 20;
+
+static unsigned mapThreadCount(bufsize range, bufsize mul) {
+    if (range < PARALLEL_MAP_MIN || mul > PARALLEL_MAP_CHUNK) return 1;
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+// the task thread reads chunks into a ring of buffers, workers map them in
+// any order, and the task thread writes them back in order. the treble is
+// only ever touched from the task thread
+template <typename ReadFn, typename WriteFn>
+static bool mapParallel(HexBedTask& task, ReadFn reader, WriteFn writer,
+                        bufoffset offset, bufsize size,
+                        const std::function<bool(bufoffset, bytespan)>& mapper,
+                        bufsize mul, unsigned threads) {
+    enum class SlotState { Free, Queued, Mapped, Failed };
+    struct Slot {
+        std::unique_ptr<byte[]> data;
+        bufoffset offset;
+        bufsize size;
+        SlotState state{SlotState::Free};
+    };
+    bufsize chunk = PARALLEL_MAP_CHUNK - PARALLEL_MAP_CHUNK % mul;
+    std::size_t ring = 2 * static_cast<std::size_t>(threads);
+    std::vector<Slot> slots(ring);
+    for (Slot& slot : slots) slot.data = std::make_unique<byte[]>(chunk);
+    std::deque<std::size_t> queue;
+    std::mutex lock;
+    std::condition_variable queued, mapped;
+    bool stop = false;
+
+    auto worker = [&]() {
+        std::unique_lock guard(lock);
+        for (;;) {
+            queued.wait(guard, [&]() { return stop || !queue.empty(); });
+            if (stop) return;
+            Slot& slot = slots[queue.front()];
+            queue.pop_front();
+            guard.unlock();
+            bool ok;
+            try {
+                ok = mapper(slot.offset, bytespan{slot.data.get(), slot.size});
+            } catch (...) {
+                ok = false;
+            }
+            guard.lock();
+            slot.state = ok ? SlotState::Mapped : SlotState::Failed;
+            mapped.notify_one();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    auto join = [&]() {
+        {
+            std::lock_guard guard(lock);
+            stop = true;
+        }
+        queued.notify_all();
+        for (std::thread& t : pool) t.join();
+    };
+    try {
+        for (unsigned t = 0; t < threads; ++t) pool.emplace_back(worker);
+    } catch (...) {
+        join();
+        throw;
+    }
+
+    bool ok = true, eof = false;
+    bufoffset o = offset;
+    bufsize n = size;
+    std::size_t head = 0, tail = 0;
+    try {
+        while (ok) {
+            while (!eof && n && tail - head < ring) {
+                Slot& slot = slots[tail % ring];
+                bufsize r = reader(o, bytespan{slot.data.get(),
+                                               std::min<bufsize>(n, chunk)});
+                if (!r) {
+                    eof = true;
+                    break;
+                }
+                slot.offset = o;
+                slot.size = r;
+                o += r;
+                n -= r;
+                std::lock_guard guard(lock);
+                slot.state = SlotState::Queued;
+                queue.push_back(tail++ % ring);
+                queued.notify_one();
+            }
+            if (head == tail) break;
+            Slot& slot = slots[head % ring];
+            {
+                std::unique_lock guard(lock);
+                mapped.wait(guard, [&]() {
+                    return slot.state != SlotState::Queued;
+                });
+            }
+            if (slot.state == SlotState::Failed || task.isCancelled()) {
+                ok = false;
+                break;
+            }
+            writer(slot.offset, const_bytespan{slot.data.get(), slot.size});
+            slot.state = SlotState::Free;
+            ++head;
+            task.progress(task.progress() + slot.size);
+        }
+    } catch (...) {
+        join();
+        throw;
+    }
+    join();
+    return ok;
+}
+#endif
+
 bool HexBedDocument::map(bufoffset offset, bufsize size,
                          std::function<bool(bufoffset, bytespan)> mapper,
                          bufsize mul) {
@@ -669,11 +1322,41 @@ bool HexBedDocument::map(bufoffset offset, bufsize size,
     bufsize z = HexBedDocument::size();
     if (offset + size > z) return false;
     bool ok = true;
+#if HEXBED_MULTITHREADED
+    unsigned threads = mapThreadCount(size, mul);
+    if (threads > 1) {
+        HexBedTask(context_.get(), size, true)
+            .run([this, offset, size, &mapper, mul, threads,
+                  &ok](HexBedTask& task) {
+                auto token = addUndoReplaceMany(offset, size);
+                try {
+                    ok = mapParallel(
+                        task,
+                        [this](bufoffset o, bytespan b) { return read(o, b); },
+                        [this](bufoffset o, const_bytespan b) {
+                            treble_.replace(o, b.size(), b.data());
+                        },
+                        offset, size, mapper, mul, threads);
+                } catch (...) {
+                    ok = false;
+                }
+                if (!ok)
+                    token.rollback(*this);
+                else {
+                    token.commit();
+                    dirty_ = true;
+                    context_->announceUndoChange(this);
+                    context_->announceBytesChanged(this, offset, size);
+                }
+            });
+        return ok;
+    }
+#endif
     alignas(std::max_align_t) byte bstack[BUFFER_SIZE];
     bufsize bs = sizeof(bstack);
     bufsize bc = std::bit_ceil<bufsize>(std::min<bufsize>(size, 1UL << 20));
     auto alignedDeleter = [](byte* ptr) {
-        operator delete(ptr, std::align_val_t(best_align));
+        operator delete[](ptr, std::align_val_t(best_align));
     };
     std::unique_ptr<byte[], decltype(alignedDeleter)> holder;
     byte* buf = nullptr;
@@ -704,7 +1387,6 @@ bool HexBedDocument::map(bufoffset offset, bufsize size,
                     break;
                 }
                 treble_.replace(o, r, b);
-                context_->announceBytesChanged(this, o, r);
                 o += r;
                 n -= r;
                 task.progress(task.progress() + r);
@@ -746,7 +1428,7 @@ bool HexBedDocument::pry(
         token.commit();
         dirty_ = true;
         context_->announceUndoChange(this);
-        context_->announceBytesChanged(this, offset);
+        context_->announceBytesResized(this, offset, size, off - offset);
     }
     return !task.isCancelled();
 }
@@ -788,7 +1470,7 @@ bool HexBedDocument::reverse(bufoffset offset, bufsize size) {
     bufsize bs = sizeof(bstack);
     bufsize bc = std::bit_ceil<bufsize>(std::min<bufsize>(size, 1UL << 20));
     auto alignedDeleter = [](byte* ptr) {
-        operator delete(ptr, std::align_val_t(best_align));
+        operator delete[](ptr, std::align_val_t(best_align));
     };
     std::unique_ptr<byte[], decltype(alignedDeleter)> holder;
     byte* buf = nullptr;
@@ -890,7 +1572,7 @@ bool HexBedDocument::replace(bufoffset offset, bufsize size, bufsize newsize,
         token.commit();
         dirty_ = true;
         context_->announceUndoChange(this);
-        context_->announceBytesChanged(this, offset);
+        context_->announceBytesResized(this, offset, size, newsize);
         return true;
     }
 }
@@ -910,7 +1592,7 @@ bool HexBedDocument::replace(bufoffset offset, bufsize size,
         token.commit();
         dirty_ = true;
         context_->announceUndoChange(this);
-        context_->announceBytesChanged(this, offset);
+        context_->announceBytesResized(this, offset, size, newsize);
         return true;
     }
 }
@@ -929,7 +1611,7 @@ bool HexBedDocument::replace(bufoffset offset, bufsize size, bufsize nsize,
         token.commit();
         dirty_ = true;
         context_->announceUndoChange(this);
-        context_->announceBytesChanged(this, offset);
+        context_->announceBytesResized(this, offset, size, nsize);
         return true;
     }
 }
@@ -942,7 +1624,7 @@ bool HexBedDocument::insert(bufoffset offset, bufsize size, byte value) {
     token.commit();
     dirty_ = true;
     context_->announceUndoChange(this);
-    context_->announceBytesChanged(this, offset);
+    context_->announceBytesResized(this, offset, 0, size);
     return true;
 }
 
@@ -955,7 +1637,7 @@ bool HexBedDocument::insert(bufoffset offset, bufsize nsize, bufsize ssize,
     token.commit();
     dirty_ = true;
     context_->announceUndoChange(this);
-    context_->announceBytesChanged(this, offset);
+    context_->announceBytesResized(this, offset, 0, nsize);
     return true;
 }
 
@@ -967,7 +1649,7 @@ bool HexBedDocument::insert(bufoffset offset, const_bytespan data) {
     token.commit();
     dirty_ = true;
     context_->announceUndoChange(this);
-    context_->announceBytesChanged(this, offset);
+    context_->announceBytesResized(this, offset, 0, data.size());
     return true;
 }
 
@@ -978,7 +1660,215 @@ bool HexBedDocument::remove(bufoffset offset, bufsize size) {
     token.commit();
     dirty_ = true;
     context_->announceUndoChange(this);
-    context_->announceBytesChanged(this, offset);
+    context_->announceBytesResized(this, offset, size, 0);
+    return true;
+}
+
+HexBedSlice HexBedDocument::slice(bufoffset offset, bufsize size) {
+    struct SliceWriter {
+        HexBedDocument& doc;
+        HexBedSlice& slice;
+
+        void raw(bufsize n, const byte* r) {
+            bufsize z = slice.data.size();
+            slice.data.insert(slice.data.end(), r, r + n);
+            if (!slice.pieces.empty() && !slice.pieces.back().source)
+                slice.pieces.back().size += n;
+            else
+                slice.pieces.push_back(HexBedSlice::Piece{n, z, nullptr});
+        }
+        void copy(bufsize n, bufsize o) {
+            if (o < SOURCE_BASE) {
+                slice.pieces.push_back(
+                    HexBedSlice::Piece{n, o, doc.ownSource()});
+            } else {
+                auto it = std::upper_bound(
+                    doc.sources_.begin(), doc.sources_.end(), o,
+                    [](bufoffset o, const SourceEntry& e) {
+                        return o < e.base;
+                    });
+                --it;
+                slice.pieces.push_back(
+                    HexBedSlice::Piece{n, o - it->base, it->source});
+            }
+        }
+    };
+    HexBedSlice result;
+    SliceWriter writer{*this, result};
+    treble_.render(writer, offset, size);
+    return result;
+}
+
+void HexBedDocument::trebleInsertSlice(bufoffset offset,
+                                       const HexBedSlice& slice) {
+    for (const HexBedSlice::Piece& piece : slice.pieces) {
+        if (!piece.source)
+            treble_.insert(offset, piece.size,
+                           slice.data.data() + piece.offset);
+        else if (piece.source == ownSource_)
+            treble_.reinsert(offset, piece.size, piece.offset);
+        else
+            treble_.reinsert(offset, piece.size,
+                             sourceBase(piece.source) + piece.offset);
+        offset += piece.size;
+    }
+}
+
+bool HexBedDocument::insert(bufoffset offset, const HexBedSlice& slice) {
+    if (readOnly()) return false;
+    bufsize n = slice.size();
+    if (!n) return true;
+    grow();
+    auto token = addUndoInsert(offset, n);
+    trebleInsertSlice(offset, slice);
+    token.commit();
+    dirty_ = true;
+    context_->announceUndoChange(this);
+    context_->announceBytesResized(this, offset, 0, n);
+    return true;
+}
+
+bool HexBedDocument::replace(bufoffset offset, bufsize size,
+                             const HexBedSlice& slice) {
+    bufsize newsize = slice.size();
+    if (!size) {
+        return insert(offset, slice);
+    } else if (!newsize) {
+        return remove(offset, size);
+    } else {
+        if (readOnly()) return false;
+        auto token = addUndoReplaceDiffSize(offset, size, newsize);
+        treble_.remove(offset, size);
+        trebleInsertSlice(offset, slice);
+        token.commit();
+        dirty_ = true;
+        context_->announceUndoChange(this);
+        context_->announceBytesResized(this, offset, size, newsize);
+        return true;
+    }
+}
+
+bool HexBedDocument::insertFile(bufoffset offset, bufsize size,
+                                const std::filesystem::path& filename) {
+    if (readOnly()) return false;
+    std::shared_ptr<HexBedSource> source = openFileSource(filename);
+    HexBedSlice slice;
+    bufsize n = source->buffer->size();
+    if (n) slice.pieces.push_back(HexBedSlice::Piece{n, 0, std::move(source)});
+    return replace(offset, size, slice);
+}
+
+// collects the pieces of a range, so that they can be put back after
+// the tree has changed
+struct PieceWriter {
+    struct Piece {
+        bufsize size;
+        bufoffset offset;
+        bool raw;
+    };
+    std::vector<Piece> pieces;
+    std::vector<byte> data;
+
+    void raw(bufsize n, const byte* r) {
+        pieces.push_back(Piece{n, data.size(), true});
+        data.insert(data.end(), r, r + n);
+    }
+    void copy(bufsize n, bufsize o) { pieces.push_back(Piece{n, o, false}); }
+};
+
+void HexBedDocument::trebleCopy(bufoffset offset, bufsize size,
+                                bufoffset target, bool move) {
+    PieceWriter writer;
+    treble_.render(writer, offset, size);
+    if (move) {
+        treble_.remove(offset, size);
+        if (target > offset) target -= size;
+    }
+    for (const PieceWriter::Piece& piece : writer.pieces) {
+        if (piece.raw)
+            treble_.insert(target, piece.size,
+                           writer.data.data() + piece.offset);
+        else
+            treble_.reinsert(target, piece.size, piece.offset);
+        target += piece.size;
+    }
+}
+
+bool HexBedDocument::move(bufoffset offset, bufsize size, bufoffset target) {
+    if (readOnly()) return false;
+    if (target > offset && target < offset + size) return false;
+    if (!size || target == offset || target == offset + size) return true;
+    auto token = addUndoMove(offset, size, target);
+    trebleCopy(offset, size, target, true);
+    token.commit();
+    dirty_ = true;
+    context_->announceUndoChange(this);
+    bufoffset lo = std::min(offset, target);
+    bufsize n = std::max(offset + size, target) - lo;
+    context_->announceBytesResized(this, lo, n, n);
+    return true;
+}
+
+bool HexBedDocument::duplicate(bufoffset offset, bufsize size,
+                               bufoffset target) {
+    if (readOnly()) return false;
+    if (!size) return true;
+    grow();
+    auto token = addUndoInsert(target, size);
+    trebleCopy(offset, size, target, false);
+    token.commit();
+    dirty_ = true;
+    context_->announceUndoChange(this);
+    context_->announceBytesResized(this, target, 0, size);
+    return true;
+}
+
+bool HexBedDocument::splice(const std::vector<HexBedSplice>& splices) {
+    if (readOnly()) return false;
+    if (splices.empty()) return true;
+    bufoffset lo = splices.front().offset;
+    bufoffset hi = splices.back().offset + splices.back().size;
+    bufsize newsize = hi - lo;
+    for (const HexBedSplice& s : splices) newsize += s.data.size() - s.size;
+    grow();
+    auto token = addUndoReplaceDiffSize(lo, hi - lo, newsize);
+    PieceWriter writer;
+    treble_.render(writer, lo, hi - lo);
+    treble_.remove(lo, hi - lo);
+
+    // rebuild the range front to back from the old pieces and the new data
+    auto piece = writer.pieces.cbegin();
+    bufsize skip = 0;
+    bufoffset src = lo, dst = lo;
+    auto carry = [&](bufsize n, bool keep) {
+        while (n) {
+            bufsize k = std::min(n, piece->size - skip);
+            if (keep) {
+                if (piece->raw)
+                    treble_.insert(dst, k,
+                                   writer.data.data() + piece->offset + skip);
+                else
+                    treble_.reinsert(dst, k, piece->offset + skip);
+                dst += k;
+            }
+            n -= k, skip += k;
+            if (skip == piece->size) ++piece, skip = 0;
+        }
+    };
+    for (const HexBedSplice& s : splices) {
+        HEXBED_ASSERT(s.offset >= src, "splices must be sorted");
+        carry(s.offset - src, true);
+        carry(s.size, false);
+        if (!s.data.empty()) {
+            treble_.insert(dst, s.data.size(), s.data.data());
+            dst += s.data.size();
+        }
+        src = s.offset + s.size;
+    }
+    token.commit();
+    dirty_ = true;
+    context_->announceUndoChange(this);
+    context_->announceBytesResized(this, lo, hi - lo, newsize);
     return true;
 }
 
@@ -994,17 +1884,47 @@ bool HexBedDocument::remove(bufoffset offset) { return remove(offset, 1); }
 
 bufsize HexBedDocument::size() const noexcept { return treble_.size(); }
 
-bool HexBedDocument::filed() const noexcept { return !filename_.empty(); }
+bool HexBedDocument::filed() const noexcept {
+    return !filename_.empty() && buffer_->seekable();
+}
+
+bool HexBedDocument::growing() const noexcept { return buffer_->growing(); }
 
 bool HexBedDocument::unsaved() const noexcept { return dirty_; }
 
 std::filesystem::path HexBedDocument::path() const { return filename_; }
 
+const std::vector<std::filesystem::path>& HexBedDocument::parts()
+    const noexcept {
+    return parts_;
+}
+
 bool HexBedDocument::readOnly() const noexcept { return readOnly_; }
 
+bufsize HexBedDocument::follow() {
+    bufsize was = buffer_->size(), now = buffer_->refresh();
+    if (now < was) {
+        // a truncated file can only be picked up again from the start, and
+        // the edits and the undo history may refer to the bytes now gone
+        if (dirty_ || canUndo() || canRedo())
+            throw std::runtime_error("the file was truncated");
+        discard();
+        return 0;
+    }
+    if (now == was) return 0;
+    // new data is not an edit, so it gets no undo entry and does not
+    // make the document dirty
+    bufsize z = treble_.size(), n = now - was;
+    treble_.reinsert(z, n, was);
+    context_->announceBytesChanged(this, z);
+    return n;
+}
+
 void HexBedDocument::discard() {
-    buffer_ = bufferOpen(filename_);
+    buffer_ = bufferOpen(*context_, filename_, parts_);
+    ownSource_ = nullptr;
     treble_.clear(buffer_->size());
+    pruneSources();
     dirty_ = false;
     context_->announceFileChanged(this);
 }
@@ -1012,11 +1932,18 @@ void HexBedDocument::discard() {
 void HexBedDocument::commit() {
     if (readOnly()) return;
     truncateUndo();
-    for (auto& undoEntry : undos_) undoEntry.detach();
+    for (auto& undoEntry : undos_) undoEntry.detach(*this);
     auto lambda = [this](VirtualBuffer& vbuf) {
-        treble_.write(vbuf, 0, BUFSIZE_MAX);
+        HexBedSourceReader reader(*this);
+        HexBedSourceWriteBuffer wbuf(vbuf, reader);
+        treble_.write(wbuf, 0, BUFSIZE_MAX);
     };
-    if (treble_.isCleanOverlay())
+    // files referenced by other documents must not be written in place
+    if (ownSource_.use_count() == 1) ownSource_ = nullptr;
+    bool pinned = false;
+    for (const std::filesystem::path& file : ownFiles())
+        pinned = pinned || isSourcePinned(file);
+    if (treble_.isCleanOverlay() && !pinned)
         buffer_->writeOverlay(*context_, lambda, filename_);
     else
         buffer_->write(*context_, lambda, filename_);
@@ -1024,24 +1951,76 @@ void HexBedDocument::commit() {
 }
 
 void HexBedDocument::commitAs(const std::filesystem::path& filename) {
+    if (isSourcePinned(filename))
+        throw std::runtime_error("the file is referenced by an open document");
     truncateUndo();
-    for (auto& undoEntry : undos_) undoEntry.detach();
+    for (auto& undoEntry : undos_) undoEntry.detach(*this);
     buffer_->writeNew(
         *context_,
-        [this](VirtualBuffer& vbuf) { treble_.write(vbuf, 0, BUFSIZE_MAX); },
+        [this](VirtualBuffer& vbuf) {
+            HexBedSourceReader reader(*this);
+            HexBedSourceWriteBuffer wbuf(vbuf, reader);
+            treble_.write(wbuf, 0, BUFSIZE_MAX);
+        },
         filename);
     filename_ = filename;
+    parts_.clear();
     readOnly_ = false;
     discard();
 }
 
 void HexBedDocument::commitTo(const std::filesystem::path& filename) {
+    if (isSourcePinned(filename))
+        throw std::runtime_error("the file is referenced by an open document");
     buffer_->writeCopy(
         *context_,
-        [this](VirtualBuffer& vbuf) { treble_.write(vbuf, 0, BUFSIZE_MAX); },
+        [this](VirtualBuffer& vbuf) {
+            HexBedSourceReader reader(*this);
+            HexBedSourceWriteBuffer wbuf(vbuf, reader);
+            treble_.write(wbuf, 0, BUFSIZE_MAX);
+        },
         filename);
 }
 
-void HexBedUndoEntry::detach() { oldStripes.clear(); }
+void HexBedUndoEntry::detach(HexBedDocument& doc) {
+    // references to the original file become invalid once it is saved, so
+    // read their bytes in now. secondary sources stay valid
+    std::vector<byte> values;
+    std::vector<HexBedUndoStripe> stripes;
+    bool keep = false;
+    const byte* si = oldValues.data();
+    const byte* se = si + oldValues.size();
+    bufsize oi = oldStripes.size();
+    HexBedSourceReader reader(doc);
+    for (bufsize i = 0; i < oi; ++i) {
+        const auto& pair = oldStripes[i];
+        bufsize z = pair.size();
+        if (!pair.original()) {
+            values.insert(values.end(), si, si + z);
+            si += z;
+            stripes.push_back(pair);
+        } else if (oldStripes[++i].raw() >= SOURCE_BASE) {
+            stripes.push_back(pair);
+            stripes.push_back(oldStripes[i]);
+            keep = true;
+        } else {
+            bufsize n = values.size();
+            values.resize(n + z);
+            if (reader.read(oldStripes[i].raw(), bytespan{values.data() + n,
+                                                          z}) < z)
+                throw std::runtime_error("could not read everything we need!");
+            stripes.emplace_back(false, z);
+        }
+    }
+    values.insert(values.end(), si, se);
+    values.shrink_to_fit();
+    oldValues = std::move(values);
+    if (keep) {
+        stripes.shrink_to_fit();
+        oldStripes = std::move(stripes);
+    } else {
+        oldStripes.clear();
+    }
+}
 
 };  // namespace hexbed
@@ -26,10 +26,14 @@
 #include <filesystem>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "common/logger.hh"
 #include "common/types.hh"
+#include "file/approxsearch.hh"
 #include "file/context.hh"
+#include "file/multisearch.hh"
+#include "file/numsearch.hh"
 #include "file/search.hh"
 #include "file/task.hh"
 #include "file/treble.hh"
@@ -57,10 +61,54 @@ class HexBedBuffer {
 
     virtual bufsize size() noexcept;
     virtual bufsize size() const noexcept = 0;
+    // re-checks the size of the underlying source, returns the new size
+    virtual bufsize refresh();
+    virtual bool readOnly() const noexcept;
+    // true while the source may still receive more data
+    virtual bool growing() const noexcept;
+    // false if the source cannot be written back in place
+    virtual bool seekable() const noexcept;
 
     virtual inline ~HexBedBuffer() noexcept {}
 };
 
+// piece table offsets at or above this refer to secondary sources
+// instead of the document's own buffer
+static constexpr bufoffset SOURCE_BASE = bufoffset(1) << 62;
+
+// data that a document can refer to without copying it, such as a file
+// inserted into it or the buffer of another document
+struct HexBedSource {
+    std::shared_ptr<HexBedBuffer> buffer;
+    // keeps the files behind the buffer from being overwritten in place
+    std::shared_ptr<void> pin;
+};
+
+std::shared_ptr<HexBedSource> openFileSource(
+    const std::filesystem::path& filename);
+bool isSourcePinned(const std::filesystem::path& filename);
+
+// a range of bytes that refers to its sources instead of copying them
+struct HexBedSlice {
+    struct Piece {
+        bufsize size;
+        bufoffset offset;
+        // if null, the piece is stored in data
+        std::shared_ptr<HexBedSource> source;
+    };
+    std::vector<Piece> pieces;
+    std::vector<byte> data;
+
+    bufsize size() const noexcept;
+};
+
+// a range to be replaced by new data as part of a batch
+struct HexBedSplice {
+    bufoffset offset;
+    bufsize size;
+    const_bytespan data;
+};
+
 class HexBedDocument;
 
 enum class HexBedUndoType {
@@ -69,7 +117,8 @@ enum class HexBedUndoType {
     ReplaceMany,
     ReplaceDiffSize,
     Insert,
-    Delete
+    Delete,
+    Move
 };
 
 static constexpr bufsize UNDOSTRIPE_MAX = BUFSIZE_MAX >> 1;
@@ -102,10 +151,16 @@ struct HexBedUndoEntry {
     bufsize size;
     std::vector<byte> oldValues;
     std::vector<HexBedUndoStripe> oldStripes;
+    // for Move, where the block was moved to (before the move)
+    bufsize target{0};
 
     HexBedRange undo(HexBedDocument& doc);
     HexBedRange redo(HexBedDocument& doc);
-    void detach();
+    void detach(HexBedDocument& doc);
+    bufsize oldSize() const noexcept;
+    // for Move, the range of bytes affected by the move
+    bufoffset moveStart() const noexcept;
+    bufsize moveSize() const noexcept;
 
   private:
     template <bool insert, bool adjust>
@@ -174,6 +229,10 @@ class HexBedDocument {
                    const std::filesystem::path& filename);
     HexBedDocument(std::shared_ptr<HexBedContext> context,
                    const std::filesystem::path& filename, bool readOnly);
+    // opens several files concatenated together as one document
+    HexBedDocument(std::shared_ptr<HexBedContext> context,
+                   const std::vector<std::filesystem::path>& parts,
+                   bool readOnly);
 
     HexBedDocument(HexBedDocument& copy) = delete;
     HexBedDocument(HexBedDocument&& move) = default;
@@ -200,6 +259,25 @@ class HexBedDocument {
     bool remove(bufoffset offset);
     bool remove(bufoffset offset, bufsize size);
 
+    // takes a slice of this document, which can be inserted into any
+    // document without copying the data from the original sources
+    HexBedSlice slice(bufoffset offset, bufsize size);
+    bool replace(bufoffset offset, bufsize size, const HexBedSlice& slice);
+    bool insert(bufoffset offset, const HexBedSlice& slice);
+    bool insertFile(bufoffset offset, bufsize size,
+                    const std::filesystem::path& filename);
+
+    // target is an offset before the move. neither copies the bytes from
+    // the original sources
+    bool move(bufoffset offset, bufsize size, bufoffset target);
+    bool duplicate(bufoffset offset, bufsize size, bufoffset target);
+    // replaces every range at once with a single undo entry. the ranges
+    // must be sorted and may not overlap
+    bool splice(const std::vector<HexBedSplice>& splices);
+
+    // replaces every byte in the range with what mapper makes of it. mapper
+    // may be called from several threads at once on disjoint chunks, in
+    // any order, and every chunk except the last is a multiple of mul
     bool map(bufoffset offset, bufsize size,
              std::function<bool(bufoffset, bytespan)> mapper, bufsize mul = 1);
     bool pry(
@@ -220,6 +298,28 @@ class HexBedDocument {
                                    const_bytespan data);
     SearchResult searchBackwardFull(HexBedTask& task, bufoffset start,
                                     bool wrap, const_bytespan data);
+    // calls found with the offset of every match within [start, end),
+    // in ascending order. matches may overlap
+    void searchAll(HexBedTask& task, bufoffset start, bufoffset end,
+                   const_bytespan data,
+                   const std::function<void(bufoffset)>& found);
+    // feeds [start, end) to the automaton, continuing from state, which
+    // is updated so that a later call can pick up from end
+    void searchMulti(HexBedTask& task, bufoffset start, bufoffset end,
+                     const MultiPattern& patterns, MultiPattern::State& state,
+                     const MultiPattern::Callback& found);
+    // calls found for every value in [start, end) that the query matches
+    void searchNumeric(HexBedTask& task, bufoffset start, bufoffset end,
+                       const NumericQuery& query,
+                       const NumericQuery::Callback& found);
+    // finds every match within [start, end) with at most the maximum
+    // number of differences, on several threads, ranked by distance and
+    // then by offset. returns false if there were more than limit matches,
+    // in which case only the first limit of them in that order are kept
+    bool searchApproximate(HexBedTask& task, bufoffset start, bufoffset end,
+                           const ApproximatePattern& pattern,
+                           std::size_t limit,
+                           std::vector<ApproximateMatch>& results);
 
     bool compareEqual(bufoffset offset, bufoffset size, const_bytespan data);
 
@@ -227,9 +327,15 @@ class HexBedDocument {
     bool filed() const noexcept;
     bool unsaved() const noexcept;
     std::filesystem::path path() const;
+    const std::vector<std::filesystem::path>& parts() const noexcept;
     bool canUndo() const noexcept;
     bool canRedo() const noexcept;
     bool readOnly() const noexcept;
+    bool growing() const noexcept;
+
+    // picks up data appended to the file since it was opened, and returns
+    // how much there was. a truncated file is reloaded if it is unedited
+    bufsize follow();
 
     void discard();
     void commit();
@@ -243,7 +349,8 @@ class HexBedDocument {
   private:
     std::shared_ptr<HexBedContext> context_;
     std::filesystem::path filename_;
-    std::unique_ptr<HexBedBuffer> buffer_;
+    std::vector<std::filesystem::path> parts_;
+    std::shared_ptr<HexBedBuffer> buffer_;
     std::deque<HexBedUndoEntry> undos_;
     bufsize undoDepth_{0};
     Treble treble_;
@@ -251,8 +358,24 @@ class HexBedDocument {
     bool readOnly_{false};
     bool noUndoLimit_{false};
 
+    struct SourceEntry {
+        bufoffset base;
+        std::shared_ptr<HexBedSource> source;
+    };
+    std::vector<SourceEntry> sources_;
+    std::shared_ptr<HexBedSource> ownSource_;
+
     void grow();
 
+    bufsize readSource(bufoffset offset, bytespan data) const;
+    bufoffset sourceBase(const std::shared_ptr<HexBedSource>& source);
+    void pruneSources();
+    std::shared_ptr<HexBedSource> ownSource();
+    void trebleInsertSlice(bufoffset offset, const HexBedSlice& slice);
+    void trebleCopy(bufoffset offset, bufsize size, bufoffset target,
+                    bool move);
+    std::vector<std::filesystem::path> ownFiles() const;
+
     bool trebleReplaceDiffSize(bufoffset offset, bufsize old, bufsize cnt,
                                byte v);
     bool trebleReplaceDiffSize(bufoffset offset, bufsize old, bufsize cnt,
@@ -266,9 +389,11 @@ class HexBedDocument {
     UndoToken addUndoReplaceDiffSize(bufsize off, bufsize old, bufsize cnt);
     UndoToken addUndoInsert(bufsize off, bufsize cnt);
     UndoToken addUndoRemove(bufsize off, bufsize cnt);
+    UndoToken addUndoMove(bufsize off, bufsize cnt, bufsize target);
     void truncateUndo();
 
     friend struct HexBedUndoEntry;
+    friend class HexBedSourceReader;
 };
 
 };  // namespace hexbed
@@ -0,0 +1,234 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/filesearch.cc -- impl for searching files on disk
+
+#include "file/filesearch.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "file/bfile.hh"
+#include "file/search.hh"
+
+namespace hexbed {
+
+// paths waiting for a worker; the walk pauses when this many are queued
+static constexpr std::size_t FILE_SEARCH_QUEUE = 1024;
+
+static bool globMatch(std::string_view glob, std::string_view name) {
+    // on a mismatch, the last * is retried one character further on
+    std::size_t g = 0, n = 0, star = std::string_view::npos, mark = 0;
+    while (n < name.size()) {
+        if (g < glob.size() && (glob[g] == '?' || glob[g] == name[n])) {
+            ++g, ++n;
+        } else if (g < glob.size() && glob[g] == '*') {
+            star = g++;
+            mark = n;
+        } else if (star != std::string_view::npos) {
+            g = star + 1;
+            n = ++mark;
+        } else {
+            return false;
+        }
+    }
+    while (g < glob.size() && glob[g] == '*') ++g;
+    return g == glob.size();
+}
+
+bool fileNameGlobMatch(std::string_view globs, std::string_view name) {
+    bool any = false;
+    while (!globs.empty()) {
+        std::size_t i = std::min(globs.find(';'), globs.size());
+        std::string_view glob = globs.substr(0, i);
+        while (!glob.empty() && glob.front() == ' ') glob.remove_prefix(1);
+        while (!glob.empty() && glob.back() == ' ') glob.remove_suffix(1);
+        if (!glob.empty()) {
+            if (globMatch(glob, name)) return true;
+            any = true;
+        }
+        globs.remove_prefix(std::min(i + 1, globs.size()));
+    }
+    return !any;
+}
+
+FileSearch::FileSearch(std::filesystem::path root, FileSearchFilter filter,
+                       std::vector<byte> needle)
+    : root_(std::move(root)),
+      filter_(std::move(filter)),
+      needle_(std::move(needle)) {
+#if HEXBED_MULTITHREADED
+    unsigned threads = std::max(1U, std::thread::hardware_concurrency());
+    workers_ = threads;
+    try {
+        threads_.emplace_back([this]() { walk(); });
+        for (unsigned t = 0; t < threads; ++t)
+            threads_.emplace_back([this]() { work(); });
+    } catch (...) {
+        cancel();
+        for (std::thread& t : threads_) t.join();
+        throw;
+    }
+#else
+    workers_ = 1;
+    walk();
+    work();
+#endif
+}
+
+FileSearch::~FileSearch() {
+    cancel();
+#if HEXBED_MULTITHREADED
+    for (std::thread& t : threads_) t.join();
+#endif
+}
+
+void FileSearch::cancel() {
+    {
+        std::lock_guard lock(mutex_);
+        cancelled_ = true;
+    }
+    notEmpty_.notify_all();
+    notFull_.notify_all();
+}
+
+bool FileSearch::running() const noexcept {
+    std::lock_guard lock(mutex_);
+    return workers_ > 0;
+}
+
+void FileSearch::take(std::vector<FileSearchHit>& out) {
+    std::lock_guard lock(mutex_);
+    out.insert(out.end(), std::make_move_iterator(hits_.begin()),
+               std::make_move_iterator(hits_.end()));
+    hits_.clear();
+}
+
+void FileSearch::push(std::filesystem::path path) {
+    std::unique_lock lock(mutex_);
+#if HEXBED_MULTITHREADED
+    notFull_.wait(lock, [this]() {
+        return queue_.size() < FILE_SEARCH_QUEUE || cancelled_;
+    });
+#endif
+    if (cancelled_) return;
+    queue_.push_back(std::move(path));
+    notEmpty_.notify_one();
+}
+
+void FileSearch::walk() {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator
+             it(root_, fs::directory_options::skip_permission_denied, ec),
+         end;
+         !ec && it != end && !cancelled_; it.increment(ec)) {
+        std::error_code fec;
+        if (!it->is_regular_file(fec)) continue;
+        bufsize size = it->file_size(fec);
+        if (fec || size < filter_.minimumSize || size > filter_.maximumSize)
+            continue;
+        if (!fileNameGlobMatch(filter_.glob, it->path().filename().string()))
+            continue;
+        push(it->path());
+    }
+    if (ec) ++failed_;
+    {
+        std::lock_guard lock(mutex_);
+        walking_ = false;
+    }
+    notEmpty_.notify_all();
+}
+
+void FileSearch::work() {
+    std::vector<byte> buffer(getPreferredSearchBufferSize(needle_.size()));
+    for (;;) {
+        std::filesystem::path path;
+        {
+            std::unique_lock lock(mutex_);
+            notEmpty_.wait(lock, [this]() {
+                return !queue_.empty() || !walking_ || cancelled_;
+            });
+            if (cancelled_ || queue_.empty()) break;
+            path = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        notFull_.notify_one();
+        try {
+            searchFile(path, buffer);
+        } catch (...) {
+            ++failed_;
+        }
+        ++searched_;
+    }
+    std::lock_guard lock(mutex_);
+    --workers_;
+}
+
+void FileSearch::report(std::vector<FileSearchHit>& hits) {
+    if (hits.empty()) return;
+    std::lock_guard lock(mutex_);
+    std::size_t n = std::min(hits.size(), MAXIMUM_HITS - hitCount_);
+    hits_.insert(hits_.end(), std::make_move_iterator(hits.begin()),
+                 std::make_move_iterator(hits.begin() + n));
+    hitCount_ += n;
+    hits.clear();
+    if (hitCount_ >= MAXIMUM_HITS) {
+        truncated_ = true;
+        cancelled_ = true;
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+}
+
+// the last z - 1 bytes of each block are carried over to the next, so that
+// every match is found whole in exactly one block
+void FileSearch::searchFile(const std::filesystem::path& path,
+                            std::vector<byte>& buffer) {
+    FILE_unique_ptr f = fopen_unique(path, "rb");
+    if (!f) {
+        ++failed_;
+        return;
+    }
+    bufsize z = needle_.size(), c = buffer.size(), keep = 0, o = 0;
+    byte* bp = buffer.data();
+    const byte* nd = needle_.data();
+    std::vector<FileSearchHit> hits;
+    while (!cancelled_) {
+        bufsize r = std::fread(bp + keep, 1, c - keep, f.get());
+        bufsize n = keep + r, p = 0;
+        SearchResult res;
+        while (n - p >= z &&
+               (res = searchPartialForward(n - p, bp + p, z, nd, false))) {
+            hits.push_back(FileSearchHit{path, o + p + res.offset});
+            p += res.offset + 1;
+        }
+        report(hits);
+        if (r < c - keep) {
+            if (std::ferror(f.get())) ++failed_;
+            break;
+        }
+        keep = std::min(n, z - 1);
+        std::memmove(bp, bp + n - keep, keep);
+        o += n - keep;
+    }
+}
+
+};  // namespace hexbed
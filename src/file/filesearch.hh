@@ -0,0 +1,110 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/filesearch.hh -- header for searching files on disk
+
+#ifndef HEXBED_FILE_FILESEARCH_HH
+#define HEXBED_FILE_FILESEARCH_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/types.hh"
+#include "file/task.hh"
+
+#if HEXBED_MULTITHREADED
+#include <thread>
+#endif
+
+namespace hexbed {
+
+// * and ? wildcards; several globs may be separated by semicolons, and an
+// empty glob matches every name
+bool fileNameGlobMatch(std::string_view globs, std::string_view name);
+
+struct FileSearchFilter {
+    std::string glob;
+    bufsize minimumSize{0};
+    bufsize maximumSize{std::numeric_limits<bufsize>::max()};
+};
+
+struct FileSearchHit {
+    std::filesystem::path path;
+    bufoffset offset;
+};
+
+// walks a directory tree and searches the files that pass the filter on a
+// pool of worker threads. hits are collected as they are found, for the
+// caller to take while the search is still running
+class FileSearch {
+  public:
+    static constexpr std::size_t MAXIMUM_HITS = 1 << 20;
+
+    FileSearch(std::filesystem::path root, FileSearchFilter filter,
+               std::vector<byte> needle);
+    ~FileSearch();
+
+    void cancel();
+    bool running() const noexcept;
+    // moves the hits found since the last call to the end of out
+    void take(std::vector<FileSearchHit>& out);
+    inline std::size_t filesSearched() const noexcept { return searched_; }
+    inline std::size_t filesFailed() const noexcept { return failed_; }
+    inline bool truncated() const noexcept { return truncated_; }
+
+  private:
+    void walk();
+    void work();
+    void push(std::filesystem::path path);
+    void searchFile(const std::filesystem::path& path,
+                    std::vector<byte>& buffer);
+    void report(std::vector<FileSearchHit>& hits);
+
+    std::filesystem::path root_;
+    FileSearchFilter filter_;
+    std::vector<byte> needle_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<std::filesystem::path> queue_;
+    std::vector<FileSearchHit> hits_;
+    std::size_t hitCount_{0};
+    bool walking_{true};
+    unsigned workers_{0};
+
+    std::atomic<bool> cancelled_{false};
+    std::atomic<bool> truncated_{false};
+    std::atomic<std::size_t> searched_{0};
+    std::atomic<std::size_t> failed_{0};
+#if HEXBED_MULTITHREADED
+    std::vector<std::thread> threads_;
+#endif
+};
+
+};  // namespace hexbed
+
+#endif /* HEXBED_FILE_FILESEARCH_HH */
@@ -0,0 +1,156 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/fillscan.cc -- impl for skipping over fill and padding
+
+#include "file/fillscan.hh"
+
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+
+#include "common/memory.hh"
+#include "file/document.hh"
+
+namespace hexbed {
+
+// bytes read at a time; a multiple of 64, so that lines stay in phase
+static constexpr bufsize FILL_SCAN_BUFFER = 1 << 16;
+
+FillPattern::FillPattern(const_bytespan fill) : size_(fill.size()) {
+    if (!size_ || size_ > MAXIMUM_LENGTH)
+        throw std::invalid_argument("invalid fill length");
+    period_ = std::lcm(size_, bufsize(64));
+    table_.resize(period_ + size_);
+    for (bufsize i = 0; i < table_.size(); ++i) table_[i] = fill[i % size_];
+}
+
+// calls run for every run of at least minimum fill bytes within
+// [start, end), in order, until it returns false. every 64-byte line is
+// compared at once, so that long runs of fill or of data go by a whole
+// line per step
+static void scanFillRuns(HexBedTask& task, const HexBedDocument& document,
+                         bufsize start, bufsize end, const FillPattern& fill,
+                         bufsize minimum,
+                         const std::function<bool(bufoffset, bufsize)>& run) {
+    std::unique_ptr<byte[]> buffer = std::make_unique<byte[]>(FILL_SCAN_BUFFER);
+    std::uint64_t masks[FILL_SCAN_BUFFER / 64];
+    byte* bp = buffer.get();
+    bufoffset o = start, runStart = 0;
+    bool inRun = false;
+    bufsize r;
+    while (o < end &&
+           (r = document.read(
+                o, bytespan(bp, std::min(end - o, FILL_SCAN_BUFFER))))) {
+        if (task.isCancelled()) return;
+        memCompareLines(bp, r, fill.lineAt(o), fill.period(), masks);
+        for (bufsize l = 0, lines = (r + 63) / 64; l < lines; ++l) {
+            std::uint64_t m = masks[l];
+            bufoffset b = o + l * 64;
+            unsigned k = 0, v = b + 64 <= o + r ? 64 : (o + r) - b;
+            while (k < v) {
+                if (inRun) {
+                    std::uint64_t z = ~m >> k;
+                    unsigned e = z ? k + std::countr_zero(z) : 64;
+                    if (e >= v) break;
+                    if (b + e - runStart >= minimum &&
+                        !run(runStart, b + e - runStart))
+                        return;
+                    inRun = false;
+                    k = e;
+                } else {
+                    std::uint64_t f = m >> k;
+                    if (!f) break;
+                    k += std::countr_zero(f);
+                    inRun = true;
+                    runStart = b + k;
+                }
+            }
+        }
+        o += r;
+        task.progress(task.progress() + r);
+    }
+    if (inRun && o - runStart >= minimum) run(runStart, o - runStart);
+}
+
+// reads a single line first, so that data right at the start is found
+// without reading a whole buffer, and returns at the first mismatch
+SearchResult searchForwardNotFill(HexBedTask& task,
+                                  const HexBedDocument& document,
+                                  bufsize start, bufsize end,
+                                  const FillPattern& fill) {
+    end = std::min(end, document.size());
+    std::unique_ptr<byte[]> buffer = std::make_unique<byte[]>(FILL_SCAN_BUFFER);
+    std::uint64_t masks[FILL_SCAN_BUFFER / 64];
+    byte* bp = buffer.get();
+    bufoffset o = start;
+    bufsize want = 64, r;
+    while (o < end &&
+           (r = document.read(o, bytespan(bp, std::min(end - o, want))))) {
+        if (task.isCancelled()) return SearchResult{};
+        memCompareLines(bp, r, fill.lineAt(o), fill.period(), masks);
+        for (bufsize l = 0, lines = (r + 63) / 64; l < lines; ++l) {
+            std::uint64_t d = ~masks[l];
+            bufsize v = r - l * 64;
+            if (v < 64) d &= (std::uint64_t(1) << v) - 1;
+            if (d)
+                return SearchResult{SearchResultType::Full,
+                                    o + l * 64 + std::countr_zero(d), 1};
+        }
+        o += r;
+        task.progress(task.progress() + r);
+        want = FILL_SCAN_BUFFER;
+    }
+    return SearchResult{};
+}
+
+SearchResult searchForwardFillRun(HexBedTask& task,
+                                  const HexBedDocument& document,
+                                  bufsize start, bufsize end,
+                                  const FillPattern& fill, bufsize minimum) {
+    SearchResult res{};
+    scanFillRuns(task, document, start, end, fill,
+                 std::max<bufsize>(minimum, 1),
+                 [&res](bufoffset o, bufsize n) {
+                     res = SearchResult{SearchResultType::Full, o, n};
+                     return false;
+                 });
+    return res;
+}
+
+void searchDataRegions(HexBedTask& task, const HexBedDocument& document,
+                       bufsize start, bufsize end, const FillPattern& fill,
+                       bufsize minimum,
+                       const std::function<bool(bufoffset, bufsize)>& found) {
+    end = std::min(end, document.size());
+    bufoffset at = start;
+    bool more = true;
+    scanFillRuns(task, document, start, end, fill,
+                 std::max<bufsize>(minimum, 1),
+                 [&](bufoffset o, bufsize n) {
+                     if (o > at) more = found(at, o - at);
+                     at = o + n;
+                     return more;
+                 });
+    if (more && at < end && !task.isCancelled()) found(at, end - at);
+}
+
+};  // namespace hexbed
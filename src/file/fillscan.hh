@@ -0,0 +1,80 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/fillscan.hh -- header for skipping over fill and padding
+
+#ifndef HEXBED_FILE_FILLSCAN_HH
+#define HEXBED_FILE_FILLSCAN_HH
+
+#include <functional>
+#include <vector>
+
+#include "common/types.hh"
+#include "file/document-fwd.hh"
+#include "file/search.hh"
+#include "file/task.hh"
+
+namespace hexbed {
+
+// a fill byte or word, repeated so that each copy starts at an offset that
+// is a multiple of its length
+class FillPattern {
+  public:
+    static constexpr bufsize MAXIMUM_LENGTH = 64;
+
+    explicit FillPattern(const_bytespan fill);
+
+    inline bufsize size() const noexcept { return size_; }
+    inline const_bytespan bytes() const noexcept {
+        return const_bytespan(table_.data(), size_);
+    }
+    // the fill as it continues from offset, for period() bytes
+    inline const byte* lineAt(bufoffset offset) const noexcept {
+        return table_.data() + offset % size_;
+    }
+    // a multiple of both the fill length and 64
+    inline bufsize period() const noexcept { return period_; }
+
+  private:
+    bufsize size_;
+    bufsize period_;
+    std::vector<byte> table_;
+};
+
+// the first byte within [start, end) that differs from the fill
+SearchResult searchForwardNotFill(HexBedTask& task,
+                                  const HexBedDocument& document,
+                                  bufsize start, bufsize end,
+                                  const FillPattern& fill);
+// the first run of at least minimum fill bytes within [start, end). runs
+// are cut off at start and end
+SearchResult searchForwardFillRun(HexBedTask& task,
+                                  const HexBedDocument& document,
+                                  bufsize start, bufsize end,
+                                  const FillPattern& fill, bufsize minimum);
+// calls found with every region within [start, end) that is not part of a
+// run of at least minimum fill bytes, in order, until it returns false
+void searchDataRegions(HexBedTask& task, const HexBedDocument& document,
+                       bufsize start, bufsize end, const FillPattern& fill,
+                       bufsize minimum,
+                       const std::function<bool(bufoffset, bufsize)>& found);
+
+};  // namespace hexbed
+
+#endif /* HEXBED_FILE_FILLSCAN_HH */
@@ -0,0 +1,129 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/masksearch.cc -- impl for masked (wildcard) byte pattern search
+
+#include "file/masksearch.hh"
+
+#include <bit>
+#include <memory>
+#include <new>
+
+#include "common/memory.hh"
+#include "file/document.hh"
+
+namespace hexbed {
+
+MaskedPattern::MaskedPattern() : filter1(0), filter2(0) {}
+
+// higher is more selective: more fixed bits first, then rarer values
+static int maskedSelectivity(byte v, byte m) noexcept {
+    int common = v == 0x00 ? 4 : v == 0xFF ? 3 : v < 0x80 ? 1 : 0;
+    return std::popcount(m) * 8 - common;
+}
+
+MaskedPattern::MaskedPattern(std::vector<byte> value_, std::vector<byte> mask_)
+    : value(std::move(value_)), mask(std::move(mask_)), filter1(0), filter2(0) {
+    bufsize n = value.size();
+    for (bufsize k = 0; k < n; ++k) value[k] &= mask[k];
+    auto score = [this](bufsize k) {
+        return maskedSelectivity(value[k], mask[k]);
+    };
+    for (bufsize k = 1; k < n; ++k)
+        if (score(k) > score(filter1)) filter1 = k;
+    filter2 = filter1 ? 0 : n - 1;
+    for (bufsize k = 0; k < n; ++k) {
+        if (k == filter1) continue;
+        // prefer a byte that differs from the first filter byte
+        int sk = score(k) - (value[k] == value[filter1] ? 16 : 0);
+        int s2 = score(filter2) - (value[filter2] == value[filter1] ? 16 : 0);
+        if (sk > s2) filter2 = k;
+    }
+}
+
+const byte* findMaskedForward(const byte* start, const byte* end,
+                              const MaskedPattern& p) {
+    bufsize i = p.filter1, j = p.filter2, n = p.size();
+    const byte* s = start;
+    while ((s = memFindPairMasked(s, end, i, p.value[i], p.mask[i], j,
+                                  p.value[j], p.mask[j]))) {
+        if (memEqualMasked(s, p.value.data(), p.mask.data(), n)) return s;
+        ++s;
+    }
+    return nullptr;
+}
+
+const byte* findMaskedBackward(const byte* start, const byte* end,
+                               const MaskedPattern& p) {
+    bufsize i = p.filter1, j = p.filter2, n = p.size();
+    const byte* s = end;
+    while ((s = memFindPairMaskedLast(start, s, i, p.value[i], p.mask[i], j,
+                                      p.value[j], p.mask[j])))
+        if (memEqualMasked(s, p.value.data(), p.mask.data(), n)) return s;
+    return nullptr;
+}
+
+static std::unique_ptr<byte[]> allocateSearchBuffer(bufsize z, bufsize& c) {
+    byte* bp = new (std::nothrow) byte[(c = getPreferredSearchBufferSize(z))];
+    if (!bp) bp = new byte[(c = getMinimalSearchBufferSize(z))];
+    return std::unique_ptr<byte[]>(bp);
+}
+
+// consecutive windows overlap by z - 1 bytes, so that every match lies
+// whole within at least one of them
+SearchResult searchForwardMasked(HexBedTask& task,
+                                 const HexBedDocument& document,
+                                 bufsize start, bufsize end,
+                                 const MaskedPattern& pattern) {
+    bufsize z = pattern.size(), c, r, rr, o = start;
+    if (!z || start >= end || end - start < z) return SearchResult{};
+    std::unique_ptr<byte[]> buffer = allocateSearchBuffer(z, c);
+    byte* bp = buffer.get();
+    while ((rr = std::min(end - o, c)) >= z &&
+           (r = document.read(o, bytespan(bp, rr))) >= z) {
+        if (task.isCancelled()) break;
+        const byte* p = findMaskedForward(bp, bp + r - z + 1, pattern);
+        if (p) return SearchResult{SearchResultType::Full, o + (p - bp), z};
+        if (r < rr || o + r >= end) break;
+        o += r - z + 1;
+    }
+    return SearchResult{};
+}
+
+SearchResult searchBackwardMasked(HexBedTask& task,
+                                  const HexBedDocument& document,
+                                  bufsize start, bufsize end,
+                                  const MaskedPattern& pattern) {
+    bufsize z = pattern.size(), c, r, hi = end;
+    if (!z || start >= end || end - start < z) return SearchResult{};
+    std::unique_ptr<byte[]> buffer = allocateSearchBuffer(z, c);
+    byte* bp = buffer.get();
+    while (hi - start >= z) {
+        bufsize lo = hi - start > c ? hi - c : start;
+        if ((r = document.read(lo, bytespan(bp, hi - lo))) < hi - lo) break;
+        if (task.isCancelled()) break;
+        const byte* p = findMaskedBackward(bp, bp + r - z + 1, pattern);
+        if (p) return SearchResult{SearchResultType::Full, lo + (p - bp), z};
+        if (lo == start) break;
+        hi = lo + z - 1;
+    }
+    return SearchResult{};
+}
+
+};  // namespace hexbed
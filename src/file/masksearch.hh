@@ -0,0 +1,66 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/masksearch.hh -- header for masked (wildcard) byte pattern search
+
+#ifndef HEXBED_FILE_MASKSEARCH_HH
+#define HEXBED_FILE_MASKSEARCH_HH
+
+#include <vector>
+
+#include "common/types.hh"
+#include "file/document-fwd.hh"
+#include "file/search.hh"
+#include "file/task.hh"
+
+namespace hexbed {
+
+struct MaskedPattern {
+    MaskedPattern();
+    MaskedPattern(std::vector<byte> value, std::vector<byte> mask);
+
+    inline bufsize size() const noexcept { return value.size(); }
+
+    // bits not in mask are cleared in value
+    std::vector<byte> value;
+    std::vector<byte> mask;
+    // the two most selective bytes, checked before the whole pattern
+    bufsize filter1;
+    bufsize filter2;
+};
+
+// first and last match starting within [start, end); the pattern may read
+// up to size() - 1 bytes past end
+const byte* findMaskedForward(const byte* start, const byte* end,
+                              const MaskedPattern& pattern);
+const byte* findMaskedBackward(const byte* start, const byte* end,
+                               const MaskedPattern& pattern);
+
+SearchResult searchForwardMasked(HexBedTask& task,
+                                 const HexBedDocument& document,
+                                 bufsize start, bufsize end,
+                                 const MaskedPattern& pattern);
+SearchResult searchBackwardMasked(HexBedTask& task,
+                                  const HexBedDocument& document,
+                                  bufsize start, bufsize end,
+                                  const MaskedPattern& pattern);
+
+};  // namespace hexbed
+
+#endif /* HEXBED_FILE_MASKSEARCH_HH */
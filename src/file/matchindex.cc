@@ -0,0 +1,251 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/matchindex.cc -- impl for the edit-aware match index
+
+#include "file/matchindex.hh"
+
+#include <algorithm>
+
+#include "common/memory.hh"
+#include "file/document.hh"
+
+namespace hexbed {
+
+namespace {
+
+struct MatchIndexOverflow {};
+
+};  // namespace
+
+MatchIndex::MatchIndex(HexBedDocument& document, const_bytespan pattern)
+    : document_(&document),
+      pattern_(pattern.begin(), pattern.end()),
+      size_(document.size()) {
+    HEXBED_ASSERT(!pattern_.empty());
+    if (size_) stale_.push_back(Window{0, size_});
+}
+
+bool MatchIndex::matches(const_bytespan pattern) const noexcept {
+    return std::equal(pattern.begin(), pattern.end(), pattern_.begin(),
+                      pattern_.end());
+}
+
+void MatchIndex::update(bufoffset start, bufsize oldLength,
+                        bufsize newLength) {
+    if (overflow_) return;
+    restartRefine();
+    bufsize z = pattern_.size();
+    if (start > size_) start = size_;
+    oldLength = std::min(oldLength, size_ - start);
+    bufoffset cut = start + oldLength;
+    bufoffset reach = start >= z ? start - z + 1 : 0;
+    auto shift = [=](bufoffset p, bufoffset inside) -> bufoffset {
+        if (p <= start) return p;
+        if (p >= cut) return p - oldLength + newLength;
+        return inside;
+    };
+
+    // matches overlapping the old bytes are gone, and the ones after them
+    // move along
+    auto lo = std::lower_bound(offsets_.begin(), offsets_.end(), reach);
+    auto hi = std::lower_bound(lo, offsets_.end(), cut);
+    for (auto it = offsets_.erase(lo, hi); it != offsets_.end(); ++it)
+        *it = *it - oldLength + newLength;
+
+    size_ = size_ - oldLength + newLength;
+    std::vector<Window> windows;
+    windows.reserve(stale_.size() + 1);
+    for (const Window& w : stale_) {
+        Window v{shift(w.start, start), shift(w.end, start + newLength)};
+        if (v.start < v.end) windows.push_back(v);
+    }
+    Window edit{reach, std::min(start + newLength + z - 1, size_)};
+    if (edit.start < edit.end) windows.push_back(edit);
+    merge(windows);
+}
+
+void MatchIndex::merge(std::vector<Window>& windows) {
+    std::sort(windows.begin(), windows.end(),
+              [](const Window& a, const Window& b) {
+                  return a.start < b.start;
+              });
+    stale_.clear();
+    for (const Window& w : windows) {
+        if (!stale_.empty() && w.start <= stale_.back().end)
+            stale_.back().end = std::max(stale_.back().end, w.end);
+        else
+            stale_.push_back(w);
+    }
+    if (stale_.size() > MAXIMUM_WINDOWS) {
+        stale_.front().end = stale_.back().end;
+        stale_.resize(1);
+    }
+}
+
+bool MatchIndex::extend(const_bytespan pattern) {
+    bufsize z = pattern_.size();
+    if (overflow_ || pattern.size() <= z ||
+        !std::equal(pattern_.begin(), pattern_.end(), pattern.begin()))
+        return false;
+    restartRefine();
+    if (!refineFrom_) refineFrom_ = z;
+    pattern_.assign(pattern.begin(), pattern.end());
+    // the windows must still cover the longer matches that start in them
+    bufsize grow = pattern_.size() - z;
+    std::vector<Window> windows = std::move(stale_);
+    for (Window& w : windows) w.end = std::min(w.end + grow, size_);
+    merge(windows);
+    return true;
+}
+
+void MatchIndex::update(bufoffset start) {
+    bufsize now = document_->size();
+    if (start > size_) start = size_;
+    update(start, size_ - start, now >= start ? now - start : 0);
+}
+
+void MatchIndex::rescan(HexBedTask& task, Window window) {
+    bufsize z = pattern_.size();
+    // a window holds the matches that start and end within it
+    auto lo = std::lower_bound(offsets_.begin(), offsets_.end(), window.start);
+    auto hi = window.end >= window.start + z
+                  ? std::lower_bound(lo, offsets_.end(), window.end - z + 1)
+                  : lo;
+    std::size_t kept = offsets_.size() - (hi - lo);
+    std::vector<bufoffset> found;
+    document_->searchAll(
+        task, window.start, window.end,
+        const_bytespan(pattern_.data(), pattern_.size()),
+        [&found, kept](bufoffset o) {
+            if (kept + found.size() >= MAXIMUM) throw MatchIndexOverflow{};
+            found.push_back(o);
+        });
+    if (task.isCancelled()) return;
+    std::size_t at = lo - offsets_.begin();
+    offsets_.erase(lo, hi);
+    offsets_.insert(offsets_.begin() + at, found.begin(), found.end());
+}
+
+// the offsets changed under the refinement, so drop the matches it has
+// already ruled out and have it start over
+void MatchIndex::restartRefine() {
+    if (!refineIn_) return;
+    offsets_.erase(offsets_.begin() + refineOut_,
+                   offsets_.begin() + refineIn_);
+    refineIn_ = refineOut_ = 0;
+}
+
+void MatchIndex::refine(HexBedTask& task, std::size_t count) {
+    bufsize z = pattern_.size(), k = refineFrom_, tail = z - k;
+    const byte* want = pattern_.data() + k;
+    std::vector<byte> buffer(std::max(REFINE_BUFFER, tail));
+    bufoffset bo = 0;
+    bufsize br = 0;
+    std::size_t n = offsets_.size(), reach = refineIn_;
+    std::size_t stop = n - refineIn_ > count ? refineIn_ + count : n;
+    // the matches that still match are compacted in place
+    for (; refineIn_ < stop; ++refineIn_) {
+        std::size_t i = refineIn_;
+        bufoffset p = offsets_[i] + k;
+        if (p + tail > size_) {
+            refineIn_ = n;
+            break;
+        }
+        if (p < bo || p + tail > bo + br) {
+            if (task.isCancelled()) return;
+            // only read as far as the matches close enough to share it
+            reach = std::max(reach, i);
+            while (reach + 1 < n &&
+                   offsets_[reach + 1] + z <= p + buffer.size())
+                ++reach;
+            bufsize len = std::min<bufsize>(offsets_[reach] + z, size_) - p;
+            bo = p;
+            br = document_->read(p, bytespan(buffer.data(), len));
+            if (br < tail) {
+                refineIn_ = n;
+                break;
+            }
+        }
+        if (memEqual(buffer.data() + (p - bo), want, tail))
+            offsets_[refineOut_++] = offsets_[i];
+    }
+    if (refineIn_ < n) return;
+    offsets_.resize(refineOut_);
+    offsets_.shrink_to_fit();
+    refineFrom_ = 0;
+    refineIn_ = refineOut_ = 0;
+}
+
+bool MatchIndex::refreshSlice(HexBedTask& task) {
+    if (overflow_) return false;
+    if (!stale_.empty()) {
+        Window w = stale_.back();
+        bufsize z = pattern_.size();
+        bufoffset e = w.end - w.start > RESCAN_SLICE + z - 1
+                          ? w.start + RESCAN_SLICE + z - 1
+                          : w.end;
+        try {
+            rescan(task, Window{w.start, e});
+        } catch (const MatchIndexOverflow&) {
+            overflow_ = true;
+            offsets_.clear();
+            offsets_.shrink_to_fit();
+            stale_.clear();
+            return false;
+        }
+        if (task.isCancelled()) return true;
+        // the matches that start in the last z - 1 bytes of the slice did
+        // not fit in it, so the rest of the window begins there
+        if (e == w.end)
+            stale_.pop_back();
+        else
+            stale_.back().start = e - z + 1;
+    } else if (refineFrom_) {
+        refine(task, REFINE_SLICE);
+    }
+    return !current();
+}
+
+std::size_t MatchIndex::lowerBound(bufoffset offset) const noexcept {
+    return std::lower_bound(offsets_.begin(), offsets_.end(), offset) -
+           offsets_.begin();
+}
+
+SearchResult MatchIndex::next(bufoffset offset, bool wrap) const noexcept {
+    std::size_t i = lowerBound(offset);
+    if (i == offsets_.size()) {
+        if (!wrap || offsets_.empty()) return SearchResult{};
+        i = 0;
+    }
+    return SearchResult{SearchResultType::Full, offsets_[i], pattern_.size()};
+}
+
+SearchResult MatchIndex::previous(bufoffset offset, bool wrap) const noexcept {
+    bufsize z = pattern_.size();
+    std::size_t i = offset >= z ? lowerBound(offset - z + 1) : 0;
+    if (!i) {
+        if (!wrap || offsets_.empty()) return SearchResult{};
+        i = offsets_.size();
+    }
+    return SearchResult{SearchResultType::Full, offsets_[i - 1],
+                        pattern_.size()};
+}
+
+};  // namespace hexbed
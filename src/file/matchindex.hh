@@ -0,0 +1,113 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/matchindex.hh -- header for the edit-aware match index
+
+#ifndef HEXBED_FILE_MATCHINDEX_HH
+#define HEXBED_FILE_MATCHINDEX_HH
+
+#include <vector>
+
+#include "common/types.hh"
+#include "file/document-fwd.hh"
+#include "file/search.hh"
+#include "file/task.hh"
+
+namespace hexbed {
+
+// the offsets of every match of a byte string in a document. edits drop
+// the matches they touch and shift the ones after them, and the windows
+// around them are rescanned a slice at a time as the index is refreshed
+class MatchIndex {
+  public:
+    // with more matches than this, the index gives up for good
+    static constexpr std::size_t MAXIMUM = std::size_t(1) << 22;
+    // with more stale windows than this, they are rescanned as one
+    static constexpr std::size_t MAXIMUM_WINDOWS = 1024;
+    // how much is read at once when checking the matches of a refinement
+    static constexpr bufsize REFINE_BUFFER = 65536;
+    // how many bytes one refresh slice rescans at most
+    static constexpr bufsize RESCAN_SLICE = bufsize(1) << 20;
+    // how many matches one refresh slice checks at most when refining
+    static constexpr std::size_t REFINE_SLICE = 4096;
+
+    MatchIndex(HexBedDocument& document, const_bytespan pattern);
+
+    bool matches(const_bytespan pattern) const noexcept;
+    inline bool usable() const noexcept { return !overflow_; }
+    // whether the matches are up to date, so that the index can be queried
+    inline bool current() const noexcept {
+        return !overflow_ && stale_.empty() && !refineFrom_;
+    }
+    // switches to a longer pattern that starts with the current one. the
+    // refresh then only checks the added bytes of the current matches.
+    // false if the pattern cannot be reached that way
+    bool extend(const_bytespan pattern);
+
+    // the bytes at [start, start + oldLength) are now at
+    // [start, start + newLength), and the ones after moved along
+    void update(bufoffset start, bufsize oldLength, bufsize newLength);
+    // as above, but anything from start onwards may have changed
+    void update(bufoffset start);
+    // rescans a slice of a stale window, or once there are none, checks a
+    // slice of the refinement. false once there is nothing left to do
+    bool refreshSlice(HexBedTask& task);
+
+    inline std::size_t size() const noexcept { return offsets_.size(); }
+    inline bufoffset operator[](std::size_t index) const noexcept {
+        return offsets_[index];
+    }
+    // index of the first match at or after offset
+    std::size_t lowerBound(bufoffset offset) const noexcept;
+
+    // the first match at or after offset, or if wrapping, the first one
+    SearchResult next(bufoffset offset, bool wrap) const noexcept;
+    // the last match ending at or before offset, or if wrapping, the last
+    SearchResult previous(bufoffset offset, bool wrap) const noexcept;
+
+  private:
+    struct Window {
+        bufoffset start;
+        bufoffset end;
+    };
+
+    HexBedDocument* document_;
+    std::vector<byte> pattern_;
+    std::vector<bufoffset> offsets_;
+    std::vector<Window> stale_;
+    // the size of the document as of the last update
+    bufsize size_;
+    // if nonzero, the current matches are only known to match this many
+    // bytes of the pattern
+    bufsize refineFrom_{0};
+    // how far the refinement has got: the matches before refineIn_ have
+    // been checked, and the ones that still match moved before refineOut_
+    std::size_t refineIn_{0};
+    std::size_t refineOut_{0};
+    bool overflow_{false};
+
+    void merge(std::vector<Window>& windows);
+    void rescan(HexBedTask& task, Window window);
+    void restartRefine();
+    void refine(HexBedTask& task, std::size_t count);
+};
+
+};  // namespace hexbed
+
+#endif /* HEXBED_FILE_MATCHINDEX_HH */
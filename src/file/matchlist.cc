@@ -0,0 +1,115 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/matchlist.cc -- impl for the compact search match list
+
+#include "file/matchlist.hh"
+
+#include <algorithm>
+
+#include "common/logger.hh"
+
+namespace hexbed {
+
+static void putVarint(std::vector<byte>& out, bufoffset v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<byte>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<byte>(v));
+}
+
+static bufoffset getVarint(const byte*& p) noexcept {
+    bufoffset v = 0;
+    unsigned shift = 0;
+    byte b;
+    do {
+        b = *p++;
+        v |= static_cast<bufoffset>(b & 0x7F) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    return v;
+}
+
+void MatchList::add(bufoffset offset) {
+    HEXBED_ASSERT(!tagged_ || !count_);
+    if (count_ % CHECKPOINT == 0)
+        checkpoints_.push_back(Checkpoint{offset, deltas_.size()});
+    else
+        putVarint(deltas_, offset - last_);
+    last_ = offset;
+    ++count_;
+}
+
+void MatchList::add(bufoffset offset, std::uint32_t tag) {
+    HEXBED_ASSERT(tagged_ || !count_);
+    tagged_ = true;
+    if (count_ % CHECKPOINT == 0)
+        checkpoints_.push_back(Checkpoint{offset, deltas_.size()});
+    else
+        putVarint(deltas_, offset - last_);
+    putVarint(deltas_, tag);
+    last_ = offset;
+    ++count_;
+}
+
+void MatchList::clear() noexcept {
+    deltas_.clear();
+    checkpoints_.clear();
+    count_ = 0;
+    last_ = 0;
+    tagged_ = false;
+}
+
+const byte* MatchList::locate(std::size_t index,
+                              bufoffset& offset) const noexcept {
+    const Checkpoint& cp = checkpoints_[index / CHECKPOINT];
+    offset = cp.offset;
+    const byte* p = deltas_.data() + cp.position;
+    for (std::size_t n = index % CHECKPOINT; n; --n) {
+        if (tagged_) getVarint(p);
+        offset += getVarint(p);
+    }
+    return p;
+}
+
+bufoffset MatchList::operator[](std::size_t index) const noexcept {
+    bufoffset offset;
+    locate(index, offset);
+    return offset;
+}
+
+std::uint32_t MatchList::tag(std::size_t index) const noexcept {
+    bufoffset offset;
+    const byte* p = locate(index, offset);
+    return static_cast<std::uint32_t>(getVarint(p));
+}
+
+std::size_t MatchList::lowerBound(bufoffset offset) const noexcept {
+    auto it = std::upper_bound(
+        checkpoints_.begin(), checkpoints_.end(), offset,
+        [](bufoffset o, const Checkpoint& cp) { return o < cp.offset; });
+    if (it == checkpoints_.begin()) return 0;
+    std::size_t i = (it - checkpoints_.begin() - 1) * CHECKPOINT;
+    std::size_t e = std::min(count_, i + CHECKPOINT);
+    while (i < e && (*this)[i] < offset) ++i;
+    return i;
+}
+
+};  // namespace hexbed
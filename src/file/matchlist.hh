@@ -0,0 +1,70 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/matchlist.hh -- header for the compact search match list
+
+#ifndef HEXBED_FILE_MATCHLIST_HH
+#define HEXBED_FILE_MATCHLIST_HH
+
+#include <cstdint>
+#include <vector>
+
+#include "common/types.hh"
+
+namespace hexbed {
+
+// stores ascending offsets as variable-length deltas, with an absolute
+// offset every CHECKPOINT entries for random access. every offset may
+// carry a tag, stored the same way after its delta
+class MatchList {
+  public:
+    static constexpr std::size_t CHECKPOINT = 64;
+
+    // offsets must be added in ascending order. either every offset in a
+    // list has a tag or none of them do
+    void add(bufoffset offset);
+    void add(bufoffset offset, std::uint32_t tag);
+    void clear() noexcept;
+
+    inline std::size_t size() const noexcept { return count_; }
+    inline bool empty() const noexcept { return !count_; }
+    bufoffset operator[](std::size_t index) const noexcept;
+    std::uint32_t tag(std::size_t index) const noexcept;
+    // index of the first offset not less than the given one
+    std::size_t lowerBound(bufoffset offset) const noexcept;
+
+  private:
+    struct Checkpoint {
+        bufoffset offset;
+        std::size_t position;
+    };
+
+    std::vector<byte> deltas_;
+    std::vector<Checkpoint> checkpoints_;
+    std::size_t count_{0};
+    bufoffset last_{0};
+    bool tagged_{false};
+
+    // position of the tag of the entry, or where it would be
+    const byte* locate(std::size_t index, bufoffset& offset) const noexcept;
+};
+
+};  // namespace hexbed
+
+#endif /* HEXBED_FILE_MATCHLIST_HH */
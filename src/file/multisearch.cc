@@ -0,0 +1,209 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/multisearch.cc -- impl for multi-pattern (Aho-Corasick) searching
+
+#include "file/multisearch.hh"
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <stdexcept>
+
+#include "common/hexconv.hh"
+#include "common/memory.hh"
+
+namespace hexbed {
+
+// automata with more states than this use sparse transitions
+static constexpr std::size_t DENSE_STATES_MAX = 1 << 14;
+
+static std::string trim(const std::string& s) {
+    auto b = s.find_first_not_of(" \t\r");
+    if (b == std::string::npos) return std::string();
+    return s.substr(b, s.find_last_not_of(" \t\r") - b + 1);
+}
+
+static bool parsePattern(const std::string& text, std::vector<byte>& out) {
+    out.clear();
+    if (text.size() >= 2 && text.front() == '"' && text.back() == '"') {
+        out.assign(text.begin() + 1, text.end() - 1);
+        return true;
+    }
+    int hi = -1;
+    for (char c : text) {
+        if (c == ' ' || c == '\t') continue;
+        int v = hexDigitToNum(c);
+        if (v < 0) return false;
+        if (hi < 0) {
+            hi = v;
+        } else {
+            out.push_back(static_cast<byte>((hi << 4) | v));
+            hi = -1;
+        }
+    }
+    return hi < 0;
+}
+
+MultiPattern MultiPattern::load(const std::filesystem::path& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) throw std::runtime_error("could not open the pattern file");
+    MultiPattern result;
+    std::string line;
+    std::vector<byte> bytes;
+    for (std::size_t lineno = 1; std::getline(in, line); ++lineno) {
+        line = trim(line);
+        if (line.empty() || line.front() == '#') continue;
+        std::string name, text = line;
+        auto eq = line.find('='), quote = line.find('"');
+        if (eq != std::string::npos && eq < quote) {
+            name = trim(line.substr(0, eq));
+            text = trim(line.substr(eq + 1));
+        }
+        if (!parsePattern(text, bytes) || bytes.empty())
+            throw std::runtime_error("invalid pattern on line " +
+                                     std::to_string(lineno));
+        result.add(const_bytespan(bytes.data(), bytes.size()),
+                   name.empty() ? text : name);
+    }
+    if (!result.size())
+        throw std::runtime_error("the pattern file has no patterns");
+    result.compile();
+    return result;
+}
+
+std::size_t MultiPattern::add(const_bytespan pattern, const std::string& name) {
+    if (pattern.empty()) throw std::invalid_argument("empty pattern");
+    std::size_t index = patterns_.size();
+    State s = 0;
+    for (byte c : pattern) {
+        State t = child(s, c);
+        if (t == NONE) {
+            t = static_cast<State>(nodes_.size());
+            auto& edges = nodes_[s].edges;
+            edges.insert(std::upper_bound(edges.begin(), edges.end(),
+                                          std::make_pair(c, State(0))),
+                         std::make_pair(c, t));
+            nodes_.emplace_back();
+        }
+        s = t;
+    }
+    patterns_.emplace_back(pattern.begin(), pattern.end());
+    names_.push_back(name);
+    nextPattern_.push_back(nodes_[s].firstPattern);
+    nodes_[s].firstPattern = static_cast<std::uint32_t>(index);
+    return index;
+}
+
+MultiPattern::State MultiPattern::child(State s, byte c) const noexcept {
+    const auto& edges = nodes_[s].edges;
+    auto it = std::lower_bound(edges.begin(), edges.end(),
+                               std::make_pair(c, State(0)));
+    return it != edges.end() && it->first == c ? it->second : NONE;
+}
+
+void MultiPattern::compile() {
+    // breadth-first, so that failure links always point to finished states
+    std::deque<State> queue;
+    for (const auto& [c, t] : nodes_[0].edges) {
+        nodes_[t].fail = nodes_[t].outLink = 0;
+        queue.push_back(t);
+        starts_[c] = true;
+    }
+    std::vector<State> order;
+    order.reserve(nodes_.size());
+    while (!queue.empty()) {
+        State s = queue.front();
+        queue.pop_front();
+        order.push_back(s);
+        for (const auto& [c, t] : nodes_[s].edges) {
+            State f = nodes_[s].fail;
+            State g;
+            while ((g = child(f, c)) == NONE && f) f = nodes_[f].fail;
+            if (g == NONE) g = 0;
+            nodes_[t].fail = g;
+            nodes_[t].outLink =
+                nodes_[g].firstPattern != NONE ? g : nodes_[g].outLink;
+            queue.push_back(t);
+        }
+    }
+
+    startCount_ = 0;
+    for (unsigned c = 0; c < 256; ++c)
+        if (starts_[c] && startCount_++ < 2)
+            startBytes_[startCount_ - 1] = static_cast<byte>(c);
+    memMakeByteClass(startClass_, starts_);
+
+    delta_.clear();
+    if (nodes_.size() <= DENSE_STATES_MAX) {
+        delta_.assign(nodes_.size() * 256, 0);
+        for (const auto& [c, t] : nodes_[0].edges) delta_[c] = t;
+        for (State s : order) {
+            State* row = &delta_[s * 256];
+            const State* frow = &delta_[nodes_[s].fail * 256];
+            std::copy(frow, frow + 256, row);
+            for (const auto& [c, t] : nodes_[s].edges) row[c] = t;
+        }
+    }
+}
+
+MultiPattern::State MultiPattern::step(State s, byte c) const noexcept {
+    for (;;) {
+        State t = child(s, c);
+        if (t != NONE) return t;
+        if (!s) return 0;
+        s = nodes_[s].fail;
+    }
+}
+
+void MultiPattern::report(State s, bufoffset offset,
+                          const Callback& found) const {
+    if (nodes_[s].firstPattern == NONE) s = nodes_[s].outLink;
+    for (; s; s = nodes_[s].outLink)
+        for (std::uint32_t p = nodes_[s].firstPattern; p != NONE;
+             p = nextPattern_[p])
+            found(p, offset);
+}
+
+MultiPattern::State MultiPattern::scan(State state, const byte* data,
+                                       bufsize n, bufoffset base,
+                                       const Callback& found) const {
+    const byte* p = data;
+    const byte* end = data + n;
+    const bool dense = !delta_.empty();
+    while (p < end) {
+        if (!state) {
+            // nothing matched so far; skip to a byte that can start a match
+            if (startCount_ == 1)
+                p = memFindFirst(p, end, startBytes_[0]);
+            else if (startCount_ == 2)
+                p = memFindFirst2(p, end, startBytes_[0], startBytes_[1]);
+            else
+                p = memFindFirstOf(p, end, startClass_);
+            if (!p) break;
+        }
+        state = dense ? delta_[state * 256 + *p] : step(state, *p);
+        if (nodes_[state].firstPattern != NONE || nodes_[state].outLink)
+            report(state, base + (p - data), found);
+        ++p;
+    }
+    return state;
+}
+
+};  // namespace hexbed
@@ -0,0 +1,94 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/multisearch.hh -- header for multi-pattern (Aho-Corasick) searching
+
+#ifndef HEXBED_FILE_MULTISEARCH_HH
+#define HEXBED_FILE_MULTISEARCH_HH
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/memory.hh"
+#include "common/types.hh"
+
+namespace hexbed {
+
+class MultiPattern {
+  public:
+    using State = std::uint32_t;
+    // pattern index, offset of the last byte of the match
+    using Callback = std::function<void(std::size_t, bufoffset)>;
+
+    // one pattern per line, as hex bytes or "quoted text", optionally
+    // preceded by name=. empty lines and lines starting with # are skipped
+    static MultiPattern load(const std::filesystem::path& filename);
+
+    // all patterns must be added before compile
+    std::size_t add(const_bytespan pattern, const std::string& name);
+    void compile();
+
+    inline std::size_t size() const noexcept { return patterns_.size(); }
+    inline const std::vector<byte>& pattern(std::size_t i) const noexcept {
+        return patterns_[i];
+    }
+    inline const std::string& name(std::size_t i) const noexcept {
+        return names_[i];
+    }
+
+    // feeds n bytes starting at document offset base to the automaton and
+    // returns the new state. the initial state is 0
+    State scan(State state, const byte* data, bufsize n, bufoffset base,
+               const Callback& found) const;
+
+  private:
+    static constexpr std::uint32_t NONE = UINT32_MAX;
+
+    struct Node {
+        std::vector<std::pair<byte, State>> edges;
+        State fail{0};
+        // nearest state on the failure chain where a pattern ends
+        State outLink{0};
+        std::uint32_t firstPattern{NONE};
+    };
+
+    State child(State s, byte c) const noexcept;
+    State step(State s, byte c) const noexcept;
+    void report(State s, bufoffset offset, const Callback& found) const;
+
+    std::vector<std::vector<byte>> patterns_;
+    std::vector<std::string> names_;
+    std::vector<std::uint32_t> nextPattern_;
+    std::vector<Node> nodes_{1};
+    // full transition table, if the automaton is small enough
+    std::vector<State> delta_;
+    // bytes that can start a match, for skipping ahead in the root state
+    bool starts_[256]{};
+    unsigned startCount_{0};
+    byte startBytes_[2]{};
+    ByteClass startClass_;
+};
+
+};  // namespace hexbed
+
+#endif /* HEXBED_FILE_MULTISEARCH_HH */
@@ -0,0 +1,291 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/numsearch.cc -- impl for numeric value and range searching
+
+#include "file/numsearch.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <utility>
+
+#include "common/intconv.hh"
+
+namespace hexbed {
+
+bufsize numericTypeWidth(NumericType type) noexcept {
+    switch (type) {
+    case NumericType::Int8:
+    case NumericType::UInt8:
+        return 1;
+    case NumericType::Int16:
+    case NumericType::UInt16:
+        return 2;
+    case NumericType::Int32:
+    case NumericType::UInt32:
+    case NumericType::Float32:
+        return 4;
+    case NumericType::Int64:
+    case NumericType::UInt64:
+    case NumericType::Float64:
+        return 8;
+    }
+    return 1;
+}
+
+bool numericTypeIsSigned(NumericType type) noexcept {
+    switch (type) {
+    case NumericType::Int8:
+    case NumericType::Int16:
+    case NumericType::Int32:
+    case NumericType::Int64:
+    case NumericType::Float32:
+    case NumericType::Float64:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool numericTypeIsFloat(NumericType type) noexcept {
+    return type == NumericType::Float32 || type == NumericType::Float64;
+}
+
+NumericQuery::NumericQuery(NumericType type) noexcept : type_(type) {}
+
+NumericQuery NumericQuery::inSigned(NumericType type, std::int64_t lo,
+                                    std::int64_t hi) {
+    NumericQuery q(type);
+    if (lo > hi) std::swap(lo, hi);
+    bufsize bits = q.width() * CHAR_BIT;
+    if (bits < 64) {
+        std::int64_t max = (std::int64_t(1) << (bits - 1)) - 1, min = -max - 1;
+        if (hi < min || lo > max) q.none_ = true;
+        lo = std::clamp(lo, min, max);
+        hi = std::clamp(hi, min, max);
+    }
+    q.lo_ = static_cast<std::uint64_t>(lo);
+    q.span_ = static_cast<std::uint64_t>(hi) - q.lo_;
+    return q;
+}
+
+NumericQuery NumericQuery::inUnsigned(NumericType type, std::uint64_t lo,
+                                      std::uint64_t hi) {
+    NumericQuery q(type);
+    if (lo > hi) std::swap(lo, hi);
+    bufsize bits = q.width() * CHAR_BIT;
+    if (bits < 64) {
+        std::uint64_t max = (std::uint64_t(1) << bits) - 1;
+        if (lo > max) q.none_ = true;
+        hi = std::min(hi, max);
+    }
+    q.lo_ = lo;
+    q.span_ = hi - lo;
+    return q;
+}
+
+NumericQuery NumericQuery::nearFloat(NumericType type, double x,
+                                     double epsilon) {
+    NumericQuery q(type);
+    q.x_ = x;
+    q.epsilon_ = std::fabs(epsilon);
+    return q;
+}
+
+NumericQuery& NumericQuery::byteOrders(bool little, bool big) noexcept {
+    little_ = little;
+    big_ = big;
+    return *this;
+}
+
+NumericQuery& NumericQuery::stride(bufsize stride) noexcept {
+    stride_ = stride ? stride : 1;
+    return *this;
+}
+
+template <typename U, bool littleEndian>
+static inline U loadValue(const byte* p) noexcept {
+    return uintFromBytes<U>(sizeof(U), p, littleEndian);
+}
+
+// tests up to 64 values into a bit mask. the loop has no branches, so
+// that the compiler can vectorise the loads and the comparisons
+template <typename U, bool littleEndian, typename Test>
+static std::uint64_t testChunk(const byte* p, unsigned m, bufsize stride,
+                               const Test& test) noexcept {
+    std::uint64_t mask = 0;
+    if (stride == 1) {
+        for (unsigned j = 0; j < m; ++j)
+            mask |= static_cast<std::uint64_t>(
+                        test(loadValue<U, littleEndian>(p + j)))
+                    << j;
+    } else {
+        for (unsigned j = 0; j < m; ++j)
+            mask |= static_cast<std::uint64_t>(
+                        test(loadValue<U, littleEndian>(p + j * stride)))
+                    << j;
+    }
+    return mask;
+}
+
+template <typename U, typename Test>
+static void scanValues(const byte* data, bufsize n, bufoffset base,
+                       bufsize stride, bool little, bool big,
+                       const Test& test, const NumericQuery::Callback& found) {
+    constexpr unsigned CHUNK = 64;
+    if (n < sizeof(U)) return;
+    bufsize count = n - sizeof(U) + 1;
+    bufsize i = base % stride ? stride - base % stride : 0;
+    for (; i < count; i += CHUNK * stride) {
+        unsigned m = static_cast<unsigned>(
+            std::min<bufsize>(CHUNK, (count - i + stride - 1) / stride));
+        std::uint64_t ml = 0, mb = 0;
+        if (little) ml = testChunk<U, true>(data + i, m, stride, test);
+        if (big) mb = testChunk<U, false>(data + i, m, stride, test);
+        for (std::uint64_t mm = ml | mb; mm; mm &= mm - 1) {
+            unsigned j = std::countr_zero(mm);
+            bufoffset o = base + i + j * stride;
+            if ((ml >> j) & 1) found(o, true);
+            if ((mb >> j) & 1) found(o, false);
+        }
+    }
+}
+
+template <typename U>
+static void scanInteger(const byte* data, bufsize n, bufoffset base,
+                        bufsize stride, bool little, bool big,
+                        std::uint64_t lo, std::uint64_t span,
+                        const NumericQuery::Callback& found) {
+    U l = static_cast<U>(lo), s = static_cast<U>(span);
+    scanValues<U>(
+        data, n, base, stride, little, big,
+        [l, s](U v) { return static_cast<U>(v - l) <= s; }, found);
+}
+
+template <typename F, typename U>
+static void scanFloat(const byte* data, bufsize n, bufoffset base,
+                      bufsize stride, bool little, bool big, double x,
+                      double epsilon, const NumericQuery::Callback& found) {
+    static_assert(sizeof(F) == sizeof(U));
+    static_assert(std::numeric_limits<F>::is_iec559);
+    scanValues<U>(
+        data, n, base, stride, little, big,
+        [x, epsilon](U v) {
+            return std::fabs(static_cast<double>(std::bit_cast<F>(v)) - x) <=
+                   epsilon;
+        },
+        found);
+}
+
+void NumericQuery::scan(const byte* data, bufsize n, bufoffset base,
+                        const Callback& found) const {
+    if (none_ || (!little_ && !big_)) return;
+    // byte order makes no difference for single bytes
+    bool big = big_ && (!little_ || width() > 1);
+    switch (type_) {
+    case NumericType::Int8:
+    case NumericType::UInt8:
+        scanInteger<std::uint8_t>(data, n, base, stride_, little_, big, lo_,
+                                  span_, found);
+        break;
+    case NumericType::Int16:
+    case NumericType::UInt16:
+        scanInteger<std::uint16_t>(data, n, base, stride_, little_, big, lo_,
+                                   span_, found);
+        break;
+    case NumericType::Int32:
+    case NumericType::UInt32:
+        scanInteger<std::uint32_t>(data, n, base, stride_, little_, big, lo_,
+                                   span_, found);
+        break;
+    case NumericType::Int64:
+    case NumericType::UInt64:
+        scanInteger<std::uint64_t>(data, n, base, stride_, little_, big, lo_,
+                                   span_, found);
+        break;
+    case NumericType::Float32:
+        scanFloat<float, std::uint32_t>(data, n, base, stride_, little_, big,
+                                        x_, epsilon_, found);
+        break;
+    case NumericType::Float64:
+        scanFloat<double, std::uint64_t>(data, n, base, stride_, little_,
+                                         big, x_, epsilon_, found);
+        break;
+    }
+}
+
+#define STRINGIFY_(x) #x
+#define STRINGIFY(x) STRINGIFY_(x)
+
+string NumericQuery::format(const byte* data, bool littleEndian) const {
+    char buf[32];
+    bufsize w = width();
+    switch (type_) {
+    case NumericType::Int8:
+        intToString(sizeof(buf), buf,
+                    intFromBytes<std::int8_t>(w, data, littleEndian));
+        break;
+    case NumericType::UInt8:
+        uintToString(sizeof(buf), buf,
+                     uintFromBytes<std::uint8_t>(w, data, littleEndian));
+        break;
+    case NumericType::Int16:
+        intToString(sizeof(buf), buf,
+                    intFromBytes<std::int16_t>(w, data, littleEndian));
+        break;
+    case NumericType::UInt16:
+        uintToString(sizeof(buf), buf,
+                     uintFromBytes<std::uint16_t>(w, data, littleEndian));
+        break;
+    case NumericType::Int32:
+        intToString(sizeof(buf), buf,
+                    intFromBytes<std::int32_t>(w, data, littleEndian));
+        break;
+    case NumericType::UInt32:
+        uintToString(sizeof(buf), buf,
+                     uintFromBytes<std::uint32_t>(w, data, littleEndian));
+        break;
+    case NumericType::Int64:
+        intToString(sizeof(buf), buf,
+                    intFromBytes<std::int64_t>(w, data, littleEndian));
+        break;
+    case NumericType::UInt64:
+        uintToString(sizeof(buf), buf,
+                     uintFromBytes<std::uint64_t>(w, data, littleEndian));
+        break;
+    case NumericType::Float32:
+        std::snprintf(buf, sizeof(buf), "%." STRINGIFY(FLT_DIG) "g",
+                      std::bit_cast<float>(uintFromBytes<std::uint32_t>(
+                          w, data, littleEndian)));
+        break;
+    case NumericType::Float64:
+        std::snprintf(buf, sizeof(buf), "%." STRINGIFY(DBL_DIG) "g",
+                      std::bit_cast<double>(uintFromBytes<std::uint64_t>(
+                          w, data, littleEndian)));
+        break;
+    }
+    return string(buf);
+}
+
+};  // namespace hexbed
@@ -0,0 +1,97 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/numsearch.hh -- header for numeric value and range searching
+
+#ifndef HEXBED_FILE_NUMSEARCH_HH
+#define HEXBED_FILE_NUMSEARCH_HH
+
+#include <cstdint>
+#include <functional>
+
+#include "common/types.hh"
+
+namespace hexbed {
+
+enum class NumericType {
+    Int8,
+    UInt8,
+    Int16,
+    UInt16,
+    Int32,
+    UInt32,
+    Int64,
+    UInt64,
+    Float32,
+    Float64
+};
+
+bufsize numericTypeWidth(NumericType type) noexcept;
+bool numericTypeIsSigned(NumericType type) noexcept;
+bool numericTypeIsFloat(NumericType type) noexcept;
+
+// matches values of a numeric type that fall within a range, at every
+// offset that is a multiple of the stride, in either or both byte orders
+class NumericQuery {
+  public:
+    // offset of the value, whether it was read as little endian
+    using Callback = std::function<void(bufoffset, bool)>;
+
+    // inclusive bounds, clamped to the range of the type
+    static NumericQuery inSigned(NumericType type, std::int64_t lo,
+                                 std::int64_t hi);
+    static NumericQuery inUnsigned(NumericType type, std::uint64_t lo,
+                                   std::uint64_t hi);
+    // |value - x| <= epsilon. NaNs never match
+    static NumericQuery nearFloat(NumericType type, double x, double epsilon);
+
+    NumericQuery& byteOrders(bool little, bool big) noexcept;
+    NumericQuery& stride(bufsize stride) noexcept;
+
+    inline NumericType type() const noexcept { return type_; }
+    inline bufsize width() const noexcept { return numericTypeWidth(type_); }
+    inline bufsize stride() const noexcept { return stride_; }
+
+    // checks every value that lies wholly within the n bytes at data,
+    // which start at document offset base. found is called in ascending
+    // order of offset, little endian first when both match
+    void scan(const byte* data, bufsize n, bufoffset base,
+              const Callback& found) const;
+    // formats the value at data, which must have at least width() bytes
+    string format(const byte* data, bool littleEndian) const;
+
+  private:
+    NumericQuery(NumericType type) noexcept;
+
+    NumericType type_;
+    // integer bounds as raw bits, so that signed ranges compare the same
+    // way as unsigned ones
+    std::uint64_t lo_{0};
+    std::uint64_t span_{0};
+    double x_{0};
+    double epsilon_{0};
+    bool little_{true};
+    bool big_{true};
+    bufsize stride_{1};
+    bool none_{false};
+};
+
+};  // namespace hexbed
+
+#endif /* HEXBED_FILE_NUMSEARCH_HH */
@@ -0,0 +1,847 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/regex.cc -- impl for byte regular expressions
+
+#include "file/regex.hh"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <stdexcept>
+#include <utility>
+
+#include "common/hexconv.hh"
+#include "file/document.hh"
+
+namespace hexbed {
+
+static constexpr unsigned REGEX_REPEAT_MAX = 1000;
+static constexpr unsigned REGEX_REPEAT_INFINITE = UINT_MAX;
+static constexpr unsigned REGEX_DEPTH_MAX = 256;
+static constexpr std::size_t REGEX_PROGRAM_MAX = 1 << 18;
+static constexpr std::size_t REGEX_DFA_STATES = 4096;
+static constexpr bufsize REGEX_BUFFER = 1 << 16;
+static constexpr bufsize REGEX_NO_SLOT = static_cast<bufsize>(-1);
+// ends the state list of an ordered DFA that no longer starts new matches
+static constexpr std::uint32_t REGEX_STOPPED = UINT32_MAX;
+
+struct RegexNode {
+    enum class Type {
+        Empty,
+        Set,
+        Concat,
+        Alternate,
+        Repeat,
+        Group,
+        Begin,
+        End
+    };
+    Type type{Type::Empty};
+    std::bitset<256> set;
+    std::vector<RegexNode> children;
+    unsigned min{0};
+    unsigned max{0};
+    bool greedy{true};
+    unsigned group{0};
+};
+
+static constexpr int REGEX_ESCAPE_SET = -1;
+static constexpr int REGEX_ESCAPE_BEGIN = -2;
+static constexpr int REGEX_ESCAPE_END = -3;
+
+class RegexParser {
+  public:
+    RegexParser(const std::string& text) : text_(text) {}
+
+    RegexNode parse() {
+        RegexNode node = parseAlternate();
+        if (more()) fail("unmatched )");
+        return node;
+    }
+
+    inline unsigned groups() const noexcept { return groups_; }
+
+  private:
+    [[noreturn]] void fail(const char* message) const {
+        throw std::runtime_error(std::string(message) + " at position " +
+                                 std::to_string(pos_));
+    }
+
+    inline bool more() const noexcept { return pos_ < text_.size(); }
+    inline char peek() const noexcept { return text_[pos_]; }
+    inline bool accept(char c) noexcept {
+        if (!more() || peek() != c) return false;
+        ++pos_;
+        return true;
+    }
+
+    RegexNode parseAlternate() {
+        if (++depth_ > REGEX_DEPTH_MAX) fail("expression nested too deeply");
+        RegexNode node = parseConcat();
+        if (more() && peek() == '|') {
+            RegexNode alt;
+            alt.type = RegexNode::Type::Alternate;
+            alt.children.push_back(std::move(node));
+            while (accept('|')) alt.children.push_back(parseConcat());
+            node = std::move(alt);
+        }
+        --depth_;
+        return node;
+    }
+
+    RegexNode parseConcat() {
+        RegexNode cat;
+        cat.type = RegexNode::Type::Concat;
+        while (more() && peek() != '|' && peek() != ')')
+            cat.children.push_back(parseRepeat());
+        if (cat.children.size() == 1) {
+            RegexNode only = std::move(cat.children[0]);
+            return only;
+        }
+        return cat;
+    }
+
+    unsigned parseCount() {
+        if (!more() || peek() < '0' || peek() > '9')
+            fail("invalid repetition");
+        unsigned n = 0;
+        while (more() && '0' <= peek() && peek() <= '9') {
+            n = n * 10 + (text_[pos_++] - '0');
+            if (n > REGEX_REPEAT_MAX) fail("repetition count too large");
+        }
+        return n;
+    }
+
+    RegexNode parseRepeat() {
+        RegexNode node = parseAtom();
+        unsigned nested = 0;
+        while (more()) {
+            unsigned lo, hi;
+            switch (peek()) {
+            case '*':
+                lo = 0, hi = REGEX_REPEAT_INFINITE;
+                break;
+            case '+':
+                lo = 1, hi = REGEX_REPEAT_INFINITE;
+                break;
+            case '?':
+                lo = 0, hi = 1;
+                break;
+            case '{':
+                break;
+            default:
+                return node;
+            }
+            if (node.type == RegexNode::Type::Begin ||
+                node.type == RegexNode::Type::End)
+                fail("nothing to repeat");
+            if (++nested > REGEX_DEPTH_MAX) fail("too many repetitions");
+            if (accept('{')) {
+                lo = hi = parseCount();
+                if (accept(','))
+                    hi = more() && peek() == '}' ? REGEX_REPEAT_INFINITE
+                                                 : parseCount();
+                if (!accept('}')) fail("invalid repetition");
+                if (hi < lo) fail("invalid repetition range");
+            } else {
+                ++pos_;
+            }
+            RegexNode rep;
+            rep.type = RegexNode::Type::Repeat;
+            rep.min = lo;
+            rep.max = hi;
+            rep.greedy = !accept('?');
+            rep.children.push_back(std::move(node));
+            node = std::move(rep);
+        }
+        return node;
+    }
+
+    // returns the byte, or one of the REGEX_ESCAPE_ constants
+    int parseEscape(std::bitset<256>& set, bool inClass) {
+        if (!more()) fail("trailing backslash");
+        char c = text_[pos_++];
+        int v = -1;
+        std::bitset<256> cls;
+        switch (c) {
+        case 'x': {
+            int hi = more() ? hexDigitToNum(text_[pos_++]) : -1;
+            int lo = more() ? hexDigitToNum(text_[pos_++]) : -1;
+            if (hi < 0 || lo < 0) fail("\\x needs two hex digits");
+            v = hi * 16 + lo;
+            break;
+        }
+        case '0':
+            v = 0;
+            break;
+        case 'a':
+            v = '\a';
+            break;
+        case 'e':
+            v = 0x1B;
+            break;
+        case 'f':
+            v = '\f';
+            break;
+        case 'n':
+            v = '\n';
+            break;
+        case 'r':
+            v = '\r';
+            break;
+        case 't':
+            v = '\t';
+            break;
+        case 'v':
+            v = '\v';
+            break;
+        case 'd':
+        case 'D':
+            for (int b = '0'; b <= '9'; ++b) cls.set(b);
+            break;
+        case 'w':
+        case 'W':
+            for (int b = '0'; b <= '9'; ++b) cls.set(b);
+            for (int b = 'A'; b <= 'Z'; ++b) cls.set(b);
+            for (int b = 'a'; b <= 'z'; ++b) cls.set(b);
+            cls.set('_');
+            break;
+        case 's':
+        case 'S':
+            for (int b : {' ', '\t', '\n', '\v', '\f', '\r'}) cls.set(b);
+            break;
+        case 'A':
+            if (inClass) fail("anchor in a character class");
+            return REGEX_ESCAPE_BEGIN;
+        case 'z':
+            if (inClass) fail("anchor in a character class");
+            return REGEX_ESCAPE_END;
+        default:
+            if (('0' <= c && c <= '9') || ('A' <= c && c <= 'Z') ||
+                ('a' <= c && c <= 'z'))
+                fail("unknown escape");
+            v = static_cast<byte>(c);
+        }
+        if (v >= 0) {
+            set.set(v);
+            return v;
+        }
+        if (c == 'D' || c == 'W' || c == 'S') cls.flip();
+        set |= cls;
+        return REGEX_ESCAPE_SET;
+    }
+
+    int parseClassAtom(std::bitset<256>& set) {
+        if (accept('\\')) return parseEscape(set, true);
+        byte c = static_cast<byte>(text_[pos_++]);
+        set.set(c);
+        return c;
+    }
+
+    void parseClass(std::bitset<256>& set) {
+        bool negate = accept('^');
+        bool first = true;
+        for (;;) {
+            if (!more()) fail("missing ]");
+            if (!first && accept(']')) break;
+            first = false;
+            int lo = parseClassAtom(set);
+            if (lo >= 0 && pos_ + 1 < text_.size() && peek() == '-' &&
+                text_[pos_ + 1] != ']') {
+                ++pos_;
+                std::bitset<256> dummy;
+                int hi = parseClassAtom(dummy);
+                if (hi < lo) fail("invalid range in a character class");
+                for (int b = lo; b <= hi; ++b) set.set(b);
+            }
+        }
+        if (negate) set.flip();
+    }
+
+    RegexNode parseAtom() {
+        RegexNode node;
+        node.type = RegexNode::Type::Set;
+        char c = text_[pos_++];
+        switch (c) {
+        case '(': {
+            unsigned group = 0;
+            if (accept('?')) {
+                if (!accept(':')) fail("unknown group type");
+            } else
+                group = ++groups_;
+            RegexNode inner = parseAlternate();
+            if (!accept(')')) fail("missing )");
+            if (!group) return inner;
+            node.type = RegexNode::Type::Group;
+            node.group = group;
+            node.children.push_back(std::move(inner));
+            break;
+        }
+        case '*':
+        case '+':
+        case '?':
+        case '{':
+            --pos_;
+            fail("nothing to repeat");
+        case '[':
+            parseClass(node.set);
+            break;
+        case '.':
+            node.set.set();
+            break;
+        case '^':
+            node.type = RegexNode::Type::Begin;
+            break;
+        case '$':
+            node.type = RegexNode::Type::End;
+            break;
+        case '\\':
+            switch (parseEscape(node.set, false)) {
+            case REGEX_ESCAPE_BEGIN:
+                node.type = RegexNode::Type::Begin;
+                break;
+            case REGEX_ESCAPE_END:
+                node.type = RegexNode::Type::End;
+                break;
+            }
+            break;
+        default:
+            node.set.set(static_cast<byte>(c));
+        }
+        return node;
+    }
+
+    const std::string& text_;
+    std::size_t pos_{0};
+    unsigned depth_{0};
+    unsigned groups_{0};
+};
+
+class RegexCompiler {
+  public:
+    RegexCompiler(RegexProgram& program, bool reverse)
+        : program_(program), reverse_(reverse) {}
+
+    std::uint32_t push(RegexProgram::Op op, std::uint32_t out,
+                       std::uint32_t arg) {
+        if (program_.insts.size() >= REGEX_PROGRAM_MAX)
+            throw std::runtime_error("regular expression is too large");
+        program_.insts.push_back(RegexProgram::Inst{op, out, arg});
+        return program_.insts.size() - 1;
+    }
+
+    // emits code for node that continues to next and returns its entry
+    std::uint32_t emit(const RegexNode& node, std::uint32_t next) {
+        using Op = RegexProgram::Op;
+        switch (node.type) {
+        case RegexNode::Type::Empty:
+            return next;
+        case RegexNode::Type::Set:
+            return push(Op::Byte, next, setIndex(node.set));
+        case RegexNode::Type::Begin:
+            return push(reverse_ ? Op::AssertEnd : Op::AssertBegin, next, 0);
+        case RegexNode::Type::End:
+            return push(reverse_ ? Op::AssertBegin : Op::AssertEnd, next, 0);
+        case RegexNode::Type::Concat:
+            if (reverse_)
+                for (const RegexNode& child : node.children)
+                    next = emit(child, next);
+            else
+                for (auto it = node.children.rbegin();
+                     it != node.children.rend(); ++it)
+                    next = emit(*it, next);
+            return next;
+        case RegexNode::Type::Alternate: {
+            std::uint32_t entry = emit(node.children.back(), next);
+            for (std::size_t k = node.children.size() - 1; k-- > 0;)
+                entry = push(Op::Split, emit(node.children[k], next), entry);
+            return entry;
+        }
+        case RegexNode::Type::Group:
+            if (reverse_) return emit(node.children[0], next);
+            next = push(Op::Save, next, node.group * 2 + 1);
+            next = emit(node.children[0], next);
+            return push(Op::Save, next, node.group * 2);
+        case RegexNode::Type::Repeat: {
+            const RegexNode& body = node.children[0];
+            std::uint32_t entry = next;
+            if (node.max == REGEX_REPEAT_INFINITE) {
+                std::uint32_t loop = push(Op::Split, 0, 0);
+                std::uint32_t b = emit(body, loop);
+                program_.insts[loop] =
+                    node.greedy ? RegexProgram::Inst{Op::Split, b, next}
+                                : RegexProgram::Inst{Op::Split, next, b};
+                entry = loop;
+            } else {
+                for (unsigned k = node.min; k < node.max; ++k) {
+                    std::uint32_t b = emit(body, entry);
+                    entry = node.greedy ? push(Op::Split, b, next)
+                                        : push(Op::Split, next, b);
+                }
+            }
+            for (unsigned k = 0; k < node.min; ++k) entry = emit(body, entry);
+            return entry;
+        }
+        }
+        return next;
+    }
+
+  private:
+    std::uint32_t setIndex(const std::bitset<256>& set) {
+        std::array<std::uint64_t, 4> key{};
+        for (unsigned b = 0; b < 256; ++b)
+            if (set.test(b)) key[b / 64] |= std::uint64_t(1) << (b % 64);
+        auto [it, inserted] = sets_.try_emplace(key, program_.sets.size());
+        if (inserted) program_.sets.push_back(set);
+        return it->second;
+    }
+
+    RegexProgram& program_;
+    bool reverse_;
+    std::map<std::array<std::uint64_t, 4>, std::uint32_t> sets_;
+};
+
+static void computeRegexClasses(RegexProgram& program) {
+    std::array<unsigned, 256> cls{};
+    unsigned count = 1;
+    for (const std::bitset<256>& set : program.sets) {
+        std::map<std::pair<unsigned, bool>, unsigned> split;
+        for (unsigned b = 0; b < 256; ++b)
+            cls[b] = split.try_emplace({cls[b], set.test(b)}, split.size())
+                         .first->second;
+        count = split.size();
+    }
+    for (unsigned b = 256; b-- > 0;) {
+        program.classOf[b] = cls[b];
+        program.classByte[cls[b]] = b;
+    }
+    program.classCount = count;
+}
+
+static std::shared_ptr<const RegexProgram> compileRegex(
+    const std::string& pattern, bool reverse) {
+    using Op = RegexProgram::Op;
+    RegexParser parser(pattern);
+    RegexNode root = parser.parse();
+    auto program = std::make_shared<RegexProgram>();
+    RegexCompiler compiler(*program, reverse);
+    std::uint32_t next = compiler.push(Op::Match, 0, 0);
+    if (!reverse) next = compiler.push(Op::Save, next, 1);
+    next = compiler.emit(root, next);
+    if (!reverse) next = compiler.push(Op::Save, next, 0);
+    program->start = next;
+    program->slots = reverse ? 0 : (parser.groups() + 1) * 2;
+    computeRegexClasses(*program);
+    return program;
+}
+
+RegexDFA::RegexDFA(std::shared_ptr<const RegexProgram> program,
+                   bool unanchored, bool ordered)
+    : program_(std::move(program)),
+      unanchored_(unanchored),
+      ordered_(ordered),
+      stride_(program_->classCount),
+      mark_(program_->insts.size(), 0) {
+    if (unanchored_) {
+        ++generation_;
+        closure(inside_, program_->start, false, false);
+    }
+}
+
+void RegexDFA::closure(std::vector<std::uint32_t>& out, std::uint32_t pc,
+                       bool begin, bool end) {
+    using Op = RegexProgram::Op;
+    stack_.push_back(pc);
+    while (!stack_.empty()) {
+        pc = stack_.back();
+        stack_.pop_back();
+        if (mark_[pc] == generation_) continue;
+        mark_[pc] = generation_;
+        const RegexProgram::Inst& inst = program_->insts[pc];
+        switch (inst.op) {
+        case Op::Split:
+            stack_.push_back(inst.arg);
+            [[fallthrough]];
+        case Op::Jump:
+        case Op::Save:
+            stack_.push_back(inst.out);
+            break;
+        case Op::AssertBegin:
+            if (begin) stack_.push_back(inst.out);
+            break;
+        case Op::AssertEnd:
+            // kept, in case the scan ends right here
+            if (end)
+                stack_.push_back(inst.out);
+            else
+                out.push_back(pc);
+            break;
+        case Op::Byte:
+        case Op::Match:
+            out.push_back(pc);
+        }
+    }
+}
+
+void RegexDFA::reset() {
+    sets_.clear();
+    index_.clear();
+    trans_.clear();
+    flags_.clear();
+}
+
+RegexDFA::State RegexDFA::intern(std::vector<std::uint32_t>& set) {
+    using Op = RegexProgram::Op;
+    if (!ordered_) std::sort(set.begin(), set.end());
+    auto it = index_.find(set);
+    if (it != index_.end()) return it->second;
+    if (sets_.size() >= REGEX_DFA_STATES) reset();
+    std::uint8_t flags = 0;
+    std::vector<std::uint32_t> tail;
+    ++generation_;
+    for (std::uint32_t pc : set) {
+        if (pc == REGEX_STOPPED) continue;
+        const RegexProgram::Inst& inst = program_->insts[pc];
+        if (inst.op == Op::Match)
+            flags |= 3;
+        else if (inst.op == Op::AssertEnd)
+            closure(tail, inst.out, false, true);
+    }
+    for (std::uint32_t pc : tail)
+        if (program_->insts[pc].op == Op::Match) flags |= 2;
+    State s = sets_.size();
+    index_.emplace(set, s);
+    sets_.push_back(std::move(set));
+    trans_.resize(trans_.size() + stride_, UNKNOWN);
+    flags_.push_back(flags);
+    return s;
+}
+
+RegexDFA::State RegexDFA::start(bool atBoundary) {
+    std::vector<std::uint32_t> set;
+    ++generation_;
+    if (!unanchored_ || atBoundary)
+        closure(set, program_->start, atBoundary, false);
+    // an empty match does not count, so it does not cut anything off
+    if (ordered_)
+        std::erase_if(set, [this](std::uint32_t pc) {
+            return program_->insts[pc].op == RegexProgram::Op::Match;
+        });
+    if (!unanchored_ && set.empty()) return DEAD;
+    return intern(set);
+}
+
+RegexDFA::State RegexDFA::inside() {
+    std::vector<std::uint32_t> set;
+    ++generation_;
+    for (const RegexProgram::Inst& inst : program_->insts)
+        if (inst.op == RegexProgram::Op::Byte)
+            closure(set, inst.out, false, false);
+    return set.empty() ? DEAD : intern(set);
+}
+
+RegexDFA::State RegexDFA::compute(State s, byte b) {
+    using Op = RegexProgram::Op;
+    const RegexProgram& program = *program_;
+    std::vector<std::uint32_t> next;
+    ++generation_;
+    // returns true if an ordered DFA reached a match, which cuts off
+    // everything of lower priority
+    auto advance = [&](std::uint32_t pc) -> bool {
+        if (pc == REGEX_STOPPED) return false;
+        const RegexProgram::Inst& inst = program.insts[pc];
+        if (inst.op != Op::Byte || !program.sets[inst.arg].test(b))
+            return false;
+        std::size_t n = next.size();
+        closure(next, inst.out, false, false);
+        if (!ordered_) return false;
+        for (; n < next.size(); ++n) {
+            if (program.insts[next[n]].op == Op::Match) {
+                next.resize(n + 1);
+                return true;
+            }
+        }
+        return false;
+    };
+    bool stopped = ordered_ && !sets_[s].empty() &&
+                   sets_[s].back() == REGEX_STOPPED;
+    bool cut = false;
+    for (std::uint32_t pc : sets_[s])
+        if ((cut = advance(pc))) break;
+    if (unanchored_ && !stopped && !cut)
+        for (std::uint32_t pc : inside_)
+            if ((cut = advance(pc))) break;
+    if ((!unanchored_ || stopped) && next.empty()) {
+        trans_[s * stride_ + program.classOf[b]] = DEAD;
+        return DEAD;
+    }
+    if (stopped || cut) next.push_back(REGEX_STOPPED);
+    std::size_t count = sets_.size();
+    State t = intern(next);
+    // the cache may have been flushed, invalidating s
+    if (sets_.size() >= count) trans_[s * stride_ + program.classOf[b]] = t;
+    return t;
+}
+
+std::vector<byte> RegexCaptures::expand(const_bytespan replacement) const {
+    std::vector<byte> out;
+    bufsize base = groups.empty() ? 0 : groups[0].offset;
+    std::size_t n = replacement.size();
+    out.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        byte c = replacement[i];
+        if (c == '\\' && i + 1 < n) {
+            byte d = replacement[i + 1];
+            if ('0' <= d && d <= '9') {
+                const RegexGroup* g =
+                    static_cast<std::size_t>(d - '0') < groups.size()
+                        ? &groups[d - '0']
+                        : nullptr;
+                if (g && g->matched) {
+                    auto it = data.begin() + (g->offset - base);
+                    out.insert(out.end(), it, it + g->length);
+                }
+                ++i;
+                continue;
+            } else if (d == '\\') {
+                ++i;
+            }
+        }
+        out.push_back(c);
+    }
+    return out;
+}
+
+ByteRegex::ByteRegex(const std::string& pattern)
+    : forward_(compileRegex(pattern, false)),
+      reverse_(compileRegex(pattern, true)),
+      firstForward_(forward_, true, true),
+      firstBackward_(reverse_, true),
+      longestBackward_(reverse_, false) {}
+
+// feeds [start, end) to the DFA, forwards or backwards, calling
+// visit(state, offset) after every byte until it returns false. returns
+// false if cancelled or a read fails
+template <bool backward, typename F>
+static bool regexScan(HexBedTask& task, const HexBedDocument& document,
+                      RegexDFA& dfa, RegexDFA::State& s, bufsize start,
+                      bufsize end, byte* buffer, F&& visit) {
+    while (start < end) {
+        if (task.isCancelled()) return false;
+        bufsize n = std::min(end - start, REGEX_BUFFER);
+        bufsize at = backward ? end - n : start;
+        if (document.read(at, bytespan(buffer, n)) < n) return false;
+        if constexpr (backward) {
+            for (bufsize i = n; i-- > 0;)
+                if (!visit(s = dfa.step(s, buffer[i]), at + i)) return true;
+            end = at;
+        } else {
+            for (bufsize i = 0; i < n; ++i)
+                if (!visit(s = dfa.step(s, buffer[i]), at + i + 1))
+                    return true;
+            start += n;
+        }
+    }
+    return true;
+}
+
+// finds the first offset in [start, stop) where a match ending at stop
+// starts, or stop if there is none
+bufsize ByteRegex::firstBackward(HexBedTask& task,
+                                 const HexBedDocument& document,
+                                 bufsize start, bufsize stop, bufsize total,
+                                 byte* buffer) {
+    RegexDFA& rdfa = longestBackward_;
+    bufsize first = stop;
+    RegexDFA::State s = rdfa.start(stop == total);
+    if (s == RegexDFA::DEAD) return first;
+    if (!regexScan<true>(task, document, rdfa, s, start, stop, buffer,
+                         [&rdfa, &first](RegexDFA::State t, bufsize o) {
+                             if (t == RegexDFA::DEAD) return false;
+                             if (rdfa.matching(t)) first = o;
+                             return true;
+                         }))
+        return stop;
+    if (s != RegexDFA::DEAD && start == 0 && rdfa.matchingAtEnd(s)) first = 0;
+    return first;
+}
+
+SearchResult ByteRegex::searchForward(HexBedTask& task,
+                                      const HexBedDocument& document,
+                                      bufsize start, bufsize end) {
+    bufsize total = document.size();
+    if (end > total) end = total;
+    if (start >= end) return SearchResult{};
+    auto buffer = std::make_unique<byte[]>(REGEX_BUFFER);
+    byte* bp = buffer.get();
+
+    // find where the preferred match of the leftmost start ends...
+    RegexDFA& dfa = firstForward_;
+    bool found = false;
+    bufsize stop = end;
+    RegexDFA::State s = dfa.start(start == 0);
+    if (!regexScan<false>(task, document, dfa, s, start, end, bp,
+                          [&dfa, &found, &stop](RegexDFA::State t,
+                                                bufsize o) {
+                              if (t == RegexDFA::DEAD) return false;
+                              if (dfa.matching(t)) found = true, stop = o;
+                              return true;
+                          }))
+        return SearchResult{};
+    if (s != RegexDFA::DEAD && end == total && dfa.matchingAtEnd(s))
+        found = true, stop = end;
+    if (!found) return SearchResult{};
+
+    // ...then where it starts; no match ending there can start earlier
+    bufsize first = firstBackward(task, document, start, stop, total, bp);
+    if (task.isCancelled() || first >= stop) return SearchResult{};
+    return SearchResult{SearchResultType::Full, first, stop - first};
+}
+
+SearchResult ByteRegex::searchBackward(HexBedTask& task,
+                                       const HexBedDocument& document,
+                                       bufsize start, bufsize end) {
+    bufsize total = document.size();
+    if (end > total) end = total;
+    if (start >= end) return SearchResult{};
+    auto buffer = std::make_unique<byte[]>(REGEX_BUFFER);
+    byte* bp = buffer.get();
+
+    // walk back over the offsets where matches start, until no match from
+    // further back can reach past the last one seen. a forward search from
+    // start then has to land on that one, so the matches found going
+    // forwards from there are the ones it would find
+    RegexDFA& dfa = firstBackward_;
+    RegexDFA& span = longestBackward_;
+    bool found = false, more = true;
+    bufsize first = start;
+    RegexDFA::State s = dfa.start(end == total), t = RegexDFA::DEAD;
+    for (bufsize pos = end; more && pos > start;) {
+        if (task.isCancelled()) return SearchResult{};
+        bufsize n = std::min(pos - start, REGEX_BUFFER), at = pos - n;
+        if (document.read(at, bytespan(bp, n)) < n) return SearchResult{};
+        for (bufsize i = n; more && i-- > 0;) {
+            s = dfa.step(s, bp[i]);
+            // t has read the bytes between here and first
+            if (found && (t = span.step(t, bp[i])) == RegexDFA::DEAD) {
+                more = false;
+            } else if (dfa.matching(s)) {
+                found = true, first = at + i;
+                t = span.inside();
+            }
+        }
+        pos = at;
+    }
+    if (more && start == 0 && dfa.matchingAtEnd(s)) found = true, first = 0;
+    if (!found) return SearchResult{};
+    buffer.reset();
+
+    SearchResult last;
+    for (bufsize o = first; o < end;) {
+        SearchResult r = searchForward(task, document, o, end);
+        if (!r) break;
+        last = r;
+        o = r.offset + r.length;
+    }
+    return task.isCancelled() ? SearchResult{} : last;
+}
+
+bool ByteRegex::match(const HexBedDocument& document, bufsize offset,
+                      bufsize length, RegexCaptures& captures) const {
+    using Op = RegexProgram::Op;
+    using Slots = std::vector<bufsize>;
+    const RegexProgram& program = *forward_;
+    bufsize total = document.size();
+    if (!length || offset > total || total - offset < length) return false;
+    captures.data.resize(length);
+    if (document.read(offset, bytespan(captures.data.data(), length)) < length)
+        return false;
+    bool atEnd = offset + length == total;
+
+    // a Pike VM, keeping threads in priority order
+    struct Thread {
+        std::uint32_t pc;
+        Slots slots;
+    };
+    std::vector<Thread> cur, next;
+    std::vector<std::pair<std::uint32_t, Slots>> stack;
+    std::vector<bufsize> mark(program.insts.size(), REGEX_NO_SLOT);
+    auto add = [&](std::vector<Thread>& list, std::uint32_t entry,
+                   Slots initial, bufsize pos) {
+        stack.emplace_back(entry, std::move(initial));
+        while (!stack.empty()) {
+            auto [pc, slots] = std::move(stack.back());
+            stack.pop_back();
+            if (mark[pc] == pos) continue;
+            mark[pc] = pos;
+            const RegexProgram::Inst& inst = program.insts[pc];
+            switch (inst.op) {
+            case Op::Split:
+                stack.emplace_back(inst.arg, slots);
+                stack.emplace_back(inst.out, std::move(slots));
+                break;
+            case Op::Save:
+                slots[inst.arg] = pos;
+                [[fallthrough]];
+            case Op::Jump:
+                stack.emplace_back(inst.out, std::move(slots));
+                break;
+            case Op::AssertBegin:
+                if (pos == 0 && offset == 0)
+                    stack.emplace_back(inst.out, std::move(slots));
+                break;
+            case Op::AssertEnd:
+                if (pos == length && atEnd)
+                    stack.emplace_back(inst.out, std::move(slots));
+                break;
+            case Op::Byte:
+            case Op::Match:
+                list.push_back(Thread{pc, std::move(slots)});
+            }
+        }
+    };
+
+    add(cur, program.start, Slots(program.slots, REGEX_NO_SLOT), 0);
+    for (bufsize i = 0; i < length && !cur.empty(); ++i) {
+        byte b = captures.data[i];
+        next.clear();
+        for (Thread& t : cur) {
+            const RegexProgram::Inst& inst = program.insts[t.pc];
+            if (inst.op == Op::Byte && program.sets[inst.arg].test(b))
+                add(next, inst.out, std::move(t.slots), i + 1);
+        }
+        std::swap(cur, next);
+    }
+    for (const Thread& t : cur) {
+        if (program.insts[t.pc].op != Op::Match) continue;
+        captures.groups.resize(program.slots / 2);
+        for (std::size_t g = 0; g < captures.groups.size(); ++g) {
+            bufsize a = t.slots[g * 2], z = t.slots[g * 2 + 1];
+            RegexGroup& group = captures.groups[g];
+            group.matched = a != REGEX_NO_SLOT && z != REGEX_NO_SLOT;
+            group.offset = group.matched ? offset + a : 0;
+            group.length = group.matched ? z - a : 0;
+        }
+        return true;
+    }
+    return false;
+}
+
+};  // namespace hexbed
@@ -0,0 +1,176 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/regex.hh -- header for byte regular expressions
+
+#ifndef HEXBED_FILE_REGEX_HH
+#define HEXBED_FILE_REGEX_HH
+
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/types.hh"
+#include "file/document-fwd.hh"
+#include "file/search.hh"
+#include "file/task.hh"
+
+namespace hexbed {
+
+// a compiled NFA. the reverse program matches the reversed language and is
+// used to find where a match starts once its end is known
+struct RegexProgram {
+    enum class Op : std::uint8_t {
+        Byte,         // out on a byte in sets[arg]
+        Split,        // out (preferred) or arg
+        Jump,         // out
+        Save,         // out; capture slot arg
+        AssertBegin,  // out if at the boundary the scan started from
+        AssertEnd,    // out if at the boundary the scan ends at
+        Match
+    };
+    struct Inst {
+        Op op;
+        std::uint32_t out;
+        std::uint32_t arg;
+    };
+
+    std::vector<Inst> insts;
+    std::vector<std::bitset<256>> sets;
+    std::uint32_t start{0};
+    std::size_t slots{0};
+    // bytes that no set tells apart share a class
+    byte classOf[256]{};
+    byte classByte[256]{};
+    unsigned classCount{1};
+};
+
+// DFA states are built on demand from sets of NFA states and cached
+class RegexDFA {
+  public:
+    using State = std::int32_t;
+    static constexpr State DEAD = -1;
+
+    // an unanchored DFA may start a new match before every byte. an ordered
+    // DFA keeps its NFA states in priority order, as a backtracking engine
+    // would try them: once a match is reached, the states after it and any
+    // later starts are dropped, so that the last match seen before the DFA
+    // dies ends the preferred match of the leftmost start
+    RegexDFA(std::shared_ptr<const RegexProgram> program, bool unanchored,
+             bool ordered = false);
+
+    State start(bool atBoundary);
+    // a state that has read at least one byte of some match. it dies once
+    // the bytes read after that can no longer continue any match
+    State inside();
+    inline State step(State s, byte b) {
+        State t = trans_[s * stride_ + program_->classOf[b]];
+        return t != UNKNOWN ? t : compute(s, b);
+    }
+    // a match of at least one byte ends here
+    inline bool matching(State s) const noexcept { return flags_[s] & 1; }
+    // as above, if here is also the boundary the scan ends at
+    inline bool matchingAtEnd(State s) const noexcept { return flags_[s] & 2; }
+
+  private:
+    static constexpr State UNKNOWN = -2;
+
+    State compute(State s, byte b);
+    State intern(std::vector<std::uint32_t>& set);
+    void closure(std::vector<std::uint32_t>& out, std::uint32_t pc,
+                 bool begin, bool end);
+    void reset();
+
+    std::shared_ptr<const RegexProgram> program_;
+    bool unanchored_;
+    bool ordered_;
+    std::size_t stride_;
+    std::vector<std::uint32_t> inside_;
+    std::vector<std::vector<std::uint32_t>> sets_;
+    std::map<std::vector<std::uint32_t>, State> index_;
+    std::vector<State> trans_;
+    std::vector<std::uint8_t> flags_;
+    std::vector<std::uint32_t> mark_;
+    std::uint32_t generation_{0};
+    std::vector<std::uint32_t> stack_;
+};
+
+struct RegexGroup {
+    bufsize offset{0};
+    bufsize length{0};
+    bool matched{false};
+};
+
+struct RegexCaptures {
+    // the bytes of the whole match
+    std::vector<byte> data;
+    // group 0 is the whole match
+    std::vector<RegexGroup> groups;
+
+    // copies the template, replacing \0 to \9 with the captured groups
+    // and \\ with a single backslash
+    std::vector<byte> expand(const_bytespan replacement) const;
+};
+
+// patterns work on bytes: . matches any byte, \xNN is a byte, ^ and $
+// anchor to the start and end of the document. the match that starts first
+// is taken, and from there the pattern picks the end as a backtracking
+// engine would: greedy repeats take as much as they can, lazy ones as
+// little, and alternatives are tried left to right. matches are at least
+// one byte long
+class ByteRegex {
+  public:
+    explicit ByteRegex(const std::string& pattern);
+
+    inline std::size_t groups() const noexcept {
+        return forward_->slots / 2;
+    }
+
+    // finds a match within [start, end)
+    SearchResult searchForward(HexBedTask& task,
+                               const HexBedDocument& document, bufsize start,
+                               bufsize end);
+    // finds the match that starts last within [start, end), unless the
+    // match from an earlier start runs into it and so would hide it from a
+    // forward search; then that one is taken instead, and so on
+    SearchResult searchBackward(HexBedTask& task,
+                                const HexBedDocument& document,
+                                bufsize start, bufsize end);
+    // checks whether [offset, offset + length) is a match and captures
+    bool match(const HexBedDocument& document, bufsize offset, bufsize length,
+               RegexCaptures& captures) const;
+
+  private:
+    bufsize firstBackward(HexBedTask& task, const HexBedDocument& document,
+                          bufsize start, bufsize stop, bufsize total,
+                          byte* buffer);
+
+    std::shared_ptr<const RegexProgram> forward_;
+    std::shared_ptr<const RegexProgram> reverse_;
+    RegexDFA firstForward_;
+    RegexDFA firstBackward_;
+    RegexDFA longestBackward_;
+};
+
+};  // namespace hexbed
+
+#endif /* HEXBED_FILE_REGEX_HH */
@@ -20,16 +20,198 @@
 // file/search.cc -- impl for byte string searching with two buffers
 
 #include "file/search.hh"
+#include <algorithm>
 
 #include "common/logger.hh"
 #include "common/memory.hh"
 
 namespace hexbed {
 
+// rough rank of how common a byte is in binary files; common bytes make for
+// poor filters
+static int byteCommonness(byte c) noexcept {
+    if (c == 0x00) return 4;
+    if (c == 0xFF) return 3;
+    if (c == 0x20 || (c >= 0x61 && c <= 0x7A)) return 2;
+    if (c < 0x80) return 1;
+    return 0;
+}
+
+// picks two needle positions to test before comparing the whole needle
+static void pickFilterPair(bufsize nlen, const byte* ndata, bufsize& i,
+                           bufsize& j) noexcept {
+    i = 0;
+    for (bufsize k = 1; k < nlen; ++k)
+        if (byteCommonness(ndata[k]) < byteCommonness(ndata[i])) i = k;
+    j = i ? 0 : nlen - 1;
+    auto score = [&](bufsize k) {
+        // prefer a different byte value, then a rare one, then distance
+        return (ndata[k] == ndata[i] ? 8 : 0) + byteCommonness(ndata[k]);
+    };
+    for (bufsize k = 0; k < nlen; ++k) {
+        if (k == i) continue;
+        int sk = score(k), sj = score(j);
+        bufsize dk = k > i ? k - i : i - k, dj = j > i ? j - i : i - j;
+        if (sk < sj || (sk == sj && dk > dj)) j = k;
+    }
+}
+
+// needles at least this long skip ahead instead of testing every position
+constexpr bufsize LONG_NEEDLE = 32;
+// long needles with fewer distinct bytes than this get short Horspool
+// shifts, so they use Two-Way for its linear worst case instead
+constexpr unsigned SMALL_ALPHABET = 16;
+constexpr bufsize NO_MATCH = static_cast<bufsize>(-1);
+
+// view into a buffer that can be read back to front, so that the same
+// kernels find both the first and the last match
+template <bool rev>
+struct ByteView {
+    const byte* p;
+    bufsize n;
+
+    inline byte operator[](bufsize i) const noexcept {
+        return rev ? p[n - 1 - i] : p[i];
+    }
+    // memory address of the view range [i, i + k)
+    inline const byte* at(bufsize i, bufsize k) const noexcept {
+        return rev ? p + n - i - k : p + i;
+    }
+};
+
+template <bool rev>
+static bufsize searchHorspool(ByteView<rev> s, ByteView<rev> nd) noexcept {
+    bufsize m = nd.n, last = m - 1, mid = last / 2;
+    bufsize shift[256];
+    for (bufsize& x : shift) x = m;
+    for (bufsize k = 0; k < last; ++k) shift[nd[k]] = last - k;
+    byte nf = nd[0], nm = nd[mid], nl = nd[last];
+    for (bufsize j = 0; j + m <= s.n; j += shift[s[j + last]]) {
+        // Raita: last, first and middle bytes before the whole needle
+        if (s[j + last] == nl && s[j] == nf && s[j + mid] == nm &&
+            memEqual(s.at(j, m), nd.p, m))
+            return j;
+    }
+    return NO_MATCH;
+}
+
+// Crochemore-Perrin critical factorization; returns the split point
+template <bool rev>
+static bufsize criticalFactorization(ByteView<rev> nd,
+                                     bufsize& period) noexcept {
+    bufsize m = nd.n;
+    bufsize ms[2], ps[2];
+    for (int pass = 0; pass < 2; ++pass) {
+        bufsize x = NO_MATCH, j = 0, k = 1, p = 1;
+        while (j + k < m) {
+            byte a = nd[j + k], b = nd[x + k];
+            if (pass ? b < a : a < b) {
+                j += k;
+                k = 1;
+                p = j - x;
+            } else if (a == b) {
+                if (k != p)
+                    ++k;
+                else {
+                    j += p;
+                    k = 1;
+                }
+            } else {
+                x = j++;
+                k = p = 1;
+            }
+        }
+        ms[pass] = x + 1, ps[pass] = p;
+    }
+    int w = ms[1] < ms[0] ? 0 : 1;
+    period = ps[w];
+    return ms[w];
+}
+
+template <bool rev>
+static bufsize searchTwoWay(ByteView<rev> s, ByteView<rev> nd) noexcept {
+    bufsize m = nd.n, period;
+    bufsize suffix = criticalFactorization(nd, period);
+    bool periodic = true;
+    for (bufsize k = 0; k < suffix; ++k) {
+        if (nd[k] != nd[k + period]) {
+            periodic = false;
+            break;
+        }
+    }
+    bufsize j = 0, i;
+    if (periodic) {
+        bufsize memory = 0;
+        while (j + m <= s.n) {
+            i = std::max(suffix, memory);
+            while (i < m && nd[i] == s[i + j]) ++i;
+            if (i < m) {
+                j += i - suffix + 1;
+                memory = 0;
+                continue;
+            }
+            i = suffix - 1;
+            while (memory < i + 1 && nd[i] == s[i + j]) --i;
+            if (i + 1 < memory + 1) return j;
+            j += period;
+            memory = m - period;
+        }
+    } else {
+        period = std::max(suffix, m - suffix) + 1;
+        while (j + m <= s.n) {
+            i = suffix;
+            while (i < m && nd[i] == s[i + j]) ++i;
+            if (i < m) {
+                j += i - suffix + 1;
+                continue;
+            }
+            i = suffix - 1;
+            while (i != NO_MATCH && nd[i] == s[i + j]) --i;
+            if (i == NO_MATCH) return j;
+            j += period;
+        }
+    }
+    return NO_MATCH;
+}
+
+// view position of the first whole match of a long needle, or NO_MATCH
+template <bool rev>
+static bufsize searchLong(ByteView<rev> s, ByteView<rev> nd) noexcept {
+    bool seen[256]{};
+    unsigned distinct = 0;
+    for (bufsize k = 0; k < nd.n && distinct < SMALL_ALPHABET; ++k)
+        if (!seen[nd.p[k]]) seen[nd.p[k]] = true, ++distinct;
+    return distinct < SMALL_ALPHABET ? searchTwoWay(s, nd)
+                                     : searchHorspool(s, nd);
+}
+
 SearchResult searchPartialForward(bufsize slen, const byte* sdata, bufsize nlen,
                                   const byte* ndata, bool allowPartial) {
     const byte* send = sdata + slen;
     const byte* schr = sdata;
+    if (nlen > 1 && slen >= nlen) {
+        // every position where the whole needle fits
+        const byte* slast = send - nlen + 1;
+        if (nlen >= LONG_NEEDLE) {
+            bufsize k = searchLong(ByteView<false>{sdata, slen},
+                                   ByteView<false>{ndata, nlen});
+            if (k != NO_MATCH)
+                return SearchResult{SearchResultType::Full, k, nlen - 1};
+        } else {
+            bufsize i, j;
+            pickFilterPair(nlen, ndata, i, j);
+            while ((schr = memFindPair(schr, slast, i, ndata[i], j,
+                                       ndata[j]))) {
+                if (memEqual(schr, ndata, nlen))
+                    return SearchResult{SearchResultType::Full,
+                                        static_cast<bufsize>(schr - sdata),
+                                        nlen - 1};
+                ++schr;
+            }
+        }
+        if (!allowPartial) return SearchResult{};
+        schr = slast;
+    }
     SearchResultType mtype = SearchResultType::Full;
     byte header = ndata[0];
     ++ndata;
@@ -53,6 +235,7 @@ static bool tryFullMatchForward(bufsize alen, const byte* adata, bufsize blen,
                                 const byte* ndata, bufsize off) {
     bufsize lo = alen - off;
     if (nlen < lo) return memEqual(adata + off, ndata, nlen);
+    if (nlen - lo > blen) return false;
     return memEqual(adata + off, ndata, lo) &&
            memEqual(bdata, ndata + lo, nlen - lo);
 }
@@ -78,6 +261,27 @@ SearchResult searchPartialBackward(bufsize slen, const byte* sdata,
                                    bool allowPartial) {
     const byte* send = sdata + slen;
     const byte* schr = send;
+    if (nlen > 1 && slen >= nlen) {
+        if (nlen >= LONG_NEEDLE) {
+            bufsize k = searchLong(ByteView<true>{sdata, slen},
+                                   ByteView<true>{ndata, nlen});
+            if (k != NO_MATCH)
+                return SearchResult{SearchResultType::Full, slen - k - 1,
+                                    nlen - 1};
+        } else {
+            const byte* sp = send - nlen + 1;
+            bufsize i, j;
+            pickFilterPair(nlen, ndata, i, j);
+            while ((sp = memFindPairLast(sdata, sp, i, ndata[i], j, ndata[j])))
+                if (memEqual(sp, ndata, nlen))
+                    return SearchResult{
+                        SearchResultType::Full,
+                        static_cast<bufsize>(sp - sdata) + nlen - 1, nlen - 1};
+        }
+        if (!allowPartial) return SearchResult{};
+        // only matches hanging off the start remain
+        schr = sdata + nlen - 1;
+    }
     SearchResultType mtype = SearchResultType::Full;
     byte footer = ndata[--nlen];
     while ((schr = memFindLast(sdata, schr, footer))) {
@@ -99,6 +303,7 @@ static bool tryFullMatchBackward(bufsize alen, const byte* adata, bufsize blen,
                                  const byte* ndata, bufsize off) {
     if (off >= nlen) return memEqual(adata + off - nlen, ndata, nlen);
     bufsize lo = nlen - off;
+    if (lo > blen) return false;
     return memEqual(adata, ndata + lo, off) &&
            memEqual(bdata + blen - lo, ndata, lo);
 }
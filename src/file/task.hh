@@ -37,6 +37,10 @@ namespace hexbed {
 
 class HexBedTaskHandler;
 
+// run() calls fn on another thread while the UI thread waits for it, still
+// dispatching events. documents may only be read from other threads inside
+// a task, and nothing that runs from the event loop may touch a document
+// while HexBedTaskHandler::busy() says a task is running
 class HexBedTask {
   public:
     // use size=0 for indeterminate length
@@ -74,6 +78,8 @@ class HexBedTaskHandler {
     virtual void onTaskWait(HexBedTask* task) = 0;
     // called from subthread
     virtual void onTaskEnd(HexBedTask* task) = 0;
+    // called on main thread
+    virtual bool busy() const noexcept = 0;
 
     virtual inline ~HexBedTaskHandler() {}
 };
@@ -0,0 +1,124 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/textsearch.cc -- impl for searching text in many encodings
+
+#include "file/textsearch.hh"
+
+#include <algorithm>
+#include <map>
+
+#include "app/encoding.hh"
+#include "common/caseconv.hh"
+#include "file/cisearch.hh"
+
+namespace hexbed {
+
+// caseless forms of a text are spelled out as separate patterns, up to
+// this many per encoding. beyond that, only the text as typed and in
+// upper and lower case are searched for
+static constexpr std::size_t CASE_VARIANTS_MAXIMUM = 1024;
+
+using EncodedForms = std::vector<std::vector<byte>>;
+
+static bool encodeText(const CharacterEncoding& encoding,
+                       const std::u32string& text, std::vector<byte>& out) {
+    out.clear();
+    CharEncodeStatus status =
+        encoding.encode(charEncodeFromString(text), [&out](const_bytespan s) {
+            out.insert(out.end(), s.begin(), s.end());
+        });
+    return status.ok && status.readChars == text.size() && !out.empty();
+}
+
+// every combination of the encoded forms of each character
+static bool caselessForms(const CaseInsensitivePattern& pattern,
+                          EncodedForms& forms) {
+    std::vector<EncodedForms> units;
+    std::size_t product = 1;
+    for (const CaseInsensitivePattern::Unit& unit : pattern.units) {
+        EncodedForms alternatives;
+        for (unsigned b = 0; b < 256; ++b)
+            if (unit.single[b])
+                alternatives.push_back(std::vector<byte>{static_cast<byte>(b)});
+        alternatives.insert(alternatives.end(), unit.multi.begin(),
+                            unit.multi.end());
+        product *= alternatives.size();
+        if (product > CASE_VARIANTS_MAXIMUM) return false;
+        units.push_back(std::move(alternatives));
+    }
+    std::vector<std::size_t> pick(units.size(), 0);
+    for (std::size_t k = 0; k < product; ++k) {
+        std::vector<byte> form;
+        for (std::size_t i = 0; i < units.size(); ++i) {
+            const std::vector<byte>& part = units[i][pick[i]];
+            form.insert(form.end(), part.begin(), part.end());
+        }
+        forms.push_back(std::move(form));
+        for (std::size_t i = units.size(); i-- > 0;) {
+            if (++pick[i] < units[i].size()) break;
+            pick[i] = 0;
+        }
+    }
+    return true;
+}
+
+bool addEncodedText(MultiPattern& patterns, const std::u32string& text,
+                    const std::vector<TextSearchEncoding>& encodings,
+                    bool caseInsensitive) {
+    if (text.empty()) return false;
+    std::vector<std::u32string> texts{text};
+    if (caseInsensitive)
+        for (std::u32string t : {textCaseUpper(text), textCaseLower(text)})
+            if (std::find(texts.begin(), texts.end(), t) == texts.end())
+                texts.push_back(std::move(t));
+    // in the order they were first found, with the encodings that give them
+    std::map<std::vector<byte>, std::size_t> seen;
+    std::vector<std::pair<std::vector<byte>, std::string>> found;
+    std::vector<byte> buf;
+    for (const TextSearchEncoding& e : encodings) {
+        CharacterEncoding encoding = getCharacterEncodingByName(e.key);
+        EncodedForms forms;
+        if (caseInsensitive) {
+            CaseInsensitivePattern pattern(e.key, u32stringToWstring(text));
+            if (pattern.impossible) continue;
+            if (!caselessForms(pattern, forms)) forms.clear();
+        }
+        if (forms.empty())
+            for (const std::u32string& t : texts)
+                if (encodeText(encoding, t, buf)) forms.push_back(buf);
+        // an encoding gets named once, even if forms coincide in it
+        std::vector<std::size_t> named;
+        for (std::vector<byte>& form : forms) {
+            auto [it, added] = seen.emplace(form, found.size());
+            if (added) {
+                found.emplace_back(std::move(form), e.name);
+            } else if (std::find(named.begin(), named.end(), it->second) ==
+                       named.end()) {
+                found[it->second].second += ", " + e.name;
+            }
+            named.push_back(it->second);
+        }
+    }
+    for (const auto& [bytes, name] : found)
+        patterns.add(const_bytespan(bytes.data(), bytes.size()), name);
+    return !found.empty();
+}
+
+};  // namespace hexbed
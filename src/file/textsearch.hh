@@ -0,0 +1,49 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/textsearch.hh -- header for searching text in many encodings
+
+#ifndef HEXBED_FILE_TEXTSEARCH_HH
+#define HEXBED_FILE_TEXTSEARCH_HH
+
+#include <string>
+#include <vector>
+
+#include "common/types.hh"
+#include "file/multisearch.hh"
+
+namespace hexbed {
+
+// an encoding key, as for getCharacterEncodingByName, and the name that
+// its matches are labelled with
+struct TextSearchEncoding {
+    string key;
+    std::string name;
+};
+
+// adds the text as encoded in each of the encodings to patterns, named
+// after every encoding that gives the same bytes. returns false if the
+// text could not be encoded in any of them
+bool addEncodedText(MultiPattern& patterns, const std::u32string& text,
+                    const std::vector<TextSearchEncoding>& encodings,
+                    bool caseInsensitive);
+
+};  // namespace hexbed
+
+#endif /* HEXBED_FILE_TEXTSEARCH_HH */
@@ -551,7 +551,7 @@ TrebleNode* Treble::erase(TrebleNode* node) {
     // temporary pointer holder for removed node
     TrebleNodePointer owner;
 
-    if (node->length()) propagate(parent, node->length(), 0);
+    if (node->length()) propagate(node, node->length(), 0);
 
     TrebleNode* child = node->right();
     if (!child) {
@@ -598,7 +598,8 @@ TrebleNode* Treble::erase(TrebleNode* node) {
         succ->left()->parent(succ);
         succ->leftlen(node->leftlen());
         succ->balance(node->balance());
-        propagate(succ, node->length(), succ->length());
+        // undo the change to the ancestors of node from above
+        propagate(succ, 0, succ->length());
         balanceOnDelete(sp, 1);
         CHECK_TREBLE_BALANCE(sp);
         CHECK_TREBLE_BALANCE(succ);
@@ -702,8 +703,13 @@ void Treble::splitRight(TrebleNode* node, bufsize offset, bool adjust,
     if (!node->right()) {
         insertRight(node, std::move(newnode));
     } else {
+        // the split off part moves into the right subtree, so only the
+        // nodes between it and the original node gain length on the left
+        TrebleNode* orig = node;
         node = node->right()->minimum();
-        propagate(node, 0, newnode->length());
+        node->leftlenAdd(z);
+        propagate(node, 0, z);
+        propagate(orig, z, 0);
         newnode->parent(node);
         insertLeft(node, std::move(newnode));
     }
@@ -950,11 +956,13 @@ void Treble::reinsert(bufsize index, bufsize count, bufsize offset) {
         if (!node->data() && node->offset() + node->length() == offset) {
             // no propagate, cannot be the left child of any node
             node->lengthAdd(count);
-            return;
+        } else {
+            auto newnode = newTrebleNode(node, count);
+            newnode->offset(offset);
+            insertRight(node, std::move(newnode));
         }
-        auto newnode = newTrebleNode(node, count);
-        newnode->offset(offset);
-        insertRight(node, std::move(newnode));
+        total_ += count;
+        TREBLE_AFTER_OP();
         return;
     }
     bool zero = !index;
@@ -969,6 +977,12 @@ void Treble::reinsert(bufsize index, bufsize count, bufsize offset) {
         node->offset(offset);
         node->lengthAdd(count);
     } else {
+        if (res.suboffset == node->length()) {
+            // insert in front of the next node instead of splitting at the
+            // very end of this one, which would leave its data behind
+            node = node->successor();
+            res.suboffset = 0;
+        }
         if (res.suboffset) splitLeft(node, res.suboffset);
         if (node->length()) splitRight(node, 0, false, true);
         node->length(count);
@@ -1031,7 +1045,9 @@ void Treble::remove(bufsize index, bufsize count) {
             }
             break;
         } else {
-            node = tryMerge(erase(node));
+            // only merge once done, or the merged predecessor would get
+            // removed along with the rest of the node
+            node = erase(node);
             removed += z;
             count -= z;
             HEXBED_ASSERT(node || !count, "trying to remove beyond file!");
@@ -1040,6 +1056,8 @@ void Treble::remove(bufsize index, bufsize count) {
     }
     tryMerge(node);
     total_ -= removed;
+    // keep an empty node around if everything was removed
+    if (!root_) root_ = newTrebleNode(nullptr, 0);
     TREBLE_AFTER_OP();
 }
 
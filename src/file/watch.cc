@@ -0,0 +1,134 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/watch.cc -- impl for the file change watcher
+
+#include "file/watch.hh"
+
+#include <cerrno>
+
+#include "common/logger.hh"
+
+#if HEXBED_WATCH_INOTIFY
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cstdint>
+#endif
+
+namespace hexbed {
+
+FileWatcher::FileWatcher(const std::filesystem::path& filename,
+                         std::function<void()> changed)
+    : filename_(filename), changed_(std::move(changed)) {
+#if HEXBED_WATCH_INOTIFY
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ != -1 &&
+        inotify_add_watch(fd_, filename_.c_str(),
+                          IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE) == -1) {
+        LOG_WARN("inotify_add_watch failed (%d), falling back to polling",
+                 errno);
+        close(fd_);
+        fd_ = -1;
+    }
+    if (fd_ != -1 && changed_ &&
+        (wake_ = eventfd(0, EFD_CLOEXEC)) != -1) {
+        try {
+            thread_ = std::thread(&FileWatcher::listen, this);
+        } catch (...) {
+            close(wake_);
+            wake_ = -1;
+        }
+    }
+#endif
+    pollStat();
+}
+
+FileWatcher::~FileWatcher() noexcept {
+#if HEXBED_WATCH_INOTIFY
+    if (thread_.joinable()) {
+        std::uint64_t one = 1;
+        [[maybe_unused]] ssize_t w = write(wake_, &one, sizeof(one));
+        thread_.join();
+    }
+    if (wake_ != -1) close(wake_);
+    if (fd_ != -1) close(fd_);
+#endif
+}
+
+#if HEXBED_WATCH_INOTIFY
+// waits for inotify events until woken up by the destructor
+void FileWatcher::listen() {
+    pollfd fds[2] = {{fd_, POLLIN, 0}, {wake_, POLLIN, 0}};
+    alignas(inotify_event) char buf[4096];
+    for (;;) {
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            LOG_WARN("poll on inotify failed (%d)", errno);
+            return;
+        }
+        if (fds[1].revents) return;
+        bool changed = false;
+        while (read(fd_, buf, sizeof(buf)) > 0) changed = true;
+        if (changed) {
+            pending_.store(true);
+            changed_();
+        }
+    }
+}
+#endif
+
+bool FileWatcher::notifies() const noexcept {
+#if HEXBED_WATCH_INOTIFY
+    return thread_.joinable();
+#else
+    return false;
+#endif
+}
+
+bool FileWatcher::pollStat() {
+    std::error_code ec;
+    bufsize sz = std::filesystem::file_size(filename_, ec);
+    if (ec) return false;
+    auto tm = std::filesystem::last_write_time(filename_, ec);
+    if (ec) return false;
+    bool changed = sz != size_ || tm != time_;
+    size_ = sz;
+    time_ = tm;
+    return changed;
+}
+
+bool FileWatcher::poll() {
+#if HEXBED_WATCH_INOTIFY
+    if (thread_.joinable()) return pending_.exchange(false);
+    if (fd_ != -1) {
+        alignas(inotify_event) char buf[4096];
+        bool changed = false;
+        ssize_t r;
+        // drain every pending event; we only care whether there were any
+        while ((r = read(fd_, buf, sizeof(buf))) > 0) changed = true;
+        return changed;
+    }
+#endif
+    return pollStat();
+}
+
+};  // namespace hexbed
@@ -0,0 +1,77 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// file/watch.hh -- header for the file change watcher
+
+#ifndef HEXBED_FILE_WATCH_HH
+#define HEXBED_FILE_WATCH_HH
+
+#include <filesystem>
+#include <functional>
+
+#include "common/types.hh"
+
+#ifdef __linux__
+#define HEXBED_WATCH_INOTIFY 1
+#endif
+
+#if HEXBED_WATCH_INOTIFY
+#include <atomic>
+#include <thread>
+#endif
+
+namespace hexbed {
+
+class FileWatcher {
+  public:
+    // if the platform can report changes, changed is called from another
+    // thread whenever the file may have changed
+    FileWatcher(const std::filesystem::path& filename,
+                std::function<void()> changed = nullptr);
+    ~FileWatcher() noexcept;
+
+    FileWatcher(const FileWatcher& copy) = delete;
+    FileWatcher& operator=(const FileWatcher& copy) = delete;
+
+    // true if the file may have changed since the last call
+    bool poll();
+    // whether changes are reported through the callback, so that there is
+    // no need to keep polling
+    bool notifies() const noexcept;
+
+  private:
+    std::filesystem::path filename_;
+    std::function<void()> changed_;
+#if HEXBED_WATCH_INOTIFY
+    int fd_{-1};
+    int wake_{-1};
+    std::atomic<bool> pending_{false};
+    std::thread thread_;
+
+    void listen();
+#endif
+    bufsize size_{0};
+    std::filesystem::file_time_type time_{};
+
+    bool pollStat();
+};
+
+};  // namespace hexbed
+
+#endif /* HEXBED_FILE_WATCH_HH */
@@ -46,6 +46,10 @@ bool AppLock::acquire(const wxString& token) {
     return true;
 }
 
+void AppLock::acquireIfFree() {
+    if (!single_.IsAnotherRunning()) server_->Create(mutexName_);
+}
+
 void AppLock::release() {
     // wxSingleInstanceChecker self-destructs
     delete server_;
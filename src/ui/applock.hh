@@ -59,6 +59,8 @@ class AppLock {
     AppLock(std::function<void(const wxString&)>);
 
     bool acquire(const wxString& token);
+    // like acquire, but never hands anything over to another instance
+    void acquireIfFree();
     void release();
     void knock(const wxString& token);
 
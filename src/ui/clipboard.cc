@@ -35,20 +35,59 @@
 namespace hexbed {
 namespace clip {
 
+// copies larger than this are not rendered as text at all
+static constexpr bufsize CLIPBOARD_TEXT_MAX = 16 << 20;
+
+// what we last put on the clipboard. pasting it back in uses the slice,
+// which references the copied range instead of holding its bytes
+struct ClipboardCopy {
+    const HexBedDocument* document{nullptr};
+    HexBedSlice slice;
+    wxString text;
+    bool textMode;
+};
+
+// never destroyed, since the slice must not be released after the
+// document sources are gone at exit
+static ClipboardCopy& lastCopy = *new ClipboardCopy();
+
+// the slice keeps its sources open and the files behind them pinned, so
+// let go of it as soon as the clipboard holds something else. the
+// clipboard must be open
+static void checkLastCopy() {
+    if (lastCopy.slice.pieces.empty()) return;
+    wxTextDataObject data;
+    if (!wxTheClipboard->IsSupported(wxDF_TEXT) ||
+        !wxTheClipboard->GetData(data) || data.GetText() != lastCopy.text)
+        lastCopy = ClipboardCopy();
+}
+
 bool HasClipboard() {
     bool flag = false;
     if (wxTheClipboard->Open()) {
+        checkLastCopy();
         flag = wxTheClipboard->IsSupported(wxDF_TEXT);
         wxTheClipboard->Close();
     }
     return flag;
 }
 
+void ReleaseCopy(const HexBedDocument& document) {
+    if (lastCopy.document == &document) lastCopy = ClipboardCopy();
+}
+
 void CopyBytes(HexBedDocument& document, bufsize off, bufsize cnt, bool text) {
     if (!wxTheClipboard->Open()) throw ClipboardError();
     bufsize q = 0, qq;
     byte buf[BUFFER_SIZE];
-    if (text) {
+    lastCopy.document = &document;
+    lastCopy.slice = document.slice(off, cnt);
+    lastCopy.textMode = text;
+    if (cnt > CLIPBOARD_TEXT_MAX) {
+        lastCopy.text = wxString::Format(_("(%llu bytes from HexBed)"),
+                                         static_cast<unsigned long long>(cnt));
+        wxTheClipboard->SetData(new wxTextDataObject(lastCopy.text));
+    } else if (text) {
         std::u32string result;
         std::size_t sz = sizeof(buf);
         unsigned utf = config().utfMode;
@@ -63,8 +102,8 @@ void CopyBytes(HexBedDocument& document, bufsize off, bufsize cnt, bool text) {
             off += qq, cnt -= qq;
         }
 
-        wxTheClipboard->SetData(
-            new wxTextDataObject(u32stringToWstring(result)));
+        lastCopy.text = wxString(u32stringToWstring(result));
+        wxTheClipboard->SetData(new wxTextDataObject(lastCopy.text));
     } else {
         string result;
         bool cont = false;
@@ -78,7 +117,8 @@ void CopyBytes(HexBedDocument& document, bufsize off, bufsize cnt, bool text) {
             cont = true;
         }
 
-        wxTheClipboard->SetData(new wxTextDataObject(result));
+        lastCopy.text = wxString(result);
+        wxTheClipboard->SetData(new wxTextDataObject(lastCopy.text));
     }
     wxTheClipboard->Close();
 }
@@ -87,6 +127,7 @@ bool PasteBytes(HexBedDocument& document, bool insert, bufsize off, bufsize cnt,
                 bool text, bufsize& len) {
     bool flag = true;
     if (!wxTheClipboard->Open()) throw ClipboardError();
+    checkLastCopy();
     if (!wxTheClipboard->IsSupported(wxDF_TEXT)) {
         wxMessageBox(_("Cannot paste the current clipboard contents, "
                        "because it does not contain text data."),
@@ -97,6 +138,21 @@ bool PasteBytes(HexBedDocument& document, bool insert, bufsize off, bufsize cnt,
         wxTheClipboard->GetData(data);
         std::vector<byte> bytes;
 
+        if (!lastCopy.slice.pieces.empty() &&
+            data.GetText() == lastCopy.text &&
+            (lastCopy.textMode == text ||
+             lastCopy.slice.size() > CLIPBOARD_TEXT_MAX)) {
+            // our own copy, paste the referenced bytes directly
+            const HexBedSlice& slice = lastCopy.slice;
+            len = slice.size();
+            if (insert)
+                document.replace(off, cnt, slice);
+            else
+                document.replace(off, std::min(len, document.size() - off),
+                                 slice);
+            goto finish;
+        }
+
         if (text) {
             if (off % hexbed::ui::configUtfGroupSize()) {
                 wxMessageBox(_("Cannot paste Unicode text out of alignment."),
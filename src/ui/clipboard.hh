@@ -40,6 +40,8 @@ bool HasClipboard();
 void CopyBytes(HexBedDocument& document, bufsize off, bufsize cnt, bool text);
 bool PasteBytes(HexBedDocument& document, bool insert, bufsize off, bufsize cnt,
                 bool text, bufsize& len);
+// forgets the last copy if it was made from this document
+void ReleaseCopy(const HexBedDocument& document);
 
 };  // namespace clip
 };  // namespace hexbed
@@ -70,6 +70,8 @@ void HexBedViewer::onUpdateCursor(HexBedPeekRegion peek) {
     LOG_DEBUG("pure virtual onUpdateCursor");
 }
 
+void HexBedViewer::onBytesChanged(HexBedDocument* document, bufsize start) {}
+
 class HexBedTaskHandlerMain : public HexBedTaskHandler, wxEvtHandler {
   public:
     // called on main thread
@@ -139,6 +141,9 @@ class HexBedTaskHandlerMain : public HexBedTaskHandler, wxEvtHandler {
         }
     }
 
+    // called on main thread
+    bool busy() const noexcept { return task_ != nullptr; }
+
     HexBedTaskHandlerMain(hexbed::ui::HexBedMainFrame* main)
         : main_(main), timer_(this) {
         Bind(wxEVT_TIMER, &HexBedTaskHandlerMain::OnTimeOut, this);
@@ -161,6 +166,8 @@ HexBedContextMain::HexBedContextMain(hexbed::ui::HexBedMainFrame* main)
 
 HexBedTaskHandler* HexBedContextMain::getTaskHandler() { return task_.get(); }
 
+bool HexBedContextMain::taskRunning() const noexcept { return task_->busy(); }
+
 bool HexBedContextMain::shouldBackup() { return config().backupFiles; }
 
 FailureResponse HexBedContextMain::ifBackupFails(const string& message) {
@@ -194,8 +201,27 @@ static HexBedPeekRegion makePeekBuffer(HexBedDocument* doc, bufsize start,
             : const_bytespan{}};
 }
 
+MatchIndex* HexBedContextMain::findMatchIndex(HexBedDocument* doc) {
+    auto it = meta_.find(doc);
+    return it != meta_.end() ? it->second.matchIndex.get() : nullptr;
+}
+
 void HexBedContextMain::announceBytesChanged(HexBedDocument* doc,
                                              bufsize start) {
+    if (MatchIndex* index = findMatchIndex(doc)) index->update(start);
+    hintBytesChanged(doc, start);
+}
+
+void HexBedContextMain::announceBytesResized(HexBedDocument* doc,
+                                             bufsize start, bufsize oldLength,
+                                             bufsize newLength) {
+    if (MatchIndex* index = findMatchIndex(doc))
+        index->update(start, oldLength, newLength);
+    hintBytesChanged(doc, start);
+}
+
+void HexBedContextMain::hintBytesChanged(HexBedDocument* doc, bufsize start) {
+    for (HexBedViewer* viewer : viewers_) viewer->onBytesChanged(doc, start);
     auto it = open_.find(doc);
     if (it != open_.end())
         for (hexbed::ui::HexEditorParent* editor : it->second.views)
@@ -214,6 +240,10 @@ void HexBedContextMain::announceBytesChanged(HexBedDocument* doc,
 void HexBedContextMain::announceBytesChanged(HexBedDocument* doc, bufsize start,
                                              bufsize length) {
     if (!length) return;
+    // the old length is cut short if the write grew the document
+    if (MatchIndex* index = findMatchIndex(doc))
+        index->update(start, length, length);
+    for (HexBedViewer* viewer : viewers_) viewer->onBytesChanged(doc, start);
     auto it = open_.find(doc);
     if (it != open_.end()) {
         if (length == 1) {
@@ -330,6 +360,33 @@ const_bytespan HexBedContextMain::getReplaceString() const noexcept {
 
 static DocumentMetadata illegalMetadata_;
 
+MatchIndex* HexBedContextMain::getMatchIndex(HexBedDocument* doc,
+                                             const_bytespan pattern) {
+    auto it = meta_.find(doc);
+    if (it == meta_.end() || pattern.empty()) return nullptr;
+    std::unique_ptr<MatchIndex>& index = it->second.matchIndex;
+    if (!index || (!index->matches(pattern) && !index->extend(pattern)))
+        index = std::make_unique<MatchIndex>(*doc, pattern);
+    if (!index->current()) main_->RefreshMatchIndexesLater();
+    return index->usable() ? index.get() : nullptr;
+}
+
+bool HexBedContextMain::refreshMatchIndexes(HexBedTask& task) {
+    for (auto& entry : meta_) {
+        std::unique_ptr<MatchIndex>& index = entry.second.matchIndex;
+        if (!index || !index->usable() || index->current()) continue;
+        try {
+            if (index->refreshSlice(task)) return true;
+        } catch (...) {
+            // searches do without the index if it cannot be read
+            LOG_WARN("could not refresh match index: %s",
+                     currentExceptionAsString().c_str());
+            index.reset();
+        }
+    }
+    return false;
+}
+
 DocumentMetadata& HexBedContextMain::getMetadata(HexBedDocument* doc) {
     auto it = meta_.find(doc);
     if (it == meta_.end()) {
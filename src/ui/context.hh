@@ -34,6 +34,10 @@
 #include "file/cisearch.hh"
 #include "file/context.hh"
 #include "file/document-fwd.hh"
+#include "file/fillscan.hh"
+#include "file/masksearch.hh"
+#include "file/matchindex.hh"
+#include "file/regex.hh"
 #include "file/task.hh"
 #include "ui/editor-fwd.hh"
 #include "ui/hexbed-fwd.hh"
@@ -47,6 +51,9 @@ struct EditorState {
     bool searchWrapAround{false};
     bool searchFindText{false};
     bool searchFindTextCaseInsensitive{false};
+    bool searchFindMasked{false};
+    bool searchFindRegex{false};
+    bool searchReplaceText{false};
 
     wxString searchFindTextString;
     wxString searchReplaceTextString;
@@ -58,7 +65,15 @@ struct EditorState {
     std::size_t searchFindDataType;
     std::size_t searchReplaceDataType;
 
+    wxString searchFindPatternString;
+    wxString searchFindRegexString;
+
     CaseInsensitivePattern searchCaseInsensitive;
+    MaskedPattern searchMasked;
+    std::shared_ptr<ByteRegex> searchRegex;
+
+    std::shared_ptr<const FillPattern> skipFill;
+    bufsize skipFillMinimum{16};
 };
 
 class HexBedContextMain;
@@ -79,6 +94,8 @@ class HexBedViewer {
     /* peek may become invalid! you must copy the data if you need it
        after onUpdateCursor ends */
     virtual void onUpdateCursor(HexBedPeekRegion peek);
+    // called after the contents of any document change from start onwards
+    virtual void onBytesChanged(HexBedDocument* document, bufsize start);
 
   private:
     bufsize lookahead_;
@@ -130,6 +147,9 @@ class DocumentMetadata {
     std::optional<bufsize> nextBookmark(bufsize pos);
     std::optional<bufsize> previousBookmark(bufsize pos);
 
+    // of the last plain search done in the document
+    std::unique_ptr<MatchIndex> matchIndex;
+
   private:
     std::array<bool, BOOKMARK_COUNT> bookmarkSet_;
     std::array<bufsize, BOOKMARK_COUNT> bookmarkAt_;
@@ -144,6 +164,8 @@ class HexBedContextMain : public HexBedContext {
   public:
     HexBedContextMain(hexbed::ui::HexBedMainFrame* main_);
     HexBedTaskHandler* getTaskHandler();
+    // documents must be left alone while this is true; see HexBedTask
+    bool taskRunning() const noexcept;
 
     bool shouldBackup();
     FailureResponse ifBackupFails(const string& message);
@@ -151,10 +173,17 @@ class HexBedContextMain : public HexBedContext {
     void announceBytesChanged(HexBedDocument* doc, bufsize start);
     void announceBytesChanged(HexBedDocument* doc, bufsize start,
                               bufsize length);
+    void announceBytesResized(HexBedDocument* doc, bufsize start,
+                              bufsize oldLength, bufsize newLength);
     void announceUndoChanged(HexBedDocument* doc);
     void announceCursorUpdate(HexBedPeekRegion peek);
 
     DocumentMetadata& getMetadata(HexBedDocument* doc);
+    // null if the document has too many matches to index. an index that is
+    // not up to date gets refreshed in the background
+    MatchIndex* getMatchIndex(HexBedDocument* doc, const_bytespan pattern);
+    // refreshes a slice of a match index. false once all are up to date
+    bool refreshMatchIndexes(HexBedTask& task);
 
     hexbed::ui::HexEditorParent* activeWindow() noexcept;
     void addWindow(hexbed::ui::HexEditorParent* editor, bool subview = false);
@@ -183,6 +212,9 @@ class HexBedContextMain : public HexBedContext {
     std::vector<HexBedViewer*> viewers_;
     HexBedDocument* lastdoc_{nullptr};
     bufsize lastoff_{0};
+
+    MatchIndex* findMatchIndex(HexBedDocument* doc);
+    void hintBytesChanged(HexBedDocument* doc, bufsize start);
 };
 
 }  // namespace hexbed
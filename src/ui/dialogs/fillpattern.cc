@@ -0,0 +1,119 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// ui/dialogs/fillpattern.cc -- impl for the Fill Pattern dialog
+
+#include "ui/dialogs/fillpattern.hh"
+
+#include <wx/msgdlg.h>
+#include <wx/sizer.h>
+#include <wx/stattext.h>
+
+#include <climits>
+
+#include "common/hexconv.hh"
+#include "ui/hexbed.hh"
+#include "ui/string.hh"
+
+namespace hexbed {
+
+namespace ui {
+
+FillPatternDialog::FillPatternDialog(HexBedMainFrame* parent,
+                                     const string& initial, bufsize minimum)
+    : wxDialog(parent, wxID_ANY, _("Fill pattern"), wxDefaultPosition,
+               wxSize(300, 200), wxDEFAULT_DIALOG_STYLE) {
+    SetReturnCode(wxID_CANCEL);
+
+    wxBoxSizer* top = new wxBoxSizer(wxVERTICAL);
+    wxStdDialogButtonSizer* buttons = new wxStdDialogButtonSizer();
+
+    okButton_ = new wxButton(this, wxID_OK);
+    okButton_->Bind(wxEVT_BUTTON, &FillPatternDialog::OnOK, this);
+
+    wxButton* cancelButton = new wxButton(this, wxID_CANCEL);
+    cancelButton->Bind(wxEVT_BUTTON, &FillPatternDialog::OnCancel, this);
+
+    buttons->SetAffirmativeButton(okButton_);
+    buttons->SetNegativeButton(cancelButton);
+    buttons->Realize();
+
+    fillInput_ = new wxTextCtrl(this, wxID_ANY, initial);
+    minimumSpinner_ = new wxSpinCtrl(
+        this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
+        wxSP_ARROW_KEYS, 1, INT_MAX,
+        static_cast<int>(std::min<bufsize>(minimum, INT_MAX)));
+
+    top->Add(new wxStaticText(
+        this, wxID_ANY,
+        wxString::Format(_("Fill bytes (hex, up to %llu bytes):"),
+                         static_cast<unsigned long long>(
+                             FillPattern::MAXIMUM_LENGTH))));
+    top->Add(fillInput_, wxSizerFlags().Expand());
+    top->Add(new wxStaticText(this, wxID_ANY,
+                              _("Shortest run of fill counted as padding:")));
+    top->Add(minimumSpinner_, wxSizerFlags().Expand());
+    top->Add(buttons, wxSizerFlags().Expand());
+
+    SetSizer(top);
+    Fit();
+    Layout();
+}
+
+std::shared_ptr<const FillPattern> FillPatternDialog::GetPattern()
+    const noexcept {
+    return pattern_;
+}
+
+bufsize FillPatternDialog::GetMinimum() const noexcept {
+    return static_cast<bufsize>(minimumSpinner_->GetValue());
+}
+
+bool FillPatternDialog::MakePattern() {
+    byte buf[FillPattern::MAXIMUM_LENGTH + 1];
+    bufsize n = sizeof(buf);
+    if (!hexToBytes(n, buf, stringFromWx(fillInput_->GetValue())) || !n ||
+        n > FillPattern::MAXIMUM_LENGTH) {
+        wxMessageBox(
+            wxString::Format(_("Enter between one and %llu bytes of hex."),
+                             static_cast<unsigned long long>(
+                                 FillPattern::MAXIMUM_LENGTH)),
+            "HexBed", wxOK | wxICON_ERROR);
+        return false;
+    }
+    pattern_ = std::make_shared<const FillPattern>(const_bytespan(buf, n));
+    return true;
+}
+
+void FillPatternDialog::EndDialog(int r) {
+    SetReturnCode(r);
+    if (IsModal()) EndModal(r);
+}
+
+void FillPatternDialog::OnOK(wxCommandEvent& event) {
+    if (MakePattern()) EndDialog(wxID_OK);
+}
+
+void FillPatternDialog::OnCancel(wxCommandEvent& event) {
+    EndDialog(wxID_CANCEL);
+}
+
+};  // namespace ui
+
+};  // namespace hexbed
@@ -27,8 +27,13 @@
 #include <wx/valgen.h>
 
 #include "app/config.hh"
+#include "common/hexconv.hh"
+#include "common/logger.hh"
 #include "file/cisearch.hh"
+#include "file/masksearch.hh"
+#include "file/regex.hh"
 #include "ui/hexbed.hh"
+#include "ui/string.hh"
 
 namespace hexbed {
 
@@ -38,7 +43,7 @@ wxDEFINE_EVENT(FIND_DOCUMENT_EDIT_EVENT, wxCommandEvent);
 
 FindDocumentControl::FindDocumentControl(
     wxWindow* parent, std::shared_ptr<HexBedContextMain> context,
-    std::shared_ptr<HexBedDocument> document, bool isFind)
+    std::shared_ptr<HexBedDocument> document, bool isFind, bool allowPattern)
     : wxPanel(parent), context_(context), document_(document) {
     wxBoxSizer* top = new wxBoxSizer(wxVERTICAL);
     notebook_ = new wxNotebook(this, wxID_ANY);
@@ -61,6 +66,23 @@ FindDocumentControl::FindDocumentControl(
     notebook_->AddPage(editor_, _("Hex data"), true);
     notebook_->AddPage(textInput_, _("Text"), false);
     notebook_->AddPage(valueInput_, _("Data value"), false);
+    if (allowPattern) {
+        patternInput_ =
+            new wxTextCtrl(notebook_, wxID_ANY,
+                           context->state.searchFindPatternString);
+        patternInput_->SetHint(_("e.g. 4D 5A ?? ?? 5? 45"));
+        patternInput_->Bind(wxEVT_TEXT, &FindDocumentControl::ForwardEvent,
+                            this);
+        notebook_->AddPage(patternInput_, _("Hex pattern"), false);
+    }
+    if (isFind) {
+        regexInput_ = new wxTextCtrl(notebook_, wxID_ANY,
+                                     context->state.searchFindRegexString);
+        regexInput_->SetHint(_("e.g. PK\\x03\\x04.{26}[^\\0]+"));
+        regexInput_->Bind(wxEVT_TEXT, &FindDocumentControl::ForwardEvent,
+                          this);
+        notebook_->AddPage(regexInput_, _("Regular expression"), false);
+    }
     notebook_->Bind(wxEVT_NOTEBOOK_PAGE_CHANGED,
                     &FindDocumentControl::ForwardBookEvent, this);
     editor_->Bind(HEX_EDIT_EVENT, &FindDocumentControl::ForwardEvent, this);
@@ -79,6 +101,34 @@ bool FindDocumentControl::DoValidate() {
         return textInput_->Commit(document_.get());
     case 2:
         return valueInput_->Commit(document_.get());
+    default:
+        if (IsFindingMasked()) {
+            std::vector<byte> value, mask;
+            wxString text = patternInput_->GetValue();
+            if (!hexToMaskedBytes(value, mask, stringFromWx(text)) ||
+                value.empty()) {
+                wxMessageBox(_("The entered hex pattern is not valid. Use ? "
+                               "for a nibble that may have any value."),
+                             "HexBed", wxOK | wxICON_ERROR);
+                return false;
+            }
+            context_->state.searchFindPatternString = text;
+            context_->state.searchMasked =
+                MaskedPattern(std::move(value), std::move(mask));
+        } else if (IsFindingRegex()) {
+            wxString text = regexInput_->GetValue();
+            try {
+                context_->state.searchRegex = std::make_shared<ByteRegex>(
+                    std::string(text.ToUTF8().data()));
+            } catch (...) {
+                wxMessageBox(
+                    wxString::Format(_("Invalid regular expression: %s"),
+                                     currentExceptionAsString()),
+                    "HexBed", wxOK | wxICON_ERROR);
+                return false;
+            }
+            context_->state.searchFindRegexString = text;
+        }
     }
     return true;
 }
@@ -91,14 +141,33 @@ bool FindDocumentControl::NonEmpty() const noexcept {
         return textInput_->NonEmpty();
     case 2:
         return valueInput_->NonEmpty();
+    default:
+        if (IsFindingMasked()) return !patternInput_->IsEmpty();
+        if (IsFindingRegex()) return !regexInput_->IsEmpty();
     }
     return false;
 }
 
+bool FindDocumentControl::IsFindingData() const noexcept {
+    return notebook_->GetSelection() == 0;
+}
+
 bool FindDocumentControl::IsFindingText() const noexcept {
     return notebook_->GetSelection() == 1;
 }
 
+bool FindDocumentControl::IsFindingMasked() const noexcept {
+    return patternInput_ && notebook_->GetCurrentPage() == patternInput_;
+}
+
+bool FindDocumentControl::IsFindingRegex() const noexcept {
+    return regexInput_ && notebook_->GetCurrentPage() == regexInput_;
+}
+
+bool FindDocumentControl::IsTypingByte() const noexcept {
+    return IsFindingData() && editor_->IsTypingByte();
+}
+
 void FindDocumentControl::ForwardEvent(wxCommandEvent& event) {
     AddPendingEvent(wxCommandEvent(FIND_DOCUMENT_EDIT_EVENT));
 }
@@ -136,20 +205,25 @@ FindDialog::FindDialog(HexBedMainFrame* parent,
     findPrevButton_ = new wxButton(this, wxID_ANY, _("Find &previous"));
     findPrevButton_->Bind(wxEVT_BUTTON, &FindDialog::OnFindPrevious, this);
 
+    findAllButton_ = new wxButton(this, wxID_ANY, _("Find &all"));
+    findAllButton_->Bind(wxEVT_BUTTON, &FindDialog::OnFindAll, this);
+
     wxButton* cancelButton = new wxButton(this, wxID_CANCEL);
     cancelButton->Bind(wxEVT_BUTTON, &FindDialog::OnCancel, this);
 
+    buttons->Add(findAllButton_);
     buttons->Add(1, 1, wxSizerFlags().Expand().Proportion(1));
     buttons->Add(findPrevButton_);
     buttons->Add(findNextButton_);
     buttons->Add(cancelButton);
 
-    control_ = new FindDocumentControl(this, context, document, true);
+    control_ = new FindDocumentControl(this, context, document, true, true);
     control_->Bind(FIND_DOCUMENT_EDIT_EVENT, &FindDialog::OnChangedInput, this);
 
     bool flag = CheckInput();
     findNextButton_->Enable(flag);
     findPrevButton_->Enable(flag);
+    findAllButton_->Enable(flag);
 
     top->Add(new wxStaticText(this, wxID_ANY, _("Find data")),
              wxSizerFlags().Expand());
@@ -159,6 +233,8 @@ FindDialog::FindDialog(HexBedMainFrame* parent,
                        wxDefaultSize, 0,
                        wxGenericValidator(&context->state.searchWrapAround)),
         wxSizerFlags().Expand());
+    incremental_ = new wxCheckBox(this, wxID_ANY, _("Search as you &type"));
+    top->Add(incremental_, wxSizerFlags().Expand());
     top->Add(buttons, wxSizerFlags().Expand());
 
     SetSizer(top);
@@ -169,6 +245,8 @@ FindDialog::FindDialog(HexBedMainFrame* parent,
 bool FindDialog::Recommit() {
     if (!control_->DoValidate()) return false;
     context_->state.searchFindText = control_->IsFindingText();
+    context_->state.searchFindMasked = control_->IsFindingMasked();
+    context_->state.searchFindRegex = control_->IsFindingRegex();
     if (dirty_) {
         dirty_ = false;
         bufsize n = document_->size();
@@ -199,6 +277,11 @@ void FindDialog::OnFindPrevious(wxCommandEvent& event) {
     parent_->DoFindPrevious();
 }
 
+void FindDialog::OnFindAll(wxCommandEvent& event) {
+    if (!Recommit()) return;
+    parent_->DoFindAll();
+}
+
 void FindDialog::OnCancel(wxCommandEvent& event) { Close(); }
 
 void FindDialog::OnChangedInput(wxCommandEvent& event) {
@@ -206,6 +289,10 @@ void FindDialog::OnChangedInput(wxCommandEvent& event) {
     dirty_ = true;
     findNextButton_->Enable(flag);
     findPrevButton_->Enable(flag);
+    if (findAllButton_) findAllButton_->Enable(flag);
+    if (flag && incremental_ && incremental_->GetValue() &&
+        control_->IsFindingData() && Recommit())
+        parent_->DoFindIncremental(control_->IsTypingByte());
 }
 
 static SearchResult findNextCaseInsensitive(HexBedTask& task,
@@ -214,9 +301,11 @@ static SearchResult findNextCaseInsensitive(HexBedTask& task,
                                             bufsize dn, bufsize sel,
                                             bool wrapAround) {
     CaseInsensitivePattern& pattern = context.state.searchCaseInsensitive;
+    bufsize z = std::max<bufsize>(pattern.maxLength, 1);
     SearchResult res = searchForwardCaseless(task, document, sel, dn, pattern);
     if (!task.isCancelled() && !res && wrapAround)
-        res = searchForwardCaseless(task, document, 0, sel, pattern);
+        res = searchForwardCaseless(task, document, 0,
+                                    std::min(dn, sel + z - 1), pattern);
     return res;
 }
 
@@ -225,20 +314,79 @@ static SearchResult findPrevCaseInsensitive(HexBedTask& task,
                                             HexBedContextMain& context,
                                             bufsize dn, bufsize sel,
                                             bool wrapAround) {
-    SearchResult res;
-    bufsize osel = sel;
     CaseInsensitivePattern& pattern = context.state.searchCaseInsensitive;
-    for (;;) {
-        res = searchBackwardCaseless(task, document, 0, sel, pattern);
-        if (task.isCancelled() || !res || res.offset + res.length <= osel)
-            break;
-        sel = res.offset;
-    }
+    bufsize z = std::max<bufsize>(pattern.maxLength, 1);
+    SearchResult res = searchBackwardCaseless(task, document, 0, sel, pattern);
+    if (!task.isCancelled() && !res && wrapAround)
+        res = searchBackwardCaseless(task, document,
+                                     sel >= z ? sel - z + 1 : 0, dn, pattern);
+    return res;
+}
+
+// a match may not end past cur + z - 1 when wrapping forward, or start
+// before cur - z + 1 when wrapping backward, or it would have been found
+// on the first pass already
+static SearchResult findNextMasked(HexBedTask& task,
+                                   const HexBedDocument& document,
+                                   HexBedContextMain& context, bufsize dn,
+                                   bufsize cur, bool wrapAround) {
+    const MaskedPattern& pattern = context.state.searchMasked;
+    bufsize z = pattern.size();
+    SearchResult res = searchForwardMasked(task, document, cur, dn, pattern);
+    if (!task.isCancelled() && !res && wrapAround)
+        res = searchForwardMasked(task, document, 0,
+                                  std::min(dn, cur + z - 1), pattern);
+    return res;
+}
+
+static SearchResult findPrevMasked(HexBedTask& task,
+                                   const HexBedDocument& document,
+                                   HexBedContextMain& context, bufsize dn,
+                                   bufsize cur, bool wrapAround) {
+    const MaskedPattern& pattern = context.state.searchMasked;
+    bufsize z = pattern.size();
+    SearchResult res = searchBackwardMasked(task, document, 0, cur, pattern);
+    if (!task.isCancelled() && !res && wrapAround)
+        res = searchBackwardMasked(task, document, cur >= z ? cur - z + 1 : 0,
+                                   dn, pattern);
+    return res;
+}
+
+static SearchResult findNextRegex(HexBedTask& task,
+                                  const HexBedDocument& document,
+                                  HexBedContextMain& context, bufsize dn,
+                                  bufsize cur, bool wrapAround) {
+    ByteRegex& regex = *context.state.searchRegex;
+    SearchResult res = regex.searchForward(task, document, cur, dn);
+    if (!task.isCancelled() && !res && wrapAround)
+        res = regex.searchForward(task, document, 0, dn);
+    return res;
+}
+
+static SearchResult findPrevRegex(HexBedTask& task,
+                                  const HexBedDocument& document,
+                                  HexBedContextMain& context, bufsize dn,
+                                  bufsize cur, bool wrapAround) {
+    ByteRegex& regex = *context.state.searchRegex;
+    SearchResult res = regex.searchBackward(task, document, 0, cur);
     if (!task.isCancelled() && !res && wrapAround)
-        res = searchBackwardCaseless(task, document, sel + 1, dn, pattern);
+        res = regex.searchBackward(task, document, 0, dn);
     return res;
 }
 
+// plain searches go through the match index of the document once it is up
+// to date. until then, the index is refreshed in the background and the
+// search goes through the document
+static MatchIndex* getIndexFor(HexBedContextMain& context,
+                               HexBedDocument& document,
+                               const_bytespan search) {
+    const EditorState& state = context.state;
+    if (state.searchFindRegex || state.searchFindMasked ||
+        (state.searchFindText && state.searchFindTextCaseInsensitive))
+        return nullptr;
+    return context.getMatchIndex(&document, search);
+}
+
 SearchResult FindDialog::findNext(HexEditorParent* ed) {
     HexBedContextMain& context = ed->context();
     bufsize sel, seln;
@@ -246,17 +394,29 @@ SearchResult FindDialog::findNext(HexEditorParent* ed) {
     ed->GetSelection(sel, seln, seltext);
     bufsize cur = sel + seln;
     const_bytespan search = context.getSearchString();
-    bufsize dn = search.size();
+    bufsize dn = context.state.searchFindMasked
+                     ? context.state.searchMasked.size()
+                     : search.size();
     SearchResult res{};
-    if (dn) {
+    if (dn || context.state.searchFindRegex) {
         HexBedDocument& doc = ed->document();
         bufsize sn = doc.size();
+        MatchIndex* index = getIndexFor(context, doc, search);
         HexBedTask task(&context, 0, true);
-        task.run([&res, &context, &doc, sn, dn, cur, search](HexBedTask& task) {
-            if (context.state.searchFindText &&
-                context.state.searchFindTextCaseInsensitive)
+        task.run([&res, &context, &doc, index, sn, dn, cur,
+                  search](HexBedTask& task) {
+            if (context.state.searchFindRegex)
+                res = findNextRegex(task, doc, context, sn, cur,
+                                    context.state.searchWrapAround);
+            else if (context.state.searchFindMasked)
+                res = findNextMasked(task, doc, context, sn, cur,
+                                     context.state.searchWrapAround);
+            else if (context.state.searchFindText &&
+                     context.state.searchFindTextCaseInsensitive)
                 res = findNextCaseInsensitive(task, doc, context, sn, cur,
                                               context.state.searchWrapAround);
+            else if (index && index->current())
+                res = index->next(cur, context.state.searchWrapAround);
             else if (sn - cur >= dn)
                 res = doc.searchForwardFull(
                     task, cur, context.state.searchWrapAround, search);
@@ -271,6 +431,107 @@ SearchResult FindDialog::findNext(HexEditorParent* ed) {
     return res;
 }
 
+// how far an incremental search looks from the selection before it goes
+// on through the rest of the document in the background
+static constexpr bufsize INCREMENTAL_REACH = bufsize(1) << 22;
+// how much the background part of an incremental search reads at once
+static constexpr bufsize INCREMENTAL_SLICE = bufsize(1) << 20;
+
+static MatchIndex* getIncrementalIndex(HexBedContextMain& context,
+                                       HexBedDocument& document,
+                                       const_bytespan search,
+                                       const IncrementalSearch& state) {
+    // a half-typed byte would replace the index for the whole bytes before
+    // it, which the next digit can otherwise refine
+    return state.partial ? nullptr : getIndexFor(context, document, search);
+}
+
+// looks from the start of the selection, so that the match being typed
+// stays selected for as long as it still matches. if there is no match
+// close by, returns nothing and leaves the search pending
+SearchResult FindDialog::findIncremental(HexEditorParent* ed,
+                                         IncrementalSearch& state) {
+    HexBedContextMain& context = ed->context();
+    bufsize sel, seln;
+    bool seltext;
+    ed->GetSelection(sel, seln, seltext);
+    const_bytespan search = context.getSearchString();
+    SearchResult res{};
+    state.pending = false;
+    if (!search.empty()) {
+        HexBedDocument& doc = ed->document();
+        bufsize sn = doc.size();
+        // a longer needle only refines the matches of the previous one,
+        // which happens in the background
+        MatchIndex* index = getIncrementalIndex(context, doc, search, state);
+        if (index && index->current()) {
+            res = index->next(sel, true);
+        } else {
+            // the match is usually close by, so look near the selection
+            // first without bringing up a progress dialog
+            HexBedTask near(&context, 0, false);
+            bufoffset reach =
+                sn - sel > INCREMENTAL_REACH ? sel + INCREMENTAL_REACH : sn;
+            res = doc.searchForward(near, sel, reach, search);
+            if (!res && (sel || reach < sn)) {
+                state.pending = true;
+                state.document = &doc;
+                state.start = sel;
+                state.wrapped = reach == sn;
+                // matches across the end of the reach are not found yet
+                bufsize back =
+                    std::min<bufsize>(reach - sel, search.size() - 1);
+                state.next = state.wrapped ? 0 : reach - back;
+            }
+        }
+        if (res)
+            ed->SelectBytes(res.offset, res.length,
+                            SelectFlags().caretAtEnd().highlightBeginning());
+    }
+    return res;
+}
+
+// carries on with a pending incremental search for one slice, or answers
+// it from the match index once that is up to date
+SearchResult FindDialog::findIncrementalSlice(HexEditorParent* ed,
+                                              HexBedTask& task,
+                                              IncrementalSearch& state) {
+    HexBedContextMain& context = ed->context();
+    const_bytespan search = context.getSearchString();
+    HexBedDocument& doc = ed->document();
+    SearchResult res{};
+    if (!state.pending || search.empty() || &doc != state.document) {
+        state.pending = false;
+        return res;
+    }
+    bufsize sn = doc.size(), dn = search.size();
+    MatchIndex* index = getIncrementalIndex(context, doc, search, state);
+    if (index && index->current()) {
+        state.pending = false;
+        res = index->next(state.start, true);
+    } else {
+        // after wrapping around, only matches that start before the
+        // selection are left
+        bufoffset limit =
+            state.wrapped ? std::min(sn, state.start + dn - 1) : sn;
+        bufoffset end = limit;
+        if (state.next < limit && limit - state.next > INCREMENTAL_SLICE + dn)
+            end = state.next + INCREMENTAL_SLICE + dn - 1;
+        if (state.next < end)
+            res = doc.searchForward(task, state.next, end, search);
+        if (res || (state.wrapped && end == limit))
+            state.pending = false;
+        else if (end < limit)
+            state.next = end - dn + 1;
+        else
+            state.wrapped = true, state.next = 0;
+    }
+    if (res)
+        ed->SelectBytes(res.offset, res.length,
+                        SelectFlags().caretAtEnd().highlightBeginning());
+    return res;
+}
+
 SearchResult FindDialog::findPrevious(HexEditorParent* ed) {
     HexBedContextMain& context = ed->context();
     bufsize sel, seln;
@@ -278,17 +539,29 @@ SearchResult FindDialog::findPrevious(HexEditorParent* ed) {
     ed->GetSelection(sel, seln, seltext);
     bufsize cur = sel;
     const_bytespan search = context.getSearchString();
-    bufsize dn = search.size();
+    bufsize dn = context.state.searchFindMasked
+                     ? context.state.searchMasked.size()
+                     : search.size();
     SearchResult res{};
-    if (dn) {
+    if (dn || context.state.searchFindRegex) {
         HexBedDocument& doc = ed->document();
         bufsize sn = doc.size();
+        MatchIndex* index = getIndexFor(context, doc, search);
         HexBedTask task(&context, 0, true);
-        task.run([&res, &context, &doc, sn, dn, cur, search](HexBedTask& task) {
-            if (context.state.searchFindText &&
-                context.state.searchFindTextCaseInsensitive)
+        task.run([&res, &context, &doc, index, sn, dn, cur,
+                  search](HexBedTask& task) {
+            if (context.state.searchFindRegex)
+                res = findPrevRegex(task, doc, context, sn, cur,
+                                    context.state.searchWrapAround);
+            else if (context.state.searchFindMasked)
+                res = findPrevMasked(task, doc, context, sn, cur,
+                                     context.state.searchWrapAround);
+            else if (context.state.searchFindText &&
+                     context.state.searchFindTextCaseInsensitive)
                 res = findPrevCaseInsensitive(task, doc, context, sn, cur,
                                               context.state.searchWrapAround);
+            else if (index && index->current())
+                res = index->previous(cur, context.state.searchWrapAround);
             else if (cur >= dn)
                 res = doc.searchBackwardFull(
                     task, cur - dn, context.state.searchWrapAround, search);
@@ -48,14 +48,19 @@ class FindDocumentControl : public wxPanel {
   public:
     FindDocumentControl(wxWindow* parent,
                         std::shared_ptr<HexBedContextMain> context,
-                        std::shared_ptr<HexBedDocument> document, bool isFind);
+                        std::shared_ptr<HexBedDocument> document, bool isFind,
+                        bool allowPattern = false);
     bool DoValidate();
     void ForwardEvent(wxCommandEvent& event);
     void ForwardBookEvent(wxBookCtrlEvent& event);
     void UpdateConfig();
 
     bool NonEmpty() const noexcept;
+    bool IsFindingData() const noexcept;
     bool IsFindingText() const noexcept;
+    bool IsFindingMasked() const noexcept;
+    bool IsFindingRegex() const noexcept;
+    bool IsTypingByte() const noexcept;
 
   private:
     std::shared_ptr<HexBedContextMain> context_;
@@ -66,10 +71,25 @@ class FindDocumentControl : public wxPanel {
     HexBedStandaloneEditor* editor_;
     HexBedTextInput* textInput_;
     HexBedValueInput* valueInput_;
+    wxTextCtrl* patternInput_{nullptr};
+    wxTextCtrl* regexInput_{nullptr};
 };
 
 struct FindDialogNoPrepare {};
 
+// an incremental search that found nothing close by, and goes on through
+// the rest of the document a slice at a time
+struct IncrementalSearch {
+    // whether the last byte of the search string is still being typed, in
+    // which case the match index of the bytes before it is kept
+    bool partial{false};
+    bool pending{false};
+    bool wrapped{false};
+    HexBedDocument* document{nullptr};
+    bufoffset start{0};
+    bufoffset next{0};
+};
+
 class FindDialog : public wxDialog {
   public:
     FindDialog(HexBedMainFrame* parent,
@@ -87,12 +107,18 @@ class FindDialog : public wxDialog {
 
     static SearchResult findNext(HexEditorParent* ed);
     static SearchResult findPrevious(HexEditorParent* ed);
+    static SearchResult findIncremental(HexEditorParent* ed,
+                                        IncrementalSearch& state);
+    static SearchResult findIncrementalSlice(HexEditorParent* ed,
+                                             HexBedTask& task,
+                                             IncrementalSearch& state);
 
   protected:
     void OnCancel(wxCommandEvent& event);
 
     void OnFindNext(wxCommandEvent& event);
     void OnFindPrevious(wxCommandEvent& event);
+    void OnFindAll(wxCommandEvent& event);
 
     bool CheckInput();
 
@@ -103,6 +129,8 @@ class FindDialog : public wxDialog {
     FindDocumentControl* control_;
     wxButton* findNextButton_;
     wxButton* findPrevButton_;
+    wxButton* findAllButton_{nullptr};
+    wxCheckBox* incremental_{nullptr};
 
     bool dirty_{false};
 
@@ -0,0 +1,104 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// ui/dialogs/findbits.cc -- impl for the Find Bits dialog
+
+#include "ui/dialogs/findbits.hh"
+
+#include <wx/msgdlg.h>
+#include <wx/sizer.h>
+#include <wx/stattext.h>
+
+#include <vector>
+
+#include "ui/hexbed.hh"
+#include "ui/string.hh"
+
+namespace hexbed {
+
+namespace ui {
+
+FindBitsDialog::FindBitsDialog(HexBedMainFrame* parent, const string& initial)
+    : wxDialog(parent, wxID_ANY, _("Find bits"), wxDefaultPosition,
+               wxSize(400, 200), wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER) {
+    SetReturnCode(wxID_CANCEL);
+
+    wxBoxSizer* top = new wxBoxSizer(wxVERTICAL);
+    wxStdDialogButtonSizer* buttons = new wxStdDialogButtonSizer();
+
+    okButton_ = new wxButton(this, wxID_OK);
+    okButton_->Bind(wxEVT_BUTTON, &FindBitsDialog::OnOK, this);
+
+    wxButton* cancelButton = new wxButton(this, wxID_CANCEL);
+    cancelButton->Bind(wxEVT_BUTTON, &FindBitsDialog::OnCancel, this);
+
+    buttons->SetAffirmativeButton(okButton_);
+    buttons->SetNegativeButton(cancelButton);
+    buttons->Realize();
+
+    bitsInput_ = new wxTextCtrl(this, wxID_ANY, initial, wxDefaultPosition,
+                                wxSize(-1, 60), wxTE_MULTILINE);
+
+    top->Add(new wxStaticText(
+        this, wxID_ANY,
+        _("Bits to find (0 and 1, most significant first, at any bit "
+          "offset):")));
+    top->Add(bitsInput_, wxSizerFlags().Expand().Proportion(1));
+    top->Add(buttons, wxSizerFlags().Expand());
+
+    SetSizer(top);
+    Layout();
+    SetMinSize(GetSize());
+}
+
+std::shared_ptr<const BitPattern> FindBitsDialog::GetPattern() const noexcept {
+    return pattern_;
+}
+
+std::shared_ptr<const BitPattern> FindBitsDialog::MakePattern(
+    const wxString& text) {
+    std::vector<bool> bits;
+    if (!bitsFromString(bits, stringFromWx(text)) ||
+        bits.size() > BitPattern::MAXIMUM_LENGTH) {
+        wxMessageBox(
+            wxString::Format(_("Enter between one and %llu bits, as 0 and 1."),
+                             static_cast<unsigned long long>(
+                                 BitPattern::MAXIMUM_LENGTH)),
+            "HexBed", wxOK | wxICON_ERROR);
+        return nullptr;
+    }
+    return std::make_shared<const BitPattern>(bits);
+}
+
+void FindBitsDialog::EndDialog(int r) {
+    SetReturnCode(r);
+    if (IsModal()) EndModal(r);
+}
+
+void FindBitsDialog::OnOK(wxCommandEvent& event) {
+    if ((pattern_ = MakePattern(bitsInput_->GetValue()))) EndDialog(wxID_OK);
+}
+
+void FindBitsDialog::OnCancel(wxCommandEvent& event) {
+    EndDialog(wxID_CANCEL);
+}
+
+};  // namespace ui
+
+};  // namespace hexbed
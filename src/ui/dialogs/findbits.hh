@@ -0,0 +1,63 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// ui/dialogs/findbits.hh -- header for the Find Bits dialog
+
+#ifndef HEXBED_UI_DIALOGS_FINDBITS_HH
+#define HEXBED_UI_DIALOGS_FINDBITS_HH
+
+#include <wx/dialog.h>
+#include <wx/textctrl.h>
+
+#include <memory>
+
+#include "common/types.hh"
+#include "file/bitsearch.hh"
+#include "ui/hexbed-fwd.hh"
+
+namespace hexbed {
+
+namespace ui {
+
+class FindBitsDialog : public wxDialog {
+  public:
+    FindBitsDialog(HexBedMainFrame* parent, const string& initial);
+    std::shared_ptr<const BitPattern> GetPattern() const noexcept;
+
+    // shows an error and returns nullptr if the text is not a bit string
+    static std::shared_ptr<const BitPattern> MakePattern(const wxString& text);
+
+  protected:
+    void OnOK(wxCommandEvent& event);
+    void OnCancel(wxCommandEvent& event);
+
+  private:
+    void EndDialog(int result);
+
+    wxTextCtrl* bitsInput_;
+    wxButton* okButton_;
+
+    std::shared_ptr<const BitPattern> pattern_;
+};
+
+};  // namespace ui
+
+};  // namespace hexbed
+
+#endif /* HEXBED_UI_DIALOGS_FINDBITS_HH */
@@ -0,0 +1,136 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// ui/dialogs/findsimilar.cc -- impl for the Find Similar dialog
+
+#include "ui/dialogs/findsimilar.hh"
+
+#include <wx/msgdlg.h>
+#include <wx/sizer.h>
+#include <wx/stattext.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "common/hexconv.hh"
+#include "ui/hexbed.hh"
+#include "ui/string.hh"
+
+namespace hexbed {
+
+namespace ui {
+
+FindSimilarDialog::FindSimilarDialog(HexBedMainFrame* parent,
+                                     const string& initial)
+    : wxDialog(parent, wxID_ANY, _("Find similar"), wxDefaultPosition,
+               wxSize(400, 300), wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER) {
+    SetReturnCode(wxID_CANCEL);
+
+    wxBoxSizer* top = new wxBoxSizer(wxVERTICAL);
+    wxStdDialogButtonSizer* buttons = new wxStdDialogButtonSizer();
+
+    okButton_ = new wxButton(this, wxID_OK);
+    okButton_->Bind(wxEVT_BUTTON, &FindSimilarDialog::OnOK, this);
+
+    wxButton* cancelButton = new wxButton(this, wxID_CANCEL);
+    cancelButton->Bind(wxEVT_BUTTON, &FindSimilarDialog::OnCancel, this);
+
+    buttons->SetAffirmativeButton(okButton_);
+    buttons->SetNegativeButton(cancelButton);
+    buttons->Realize();
+
+    needleInput_ = new wxTextCtrl(this, wxID_ANY, wxString::FromUTF8(initial),
+                                  wxDefaultPosition, wxSize(-1, 100),
+                                  wxTE_MULTILINE);
+    distanceSpinner_ = new wxSpinCtrl(
+        this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
+        wxSP_ARROW_KEYS, 0, ApproximatePattern::MAXIMUM_LENGTH - 1, 1);
+    hammingRadio_ =
+        new wxRadioButton(this, wxID_ANY, _("Changed bytes only"),
+                          wxDefaultPosition, wxDefaultSize, wxRB_GROUP);
+    editRadio_ = new wxRadioButton(this, wxID_ANY,
+                                   _("Changed, inserted or removed bytes"));
+    hammingRadio_->SetValue(true);
+
+    top->Add(new wxStaticText(
+        this, wxID_ANY,
+        wxString::Format(_("Bytes to find (hex, up to %llu bytes):"),
+                         static_cast<unsigned long long>(
+                             ApproximatePattern::MAXIMUM_LENGTH))));
+    top->Add(needleInput_, wxSizerFlags().Expand().Proportion(1));
+    top->Add(new wxStaticText(this, wxID_ANY, _("Maximum differences:")));
+    top->Add(distanceSpinner_, wxSizerFlags().Expand());
+    top->Add(hammingRadio_, wxSizerFlags().Expand());
+    top->Add(editRadio_, wxSizerFlags().Expand());
+    top->Add(buttons, wxSizerFlags().Expand());
+
+    SetSizer(top);
+    Layout();
+    SetMinSize(GetSize());
+}
+
+std::shared_ptr<const ApproximatePattern> FindSimilarDialog::GetPattern()
+    const noexcept {
+    return pattern_;
+}
+
+bool FindSimilarDialog::MakePattern() {
+    string text = stringFromWx(needleInput_->GetValue());
+    bufsize n = ApproximatePattern::MAXIMUM_LENGTH + 1;
+    std::vector<byte> needle(n);
+    if (!hexToBytes(n, needle.data(), text)) {
+        wxMessageBox(_("The bytes to find are not valid hex."), "HexBed",
+                     wxOK | wxICON_ERROR);
+        return false;
+    }
+    needle.resize(n);
+    try {
+        pattern_ = std::make_shared<ApproximatePattern>(
+            const_bytespan(needle.data(), needle.size()),
+            static_cast<bufsize>(distanceSpinner_->GetValue()),
+            editRadio_->GetValue() ? ApproximateMetric::Edit
+                                   : ApproximateMetric::Hamming);
+    } catch (const std::invalid_argument&) {
+        wxMessageBox(
+            wxString::Format(_("Enter between one and %llu bytes, more "
+                               "than the maximum number of differences."),
+                             static_cast<unsigned long long>(
+                                 ApproximatePattern::MAXIMUM_LENGTH)),
+            "HexBed", wxOK | wxICON_ERROR);
+        return false;
+    }
+    return true;
+}
+
+void FindSimilarDialog::EndDialog(int r) {
+    SetReturnCode(r);
+    if (IsModal()) EndModal(r);
+}
+
+void FindSimilarDialog::OnOK(wxCommandEvent& event) {
+    if (MakePattern()) EndDialog(wxID_OK);
+}
+
+void FindSimilarDialog::OnCancel(wxCommandEvent& event) {
+    EndDialog(wxID_CANCEL);
+}
+
+};  // namespace ui
+
+};  // namespace hexbed
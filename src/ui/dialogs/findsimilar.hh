@@ -0,0 +1,66 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// ui/dialogs/findsimilar.hh -- header for the Find Similar dialog
+
+#ifndef HEXBED_UI_DIALOGS_FINDSIMILAR_HH
+#define HEXBED_UI_DIALOGS_FINDSIMILAR_HH
+
+#include <wx/dialog.h>
+#include <wx/radiobut.h>
+#include <wx/spinctrl.h>
+#include <wx/textctrl.h>
+
+#include <memory>
+
+#include "common/types.hh"
+#include "file/approxsearch.hh"
+#include "ui/hexbed-fwd.hh"
+
+namespace hexbed {
+
+namespace ui {
+
+class FindSimilarDialog : public wxDialog {
+  public:
+    FindSimilarDialog(HexBedMainFrame* parent, const string& initial);
+    std::shared_ptr<const ApproximatePattern> GetPattern() const noexcept;
+
+  protected:
+    void OnOK(wxCommandEvent& event);
+    void OnCancel(wxCommandEvent& event);
+
+  private:
+    void EndDialog(int result);
+    bool MakePattern();
+
+    wxTextCtrl* needleInput_;
+    wxSpinCtrl* distanceSpinner_;
+    wxRadioButton* hammingRadio_;
+    wxRadioButton* editRadio_;
+    wxButton* okButton_;
+
+    std::shared_ptr<ApproximatePattern> pattern_;
+};
+
+};  // namespace ui
+
+};  // namespace hexbed
+
+#endif /* HEXBED_UI_DIALOGS_FINDSIMILAR_HH */
@@ -0,0 +1,109 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// ui/dialogs/findtext.cc -- impl for the Find Text in Any Encoding dialog
+
+#include "ui/dialogs/findtext.hh"
+
+#include <wx/msgdlg.h>
+#include <wx/sizer.h>
+#include <wx/stattext.h>
+
+#include "common/charconv.hh"
+#include "file/textsearch.hh"
+#include "ui/encoding.hh"
+#include "ui/hexbed.hh"
+
+namespace hexbed {
+
+namespace ui {
+
+FindTextDialog::FindTextDialog(HexBedMainFrame* parent)
+    : wxDialog(parent, wxID_ANY, _("Find text in any encoding"),
+               wxDefaultPosition, wxSize(300, 200), wxDEFAULT_DIALOG_STYLE) {
+    SetReturnCode(wxID_CANCEL);
+
+    wxBoxSizer* top = new wxBoxSizer(wxVERTICAL);
+    wxStdDialogButtonSizer* buttons = new wxStdDialogButtonSizer();
+
+    okButton_ = new wxButton(this, wxID_OK);
+    okButton_->Bind(wxEVT_BUTTON, &FindTextDialog::OnOK, this);
+
+    wxButton* cancelButton = new wxButton(this, wxID_CANCEL);
+    cancelButton->Bind(wxEVT_BUTTON, &FindTextDialog::OnCancel, this);
+
+    buttons->SetAffirmativeButton(okButton_);
+    buttons->SetNegativeButton(cancelButton);
+    buttons->Realize();
+
+    textInput_ = new wxTextCtrl(this, wxID_ANY);
+    caseInsensitive_ = new wxCheckBox(this, wxID_ANY, _("Case insensitive"));
+
+    top->Add(new wxStaticText(this, wxID_ANY, _("Text")));
+    top->Add(textInput_, wxSizerFlags().Expand());
+    top->Add(caseInsensitive_, wxSizerFlags().Expand());
+    top->Add(new wxStaticText(
+        this, wxID_ANY,
+        _("Every encoding is searched for at once. Each match shows the "
+          "encodings it was found in.")));
+    top->Add(buttons, wxSizerFlags().Expand());
+
+    SetSizer(top);
+    Fit();
+    Layout();
+}
+
+std::shared_ptr<const MultiPattern> FindTextDialog::GetPatterns()
+    const noexcept {
+    return patterns_;
+}
+
+bool FindTextDialog::MakePatterns() {
+    std::u32string text =
+        wstringToU32string(textInput_->GetValue().ToStdWstring());
+    if (text.empty()) return false;
+    auto patterns = std::make_shared<MultiPattern>();
+    if (!addEncodedText(*patterns, text, textEncodings(),
+                        caseInsensitive_->GetValue())) {
+        wxMessageBox(_("The entered text cannot be represented in any "
+                       "encoding."),
+                     "HexBed", wxOK | wxICON_ERROR);
+        return false;
+    }
+    patterns->compile();
+    patterns_ = std::move(patterns);
+    return true;
+}
+
+void FindTextDialog::EndDialog(int r) {
+    SetReturnCode(r);
+    if (IsModal()) EndModal(r);
+}
+
+void FindTextDialog::OnOK(wxCommandEvent& event) {
+    if (MakePatterns()) EndDialog(wxID_OK);
+}
+
+void FindTextDialog::OnCancel(wxCommandEvent& event) {
+    EndDialog(wxID_CANCEL);
+}
+
+};  // namespace ui
+
+};  // namespace hexbed
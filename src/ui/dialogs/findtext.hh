@@ -0,0 +1,63 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// ui/dialogs/findtext.hh -- header for the Find Text in Any Encoding dialog
+
+#ifndef HEXBED_UI_DIALOGS_FINDTEXT_HH
+#define HEXBED_UI_DIALOGS_FINDTEXT_HH
+
+#include <wx/checkbox.h>
+#include <wx/dialog.h>
+#include <wx/textctrl.h>
+
+#include <memory>
+
+#include "common/types.hh"
+#include "file/multisearch.hh"
+#include "ui/hexbed-fwd.hh"
+
+namespace hexbed {
+
+namespace ui {
+
+class FindTextDialog : public wxDialog {
+  public:
+    FindTextDialog(HexBedMainFrame* parent);
+    std::shared_ptr<const MultiPattern> GetPatterns() const noexcept;
+
+  protected:
+    void OnOK(wxCommandEvent& event);
+    void OnCancel(wxCommandEvent& event);
+
+  private:
+    void EndDialog(int result);
+    bool MakePatterns();
+
+    wxTextCtrl* textInput_;
+    wxCheckBox* caseInsensitive_;
+    wxButton* okButton_;
+
+    std::shared_ptr<MultiPattern> patterns_;
+};
+
+};  // namespace ui
+
+};  // namespace hexbed
+
+#endif /* HEXBED_UI_DIALOGS_FINDTEXT_HH */
@@ -0,0 +1,202 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// ui/dialogs/findvalues.cc -- impl for the Find Values dialog
+
+#include "ui/dialogs/findvalues.hh"
+
+#include <wx/msgdlg.h>
+#include <wx/sizer.h>
+#include <wx/translation.h>
+
+#include <cctype>
+#include <cstdlib>
+
+#include "common/intconv.hh"
+#include "ui/hexbed.hh"
+#include "ui/string.hh"
+
+namespace hexbed {
+
+namespace ui {
+
+// in the order of NumericType, with the titles of the data inspectors
+static const char* const numericTypeTitles[] = {
+    wxTRANSLATE("int8 (signed 8-bit integer)"),
+    wxTRANSLATE("uint8 (unsigned 8-bit integer)"),
+    wxTRANSLATE("int16 (signed 16-bit integer)"),
+    wxTRANSLATE("uint16 (unsigned 16-bit integer)"),
+    wxTRANSLATE("int32 (signed 32-bit integer)"),
+    wxTRANSLATE("uint32 (unsigned 32-bit integer)"),
+    wxTRANSLATE("int64 (signed 64-bit integer)"),
+    wxTRANSLATE("uint64 (unsigned 64-bit integer)"),
+    wxTRANSLATE("float (IEEE 754 binary32 single-precision floating-point)"),
+    wxTRANSLATE("double (IEEE 754 binary64 double-precision floating-point)"),
+};
+
+FindValuesDialog::FindValuesDialog(HexBedMainFrame* parent)
+    : wxDialog(parent, wxID_ANY, _("Find values"), wxDefaultPosition,
+               wxSize(300, 250), wxDEFAULT_DIALOG_STYLE) {
+    SetReturnCode(wxID_CANCEL);
+
+    wxBoxSizer* top = new wxBoxSizer(wxVERTICAL);
+    wxStdDialogButtonSizer* buttons = new wxStdDialogButtonSizer();
+
+    okButton_ = new wxButton(this, wxID_OK);
+    okButton_->Bind(wxEVT_BUTTON, &FindValuesDialog::OnOK, this);
+
+    wxButton* cancelButton = new wxButton(this, wxID_CANCEL);
+    cancelButton->Bind(wxEVT_BUTTON, &FindValuesDialog::OnCancel, this);
+
+    buttons->SetAffirmativeButton(okButton_);
+    buttons->SetNegativeButton(cancelButton);
+    buttons->Realize();
+
+    typeChoice_ = new wxChoice(this, wxID_ANY);
+    for (const char* title : numericTypeTitles)
+        typeChoice_->Append(wxGetTranslation(title));
+    typeChoice_->SetSelection(static_cast<int>(NumericType::Int32));
+    typeChoice_->Bind(wxEVT_CHOICE, &FindValuesDialog::OnChangeType, this);
+
+    firstLabel_ = new wxStaticText(this, wxID_ANY, wxEmptyString);
+    firstInput_ = new wxTextCtrl(this, wxID_ANY);
+    secondLabel_ = new wxStaticText(this, wxID_ANY, wxEmptyString);
+    secondInput_ = new wxTextCtrl(this, wxID_ANY);
+
+    std::vector<wxString> orderTexts{_("Little endian"), _("Big endian"),
+                                     _("Both")};
+    orderChoice_ = new wxChoice(this, wxID_ANY, wxDefaultPosition,
+                                wxDefaultSize, orderTexts.size(),
+                                orderTexts.data());
+    orderChoice_->SetSelection(2);
+
+    strideSpinner_ = new wxSpinCtrl(this, wxID_ANY, wxEmptyString,
+                                    wxDefaultPosition, wxDefaultSize,
+                                    wxSP_ARROW_KEYS, 1, 4096, 1);
+
+    top->Add(new wxStaticText(this, wxID_ANY, _("Type:")));
+    top->Add(typeChoice_, wxSizerFlags().Expand());
+    top->Add(firstLabel_, wxSizerFlags().Expand());
+    top->Add(firstInput_, wxSizerFlags().Expand());
+    top->Add(secondLabel_, wxSizerFlags().Expand());
+    top->Add(secondInput_, wxSizerFlags().Expand());
+    top->Add(new wxStaticText(this, wxID_ANY, _("Byte order:")));
+    top->Add(orderChoice_, wxSizerFlags().Expand());
+    top->Add(new wxStaticText(this, wxID_ANY, _("Alignment (bytes):")));
+    top->Add(strideSpinner_, wxSizerFlags().Expand());
+    top->Add(buttons, wxSizerFlags().Expand());
+    UpdateLabels();
+
+    SetSizer(top);
+    Fit();
+    Layout();
+}
+
+std::shared_ptr<const NumericQuery> FindValuesDialog::GetQuery()
+    const noexcept {
+    return query_;
+}
+
+NumericType FindValuesDialog::GetType() const noexcept {
+    int i = typeChoice_->GetSelection();
+    return i == wxNOT_FOUND ? NumericType::Int32 : static_cast<NumericType>(i);
+}
+
+void FindValuesDialog::UpdateLabels() {
+    if (numericTypeIsFloat(GetType())) {
+        firstLabel_->SetLabel(_("Value:"));
+        secondLabel_->SetLabel(_("Tolerance:"));
+    } else {
+        firstLabel_->SetLabel(_("Minimum:"));
+        secondLabel_->SetLabel(_("Maximum (empty for same as minimum):"));
+    }
+    Layout();
+}
+
+static bool parseDouble(double& result, const string& text) {
+    const char* s = text.c_str();
+    char* endptr;
+    result = std::strtod(s, &endptr);
+    if (endptr == s) return false;
+    while (std::isspace(static_cast<unsigned char>(*endptr))) ++endptr;
+    return !*endptr;
+}
+
+bool FindValuesDialog::MakeQuery() {
+    NumericType type = GetType();
+    string first = stringFromWx(firstInput_->GetValue());
+    string second = stringFromWx(secondInput_->GetValue());
+    bool ok;
+    if (numericTypeIsFloat(type)) {
+        double x, epsilon = 0;
+        ok = parseDouble(x, first) &&
+             (second.empty() || parseDouble(epsilon, second));
+        if (ok)
+            query_ = std::make_shared<NumericQuery>(
+                NumericQuery::nearFloat(type, x, epsilon));
+    } else if (numericTypeIsSigned(type)) {
+        std::int64_t lo, hi;
+        ok = intFromString<std::int64_t>(lo, first.c_str()) &&
+             (second.empty() ? (hi = lo, true)
+                             : intFromString<std::int64_t>(hi, second.c_str()));
+        if (ok)
+            query_ = std::make_shared<NumericQuery>(
+                NumericQuery::inSigned(type, lo, hi));
+    } else {
+        std::uint64_t lo, hi;
+        ok = uintFromString<std::uint64_t>(lo, first.c_str()) &&
+             (second.empty()
+                  ? (hi = lo, true)
+                  : uintFromString<std::uint64_t>(hi, second.c_str()));
+        if (ok)
+            query_ = std::make_shared<NumericQuery>(
+                NumericQuery::inUnsigned(type, lo, hi));
+    }
+    if (!ok) {
+        wxMessageBox(_("The entered value cannot be represented with the "
+                       "specified data type."),
+                     "HexBed", wxOK | wxICON_ERROR);
+        return false;
+    }
+    int order = orderChoice_->GetSelection();
+    query_->byteOrders(order != 1, order != 0)
+        .stride(static_cast<bufsize>(strideSpinner_->GetValue()));
+    return true;
+}
+
+void FindValuesDialog::EndDialog(int r) {
+    SetReturnCode(r);
+    if (IsModal()) EndModal(r);
+}
+
+void FindValuesDialog::OnOK(wxCommandEvent& event) {
+    if (MakeQuery()) EndDialog(wxID_OK);
+}
+
+void FindValuesDialog::OnCancel(wxCommandEvent& event) {
+    EndDialog(wxID_CANCEL);
+}
+
+void FindValuesDialog::OnChangeType(wxCommandEvent& event) {
+    UpdateLabels();
+}
+
+};  // namespace ui
+
+};  // namespace hexbed
@@ -0,0 +1,73 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// ui/dialogs/findvalues.hh -- header for the Find Values dialog
+
+#ifndef HEXBED_UI_DIALOGS_FINDVALUES_HH
+#define HEXBED_UI_DIALOGS_FINDVALUES_HH
+
+#include <wx/choice.h>
+#include <wx/dialog.h>
+#include <wx/spinctrl.h>
+#include <wx/stattext.h>
+#include <wx/textctrl.h>
+
+#include <memory>
+
+#include "common/types.hh"
+#include "file/numsearch.hh"
+#include "ui/hexbed-fwd.hh"
+
+namespace hexbed {
+
+namespace ui {
+
+class FindValuesDialog : public wxDialog {
+  public:
+    FindValuesDialog(HexBedMainFrame* parent);
+    std::shared_ptr<const NumericQuery> GetQuery() const noexcept;
+
+  protected:
+    void OnOK(wxCommandEvent& event);
+    void OnCancel(wxCommandEvent& event);
+    void OnChangeType(wxCommandEvent& event);
+
+  private:
+    void EndDialog(int result);
+    NumericType GetType() const noexcept;
+    void UpdateLabels();
+    bool MakeQuery();
+
+    wxChoice* typeChoice_;
+    wxStaticText* firstLabel_;
+    wxTextCtrl* firstInput_;
+    wxStaticText* secondLabel_;
+    wxTextCtrl* secondInput_;
+    wxChoice* orderChoice_;
+    wxSpinCtrl* strideSpinner_;
+    wxButton* okButton_;
+
+    std::shared_ptr<NumericQuery> query_;
+};
+
+};  // namespace ui
+
+};  // namespace hexbed
+
+#endif /* HEXBED_UI_DIALOGS_FINDVALUES_HH */
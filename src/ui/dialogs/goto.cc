@@ -32,8 +32,11 @@ namespace hexbed {
 namespace ui {
 
 GoToDialog::GoToDialog(wxWindow* parent, bufsize cur, bufsize end)
-    : wxDialog(parent, wxID_ANY, _("Go to"), wxDefaultPosition,
-               wxSize(300, 200)),
+    : GoToDialog(parent, cur, end, _("Go to")) {}
+
+GoToDialog::GoToDialog(wxWindow* parent, bufsize cur, bufsize end,
+                       const wxString& title)
+    : wxDialog(parent, wxID_ANY, title, wxDefaultPosition, wxSize(300, 200)),
       cur_(cur),
       end_(end) {
     SetReturnCode(wxID_CANCEL);
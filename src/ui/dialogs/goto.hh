@@ -40,6 +40,8 @@ namespace ui {
 class GoToDialog : public wxDialog {
   public:
     GoToDialog(wxWindow* parent, bufsize cur, bufsize end);
+    GoToDialog(wxWindow* parent, bufsize cur, bufsize end,
+               const wxString& title);
     bufsize GetOffset() const noexcept;
     void UpdateMetrics(bufsize cur, bufsize end);
 
@@ -26,8 +26,11 @@
 #include <wx/sizer.h>
 #include <wx/valgen.h>
 
+#include <algorithm>
 #include <type_traits>
+#include <vector>
 
+#include "file/regex.hh"
 #include "ui/hexbed.hh"
 #include "ui/settings/validate.hh"
 
@@ -127,6 +130,7 @@ ReplaceDialog::ReplaceDialog(HexBedMainFrame* parent,
 bool ReplaceDialog::Recommit() {
     if (!FindDialog::Recommit()) return false;
     context_->state.searchFindText = control_->IsFindingText();
+    context_->state.searchReplaceText = replace_->IsFindingText();
     if (dirtyReplace_) {
         dirtyReplace_ = false;
         bufsize n = repdoc_->size();
@@ -200,50 +204,116 @@ void ReplaceDialog::OnChangedReplaceInput(wxCommandEvent& event) {
     dirtyReplace_ = true;
 }
 
+// text replacements may refer to regex groups with \0 to \9
+static std::vector<byte> regexReplacement(HexBedContextMain& context,
+                                          const RegexCaptures& captures) {
+    const_bytespan replace = context.getReplaceString();
+    if (context.state.searchReplaceText) return captures.expand(replace);
+    return std::vector<byte>(replace.begin(), replace.end());
+}
+
 void ReplaceDialog::replaceSelection(HexEditorParent* ed) {
     bufsize sel, seln;
     bool seltext;
     ed->GetSelection(sel, seln, seltext);
-    if (ed->document().compareEqual(sel, seln,
-                                    ed->context().getSearchString())) {
-        const_bytespan replace = ed->context().getReplaceString();
+    HexBedContextMain& context = ed->context();
+    if (context.state.searchFindRegex) {
+        RegexCaptures captures;
+        if (context.state.searchRegex->match(ed->document(), sel, seln,
+                                             captures)) {
+            std::vector<byte> replace = regexReplacement(context, captures);
+            ed->document().replace(
+                sel, seln, const_bytespan(replace.data(), replace.size()));
+            ed->SelectBytes(sel + replace.size(), 0, SelectFlags());
+        }
+    } else if (ed->document().compareEqual(sel, seln,
+                                           context.getSearchString())) {
+        const_bytespan replace = context.getReplaceString();
         ed->document().replace(sel, seln, replace);
         ed->SelectBytes(sel + replace.size(), 0, SelectFlags());
     }
 }
 
+// applies every replacement at once and moves the cursor along with the
+// data before it
+static void spliceAll(HexEditorParent* ed, bufsize sel,
+                      const std::vector<HexBedSplice>& splices) {
+    bufsize cur = sel;
+    for (const HexBedSplice& splice : splices) {
+        if (splice.offset >= sel) break;
+        bufsize sn = splice.size, rn = splice.data.size();
+        if (sn != rn) {
+            cur = cur >= sn ? cur - sn : 0;
+            cur += rn;
+        }
+    }
+    ed->document().splice(splices);
+    ed->SelectBytes(cur, 0, SelectFlags());
+}
+
+static bool replaceAllRegex(HexEditorParent* ed, bufsize& count) {
+    bufsize sel, seln;
+    bool seltext;
+    ed->GetSelection(sel, seln, seltext);
+    HexBedContextMain& context = ed->context();
+    ByteRegex& regex = *context.state.searchRegex;
+    HexBedDocument& doc = ed->document();
+    std::vector<HexBedSplice> splices;
+    // the replacements are expanded into one pool as they are found
+    std::vector<byte> pool;
+    std::vector<bufsize> starts;
+    HexBedTask task(&context, doc.size(), true);
+    task.run([&doc, &context, &regex, &splices, &pool,
+              &starts](HexBedTask& task) {
+        SearchResult res;
+        RegexCaptures captures;
+        bufsize rat = 0, dn = doc.size();
+        while (!task.isCancelled() &&
+               (res = regex.searchForward(task, doc, rat, dn))) {
+            if (!regex.match(doc, res.offset, res.length, captures)) break;
+            std::vector<byte> replace = regexReplacement(context, captures);
+            starts.push_back(pool.size());
+            pool.insert(pool.end(), replace.begin(), replace.end());
+            splices.push_back(HexBedSplice{res.offset, res.length, {}});
+            rat = res.offset + std::max<bufsize>(res.length, 1);
+            task.progress(rat);
+        }
+    });
+    count = splices.size();
+    if (task.isCancelled()) return false;
+    starts.push_back(pool.size());
+    for (std::size_t i = 0; i < splices.size(); ++i)
+        splices[i].data = const_bytespan(pool.data() + starts[i],
+                                         pool.data() + starts[i + 1]);
+    spliceAll(ed, sel, splices);
+    return true;
+}
+
 bool ReplaceDialog::replaceAll(HexEditorParent* ed, bufsize& count) {
-    bufsize sel, seln, repls = 0;
+    if (ed->context().state.searchFindRegex) return replaceAllRegex(ed, count);
+    bufsize sel, seln;
     bool seltext;
     ed->GetSelection(sel, seln, seltext);
     const_bytespan search = ed->context().getSearchString();
     const_bytespan replace = ed->context().getReplaceString();
-    bufsize sn = search.size(), rn = replace.size();
+    bufsize sn = search.size();
     HexBedDocument& doc = ed->document();
-    UndoGroupToken ugt = doc.undoGroup();
-    bufsize cur = sel;
-    HexBedTask task(&ed->context(), 0, true);
-    task.run(
-        [&ugt, &doc, search, replace, sn, rn, &repls, &cur](HexBedTask& task) {
-            SearchResult res;
-            bufsize rat = 0;
-            while (!task.isCancelled() &&
-                   (res = doc.searchForwardFull(task, rat, false, search))) {
-                bufsize so = res.offset;
-                ++repls;
-                if (so < cur && sn != rn) {
-                    cur = cur >= sn ? cur - sn : 0;
-                    cur += rn;
-                }
-                doc.replace(so, sn, replace);
-                ugt.tick();
-                rat = so + rn;
-            }
-        });
-    ed->SelectBytes(cur, 0, SelectFlags());
-    count = repls;
+    std::vector<HexBedSplice> splices;
+    // gather every match in one scan before touching the document
+    HexBedTask task(&ed->context(), doc.size(), true);
+    task.run([&doc, search, replace, sn, &splices](HexBedTask& task) {
+        bufoffset next = 0;
+        doc.searchAll(task, 0, doc.size(), search,
+                      [&task, replace, sn, &splices, &next](bufoffset o) {
+                          if (o < next) return;
+                          splices.push_back(HexBedSplice{o, sn, replace});
+                          next = o + sn;
+                          task.progress(next);
+                      });
+    });
+    count = splices.size();
     if (task.isCancelled()) return false;
-    ugt.commit();
+    spliceAll(ed, sel, splices);
     return true;
 }
 
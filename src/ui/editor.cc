@@ -116,7 +116,8 @@ HexBedEditor::HexBedEditor(HexBedMainFrame* frame, wxWindow* parent,
       document_(std::move(document)),
       ctx_(ctx),
       timer_(this, wxID_ANY),
-      autoResize_(autoResize) {
+      autoResize_(autoResize),
+      followTimer_(this, wxID_ANY) {
     box_ = new wxBoxSizer(wxVERTICAL);
     SetSizer(box_);
     int gap = 4;
@@ -161,7 +162,9 @@ HexBedEditor::HexBedEditor(HexBedMainFrame* frame, wxWindow* parent,
                      this);
 
     Bind(wxEVT_SIZE, &HexBedEditor::OnResize, this);
-    Bind(wxEVT_TIMER, &HexBedEditor::OnResizeTimer, this);
+    Bind(wxEVT_TIMER, &HexBedEditor::OnResizeTimer, this, timer_.GetId());
+    Bind(wxEVT_TIMER, &HexBedEditor::OnFollowTimer, this,
+         followTimer_.GetId());
 
     scroll_->Bind(wxEVT_SCROLL_TOP, &HexBedEditor::OnScroll, this);
     scroll_->Bind(wxEVT_SCROLL_BOTTOM, &HexBedEditor::OnScroll, this);
@@ -192,6 +195,60 @@ void HexBedEditor::OnResizeTimer(wxTimerEvent& event) {
     if (!AutoFitUpdate()) ResizeUpdate();
 }
 
+void HexBedEditor::SetFollow(bool follow, bool toEnd) {
+    bool was = following_;
+    followToEnd_ = toEnd;
+    following_ = follow && (document().filed() || document().growing());
+    if (following_ && !was) {
+        // streams have no file to watch, so just poll the buffer
+        if (document().filed())
+            watcher_ = std::make_unique<FileWatcher>(
+                document().path(),
+                [this]() { CallAfter(&HexBedEditor::OnFileChanged); });
+        if (!watcher_ || !watcher_->notifies())
+            followTimer_.Start(FOLLOW_INTERVAL);
+        FollowUpdate();
+    } else if (!following_) {
+        followTimer_.Stop();
+        watcher_ = nullptr;
+    }
+}
+
+// called on the UI thread after the watcher has seen a change
+void HexBedEditor::OnFileChanged() {
+    if (!following_) return;
+    // look again once the task is done
+    if (ctx_->taskRunning()) {
+        if (!followTimer_.IsRunning())
+            followTimer_.StartOnce(FOLLOW_INTERVAL);
+    } else if (watcher_ && watcher_->poll()) {
+        FollowUpdate();
+    }
+}
+
+void HexBedEditor::OnFollowTimer(wxTimerEvent& event) {
+    if (!following_) return;
+    if (watcher_ && watcher_->notifies())
+        OnFileChanged();
+    else if (!ctx_->taskRunning() && (!watcher_ || watcher_->poll()))
+        FollowUpdate();
+}
+
+void HexBedEditor::FollowUpdate() {
+    try {
+        bufsize was = document().size();
+        bufsize n = document().follow();
+        if (document().size() < was) ReloadFile();
+        if ((n || document().size() < was) && followToEnd_)
+            BringOffsetToScreen(document().size());
+    } catch (...) {
+        SetFollow(false, followToEnd_);
+        frame_->Attention(
+            wxString::Format(_("Stopped following the file: %s"),
+                             currentExceptionAsString()));
+    }
+}
+
 void HexBedEditor::OnScroll(wxScrollEvent& event) {
     ScrollUpdate();
     DisplayUpdate();
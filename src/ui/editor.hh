@@ -36,6 +36,7 @@
 #include <memory>
 
 #include "file/document.hh"
+#include "file/watch.hh"
 #include "ui/context.hh"
 #include "ui/hexbed-fwd.hh"
 #include "ui/hexedit-fwd.hh"
@@ -48,6 +49,7 @@ wxDECLARE_EVENT(HEX_CARET_EVENT, wxCommandEvent);
 wxDECLARE_EVENT(HEX_SELECT_EVENT, wxCommandEvent);
 
 constexpr int RESIZE_TIMEOUT = 200;
+constexpr int FOLLOW_INTERVAL = 250;
 
 struct SelectFlags {
     constexpr SelectFlags() : value(0) {}
@@ -230,9 +232,16 @@ class HexBedEditor : public wxPanel, public HexEditorParent {
 
     void FocusEditor();
 
+    inline bool IsFollowing() const noexcept { return following_; }
+    inline bool IsFollowingToEnd() const noexcept { return followToEnd_; }
+    void SetFollow(bool follow, bool toEnd);
+    void FollowUpdate();
+
   protected:
     void OnResize(wxSizeEvent& event);
     void OnResizeTimer(wxTimerEvent& event);
+    void OnFollowTimer(wxTimerEvent& event);
+    void OnFileChanged();
     void OnScroll(wxScrollEvent& event);
     void OnMouseWheel(wxMouseEvent& event);
     void OnContextMenu(wxContextMenuEvent& event);
@@ -263,6 +272,10 @@ class HexBedEditor : public wxPanel, public HexEditorParent {
     std::vector<char> offsetBuf_;
     wxTimer timer_;
     bool autoResize_{false};
+    std::unique_ptr<FileWatcher> watcher_;
+    wxTimer followTimer_;
+    bool following_{false};
+    bool followToEnd_{false};
 };
 
 };  // namespace ui
@@ -22,6 +22,7 @@
 #include "ui/encoding.hh"
 
 #include <wx/strconv.h>
+#include <wx/translation.h>
 
 #include <cstring>
 
@@ -73,6 +74,27 @@ bool textDecode(const string& encoding, wxString& text, const_bytespan data) {
     return true;
 }
 
+std::vector<TextSearchEncoding> textEncodings() {
+    std::initializer_list<string> mbcsKeys{MBCS_ENCODING_KEYS()};
+    std::initializer_list<wxString> mbcsNames{MBCS_ENCODING_NAMES()};
+    std::initializer_list<string> sbcsKeys{SBCS_ENCODING_KEYS()};
+    std::initializer_list<wxString> sbcsNames{SBCS_ENCODING_NAMES()};
+    std::vector<TextSearchEncoding> encodings;
+    for (std::size_t i = 0; i < mbcsKeys.size(); ++i)
+        encodings.push_back(TextSearchEncoding{
+            mbcsKeys.begin()[i], mbcsNames.begin()[i].ToStdString(wxConvUTF8)});
+    for (std::size_t i = 0; i < sbcsKeys.size(); ++i)
+        encodings.push_back(TextSearchEncoding{
+            sbcsKeys.begin()[i], sbcsNames.begin()[i].ToStdString(wxConvUTF8)});
+    for (std::size_t i = 0, e = hexbed::plugins::charsetPluginCount(); i < e;
+         ++i) {
+        const auto& pair = hexbed::plugins::charsetPluginByIndex(i);
+        encodings.push_back(TextSearchEncoding{
+            pair.first, wxString(pair.second).ToStdString(wxConvUTF8)});
+    }
+    return encodings;
+}
+
 // implement the func needed by common/charconv.cc
 bool isUnicodePrintable(char32_t c) {
 #if HAS_ICU
@@ -24,14 +24,19 @@
 
 #include <wx/string.h>
 
+#include <vector>
+
 #include "common/types.hh"
 #include "file/document.hh"
+#include "file/textsearch.hh"
 
 namespace hexbed {
 
 bool textEncode(const string& encoding, const wxString& text, bufsize& outp,
                 HexBedDocument* doc);
 bool textDecode(const string& encoding, wxString& text, const_bytespan data);
+// every encoding the user can pick, with its localized name
+std::vector<TextSearchEncoding> textEncodings();
 
 // clang-format off
 
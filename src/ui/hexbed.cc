@@ -26,6 +26,7 @@
 #include <wx/tipwin.h>
 #include <wx/wx.h>
 
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
 #include <thread>
@@ -33,9 +34,12 @@
 #include "app/bitop.hh"
 #include "app/config.hh"
 #include "common/buffer.hh"
+#include "common/hexconv.hh"
 #include "common/logger.hh"
 #include "common/random.hh"
 #include "common/version.hh"
+#include "file/bmulti.hh"
+#include "file/bstream.hh"
 #include "file/document.hh"
 #include "file/task.hh"
 #include "plugins/export.hh"
@@ -46,7 +50,12 @@
 #include "ui/dialogs/bitopbinary.hh"
 #include "ui/dialogs/bitopshift.hh"
 #include "ui/dialogs/bitopunary.hh"
+#include "ui/dialogs/fillpattern.hh"
 #include "ui/dialogs/find.hh"
+#include "ui/dialogs/findbits.hh"
+#include "ui/dialogs/findsimilar.hh"
+#include "ui/dialogs/findtext.hh"
+#include "ui/dialogs/findvalues.hh"
 #include "ui/dialogs/goto.hh"
 #include "ui/dialogs/insert.hh"
 #include "ui/dialogs/random.hh"
@@ -70,6 +79,11 @@ static AppLock* lock;
 namespace ui {
 
 static constexpr int tabContainerID = 0x80;
+// the time spent per match index refresh tick and the interval between the
+// ticks; like find all, the refresh runs in slices on the UI thread. so do
+// incremental searches that found nothing near the selection
+static constexpr auto MATCH_INDEX_TICK = std::chrono::milliseconds(20);
+static constexpr int MATCH_INDEX_INTERVAL = 30;
 
 class HexBedWxApp : public wxApp {
   public:
@@ -90,9 +104,14 @@ wxBEGIN_EVENT_TABLE(HexBedMainFrame, wxFrame)
     EVT_MENU(wxID_SAVE, HexBedMainFrame::OnFileSave)
     EVT_MENU(wxID_SAVEAS, HexBedMainFrame::OnFileSaveAs)
     EVT_MENU(wxID_CLOSE, HexBedMainFrame::OnFileClose)
+    EVT_MENU(hexbed::menu::MenuFile_OpenSplit,
+             HexBedMainFrame::OnFileOpenSplit)
     EVT_MENU(hexbed::menu::MenuFile_SaveAll, HexBedMainFrame::OnFileSaveAll)
     EVT_MENU(hexbed::menu::MenuFile_CloseAll, HexBedMainFrame::OnFileCloseAll)
     EVT_MENU(hexbed::menu::MenuFile_Reload, HexBedMainFrame::OnFileReload)
+    EVT_MENU(hexbed::menu::MenuFile_Follow, HexBedMainFrame::OnFileFollow)
+    EVT_MENU(hexbed::menu::MenuFile_FollowScroll,
+             HexBedMainFrame::OnFileFollowScroll)
 
     EVT_MENU(wxID_UNDO, HexBedMainFrame::OnEditUndo)
     EVT_MENU(wxID_REDO, HexBedMainFrame::OnEditRedo)
@@ -111,6 +130,12 @@ wxBEGIN_EVENT_TABLE(HexBedMainFrame, wxFrame)
              HexBedMainFrame::OnEditInsertOrReplace)
     EVT_MENU(hexbed::menu::MenuEdit_InsertRandom,
               HexBedMainFrame::OnEditInsertRandom)
+    EVT_MENU(hexbed::menu::MenuEdit_InsertFile,
+             HexBedMainFrame::OnEditInsertFile)
+    EVT_MENU(hexbed::menu::MenuEdit_MoveBlock,
+             HexBedMainFrame::OnEditMoveBlock)
+    EVT_MENU(hexbed::menu::MenuEdit_DuplicateBlock,
+             HexBedMainFrame::OnEditDuplicateBlock)
     EVT_MENU(hexbed::menu::MenuEdit_BitwiseBinaryOp,
              HexBedMainFrame::OnEditBitwiseBinaryOp)
     EVT_MENU(hexbed::menu::MenuEdit_BitwiseUnaryOp,
@@ -134,6 +159,26 @@ wxBEGIN_EVENT_TABLE(HexBedMainFrame, wxFrame)
     EVT_MENU(hexbed::menu::MenuSearch_FindPrevious,
              HexBedMainFrame::OnSearchFindPrevious)
     EVT_MENU(wxID_REPLACE, HexBedMainFrame::OnSearchReplace)
+    EVT_MENU(hexbed::menu::MenuSearch_FindSignatures,
+             HexBedMainFrame::OnSearchFindSignatures)
+    EVT_MENU(hexbed::menu::MenuSearch_FindValues,
+             HexBedMainFrame::OnSearchFindValues)
+    EVT_MENU(hexbed::menu::MenuSearch_FindSimilar,
+             HexBedMainFrame::OnSearchFindSimilar)
+    EVT_MENU(hexbed::menu::MenuSearch_FindText,
+             HexBedMainFrame::OnSearchFindText)
+    EVT_MENU(hexbed::menu::MenuSearch_FindBits,
+             HexBedMainFrame::OnSearchFindBits)
+    EVT_MENU(hexbed::menu::MenuSearch_SetFill,
+             HexBedMainFrame::OnSearchSetFill)
+    EVT_MENU(hexbed::menu::MenuSearch_NextNotFill,
+             HexBedMainFrame::OnSearchNextNotFill)
+    EVT_MENU(hexbed::menu::MenuSearch_NextFillRun,
+             HexBedMainFrame::OnSearchNextFillRun)
+    EVT_MENU(hexbed::menu::MenuSearch_ListDataRegions,
+             HexBedMainFrame::OnSearchListDataRegions)
+    EVT_MENU(hexbed::menu::MenuSearch_FindInFiles,
+             HexBedMainFrame::OnSearchFindInFiles)
     EVT_MENU(hexbed::menu::MenuSearch_GoTo, HexBedMainFrame::OnSearchGoTo)
 
     EVT_MENU(hexbed::menu::MenuView_ShowColumnsBoth,
@@ -178,18 +223,6 @@ const strchar* getCharPtr(const T&);
 
 // clang-format on
 
-static wxString pathToWxString(const std::filesystem::path& p) {
-    if constexpr (std::is_same_v<strchar, wchar_t>)
-        return wxString(p.native());
-    else
-#if defined(__unix__) || defined(__unix)
-        return wxString::FromUTF8(
-            reinterpret_cast<const char*>(p.u8string().data()));
-#else
-        return wxString::FromUTF8(p.native());
-#endif
-}
-
 template <>
 const strchar* getCharPtr<strchar*>(strchar* const& ptr) {
     return ptr;
@@ -248,7 +281,10 @@ bool HexBedWxApp::OnInit() {
     LOG_ADD_HANDLER(StdLogHandler, LogLevel::TRACE);
 #endif
     lock = new AppLock([this](const wxString& pass) { this->Knock(pass); });
-    if (!lock->acquire(fn)) {
+    if (isStdinPath(pathFromWxString(fn))) {
+        // only this process can read our standard input
+        lock->acquireIfFree();
+    } else if (!lock->acquire(fn)) {
         LOG_DEBUG("lock taken; knocking existing impl");
         return false;
     }
@@ -335,7 +371,9 @@ static int addExportPlugins(HexBedMainFrame* main, wxMenu* menu, int n) {
 }
 
 HexBedMainFrame::HexBedMainFrame()
-    : wxFrame(NULL, wxID_ANY, "HexBed", wxDefaultPosition, wxDefaultSize) {
+    : wxFrame(NULL, wxID_ANY, "HexBed", wxDefaultPosition, wxDefaultSize),
+      matchIndexTimer_(this, wxID_ANY),
+      incrementalTimer_(this, wxID_ANY) {
     tabs_ = new wxAuiNotebook(this, tabContainerID);
     context_ = std::make_shared<HexBedContextMain>(this);
     wxMenuBar* menuBar = new wxMenuBar;
@@ -399,6 +437,10 @@ HexBedMainFrame::HexBedMainFrame()
     binaryOpDocument_ = std::make_shared<HexBedDocument>(context_);
     textConvDocument_ = std::make_shared<HexBedDocument>(context_);
     menuBar->Check(hexbed::menu::MenuEdit_InsertMode, context_->state.insert);
+    Bind(wxEVT_TIMER, &HexBedMainFrame::OnMatchIndexTimer, this,
+         matchIndexTimer_.GetId());
+    Bind(wxEVT_TIMER, &HexBedMainFrame::OnIncrementalTimer, this,
+         incrementalTimer_.GetId());
 }
 
 hexbed::ui::HexBedEditor* HexBedMainFrame::GetEditor() {
@@ -469,9 +511,19 @@ bool HexBedMainFrame::FileSave(std::size_t i, bool saveAs) {
                     tabs_->SetPageText(i, pathToWxString(sfn.filename()));
                 } catch (...) {
                 }
-            } else
+            } else {
+                // a copy on the clipboard would keep the file from being
+                // saved in place
+                hexbed::clip::ReleaseCopy(document);
                 document.commit();
+            }
             editor->ReloadFile();
+            if (editor->IsFollowing()) {
+                // the saved file may be a new one, so watch it afresh
+                bool toEnd = editor->IsFollowingToEnd();
+                editor->SetFollow(false, toEnd);
+                editor->SetFollow(true, toEnd);
+            }
         } catch (...) {
             try {
                 wxMessageBox(wxString::Format(
@@ -569,6 +621,7 @@ bool HexBedMainFrame::FileClose(std::size_t i) {
                 return false;
             };
         }
+        hexbed::clip::ReleaseCopy(editor->document());
     }
     return true;
 }
@@ -690,6 +743,15 @@ void HexBedMainFrame::UpdateMenuEnabled(hexbed::ui::HexEditorParent& ed) {
     bool writable = !ed.document().readOnly();
     mbar.Enable(hexbed::menu::MenuEdit_InsertOrReplace, writable);
     mbar.Enable(hexbed::menu::MenuEdit_InsertRandom, writable);
+    mbar.Enable(hexbed::menu::MenuEdit_InsertFile, writable);
+    mbar.Enable(hexbed::menu::MenuEdit_MoveBlock, writable);
+    mbar.Enable(hexbed::menu::MenuEdit_DuplicateBlock, writable);
+    if (!ed.IsSubView()) {
+        auto& editor = static_cast<hexbed::ui::HexBedEditor&>(ed);
+        mbar.Check(hexbed::menu::MenuFile_Follow, editor.IsFollowing());
+        mbar.Check(hexbed::menu::MenuFile_FollowScroll,
+                   editor.IsFollowingToEnd());
+    }
     if (findDialog_) findDialog_->AllowReplace(writable);
     UpdateMenuEnabledSelect(ed);
     OnEditorCopy(ed);
@@ -772,14 +834,46 @@ void HexBedMainFrame::OnFileNew(wxCommandEvent& event) { FileNew(); }
 
 void HexBedMainFrame::FileKnock(const wxString& fp, bool readOnly) {
     try {
-        auto editor = MakeEditor(pathFromWxString(fp), readOnly);
+        std::filesystem::path fn = pathFromWxString(fp);
+        auto editor = MakeEditor(fn, readOnly);
+        bool growing = editor->document().growing();
+        hexbed::ui::HexBedEditor* ed = editor.get();
+        if (isStdinPath(fn)) {
+            AddTab(std::move(editor), _("(standard input)"),
+                   _("(standard input)"));
+        } else {
+            std::filesystem::path path =
+                std::filesystem::canonical(editor->document().path());
+            AddTab(std::move(editor), pathToWxString(path.filename()),
+                   pathToWxString(path));
+        }
+        if (growing) ed->SetFollow(true, false);
+    } catch (...) {
+        try {
+            wxMessageBox(wxString::Format(_("Failed to open file %s: %s"), fp,
+                                          currentExceptionAsString()),
+                         "HexBed", wxOK | wxICON_ERROR);
+        } catch (...) {
+        }
+    }
+}
+
+void HexBedMainFrame::FileKnockParts(
+    const std::vector<std::filesystem::path>& parts, bool readOnly) {
+    if (parts.empty()) return;
+    try {
+        auto editor = MakeEditor(parts, readOnly);
         std::filesystem::path path =
             std::filesystem::canonical(editor->document().path());
-        AddTab(std::move(editor), pathToWxString(path.filename()),
+        unsigned long long more = parts.size() - 1;
+        AddTab(std::move(editor),
+               wxString::Format(_("%s (+%llu)"),
+                                pathToWxString(path.filename()), more),
                pathToWxString(path));
     } catch (...) {
         try {
-            wxMessageBox(wxString::Format(_("Failed to open file %s: %s"), fp,
+            wxMessageBox(wxString::Format(_("Failed to open file %s: %s"),
+                                          pathToWxString(parts.front()),
                                           currentExceptionAsString()),
                          "HexBed", wxOK | wxICON_ERROR);
         } catch (...) {
@@ -815,6 +909,27 @@ void HexBedMainFrame::OnFindClose(wxCloseEvent& event) {
     findDialog_ = nullptr;
 }
 
+void HexBedMainFrame::OnFindInFilesClose(wxCloseEvent& event) {
+    findInFilesTool_->Destroy();
+    findInFilesTool_ = nullptr;
+}
+
+FindAllTool& HexBedMainFrame::EnsureFindAllTool() {
+    if (!findAllTool_) {
+        findAllTool_ = std::make_unique<FindAllTool>(this, context_);
+        findAllTool_->Bind(wxEVT_CLOSE_WINDOW,
+                           &HexBedMainFrame::OnFindAllClose, this);
+    }
+    findAllTool_->Show(true);
+    findAllTool_->Raise();
+    return *findAllTool_;
+}
+
+void HexBedMainFrame::OnFindAllClose(wxCloseEvent& event) {
+    findAllTool_->Destroy();
+    findAllTool_ = nullptr;
+}
+
 void HexBedMainFrame::OnBitEditorClose(wxCloseEvent& event) {
     bitEditorTool_->Destroy();
     bitEditorTool_ = nullptr;
@@ -879,6 +994,280 @@ bool HexBedMainFrame::DoFindPrevious() {
     }
 }
 
+void HexBedMainFrame::DoFindIncremental(bool partial) {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (!ed) return;
+    incremental_.partial = partial;
+    if (!hexbed::ui::FindDialog::findIncremental(ed, incremental_) &&
+        !incremental_.pending)
+        wxBell();
+    if (incremental_.pending)
+        incrementalTimer_.Start(MATCH_INDEX_INTERVAL);
+    else
+        incrementalTimer_.Stop();
+}
+
+void HexBedMainFrame::OnIncrementalTimer(wxTimerEvent& event) {
+    if (context_->taskRunning()) return;
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    SearchResult res{};
+    if (ed) {
+        auto deadline = std::chrono::steady_clock::now() + MATCH_INDEX_TICK;
+        HexBedTask task(context_.get(), 0, false);
+        do {
+            res = hexbed::ui::FindDialog::findIncrementalSlice(ed, task,
+                                                               incremental_);
+        } while (incremental_.pending &&
+                 std::chrono::steady_clock::now() < deadline);
+    } else {
+        incremental_.pending = false;
+    }
+    if (incremental_.pending) return;
+    incrementalTimer_.Stop();
+    if (!res) wxBell();
+}
+
+void HexBedMainFrame::RefreshMatchIndexesLater() {
+    if (!matchIndexTimer_.IsRunning())
+        matchIndexTimer_.Start(MATCH_INDEX_INTERVAL);
+}
+
+void HexBedMainFrame::OnMatchIndexTimer(wxTimerEvent& event) {
+    if (context_->taskRunning()) return;
+    auto deadline = std::chrono::steady_clock::now() + MATCH_INDEX_TICK;
+    HexBedTask task(context_.get(), 0, true);
+    bool more;
+    do {
+        more = context_->refreshMatchIndexes(task);
+    } while (more && std::chrono::steady_clock::now() < deadline);
+    if (!more) matchIndexTimer_.Stop();
+}
+
+void HexBedMainFrame::OnSearchFindSignatures(wxCommandEvent& event) {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (!ed) return;
+    wxFileDialog dial(this, _("Open a pattern file"), "", "",
+                      _("Text files (*.txt)") + "|*.txt|" +
+                          _("All files (*.*)") + "|*",
+                      wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+    if (dial.ShowModal() == wxID_CANCEL) return;
+    std::shared_ptr<MultiPattern> patterns;
+    try {
+        patterns = std::make_shared<MultiPattern>(
+            MultiPattern::load(pathFromWxString(dial.GetPath())));
+    } catch (...) {
+        try {
+            wxMessageBox(wxString::Format(_("Could not load patterns: %s"),
+                                          currentExceptionAsString()),
+                         "HexBed", wxOK | wxICON_ERROR);
+        } catch (...) {
+        }
+        return;
+    }
+    EnsureFindAllTool().Start(ed->copyDocument(), std::move(patterns));
+}
+
+void HexBedMainFrame::OnSearchFindValues(wxCommandEvent& event) {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (!ed) return;
+    FindValuesDialog dial(this);
+    if (dial.ShowModal() != wxID_OK) return;
+    EnsureFindAllTool().Start(ed->copyDocument(), dial.GetQuery());
+}
+
+void HexBedMainFrame::OnSearchFindSimilar(wxCommandEvent& event) {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (!ed) return;
+    bufsize sel, seln;
+    bool seltext;
+    ed->GetSelection(sel, seln, seltext);
+    byte buf[ApproximatePattern::MAXIMUM_LENGTH];
+    bufsize n = ed->document().read(
+        sel, bytespan(buf, std::min<bufsize>(seln, sizeof(buf))));
+    FindSimilarDialog dial(this, hexFromBytes(n, buf, config().uppercase));
+    if (dial.ShowModal() != wxID_OK) return;
+    EnsureFindAllTool().Start(ed->copyDocument(), dial.GetPattern());
+}
+
+void HexBedMainFrame::OnSearchFindText(wxCommandEvent& event) {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (!ed) return;
+    FindTextDialog dial(this);
+    if (dial.ShowModal() != wxID_OK) return;
+    EnsureFindAllTool().Start(ed->copyDocument(), dial.GetPatterns());
+}
+
+void HexBedMainFrame::OnSearchFindBits(wxCommandEvent& event) {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (!ed) return;
+    bufsize sel, seln;
+    bool seltext;
+    ed->GetSelection(sel, seln, seltext);
+    byte buf[8];
+    bufsize n = ed->document().read(
+        sel, bytespan(buf, std::min<bufsize>(seln, sizeof(buf))));
+    string initial;
+    for (bufsize i = 0; i < n; ++i) {
+        if (i) initial += ' ';
+        for (int j = 7; j >= 0; --j) initial += (buf[i] >> j) & 1 ? '1' : '0';
+    }
+    FindBitsDialog dial(this, initial);
+    if (dial.ShowModal() != wxID_OK) return;
+    DoFindAllBits(dial.GetPattern());
+}
+
+void HexBedMainFrame::DoFindAllBits(
+    std::shared_ptr<const BitPattern> pattern) {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (!ed) return;
+    EnsureFindAllTool().Start(ed->copyDocument(), pattern);
+}
+
+bool HexBedMainFrame::AskFillPattern() {
+    EditorState& state = context_->state;
+    byte zero = 0;
+    const_bytespan fill =
+        state.skipFill ? state.skipFill->bytes() : const_bytespan(&zero, 1);
+    FillPatternDialog dial(
+        this, hexFromBytes(fill.size(), fill.data(), config().uppercase),
+        state.skipFillMinimum);
+    if (dial.ShowModal() != wxID_OK) return false;
+    state.skipFill = dial.GetPattern();
+    state.skipFillMinimum = dial.GetMinimum();
+    return true;
+}
+
+void HexBedMainFrame::OnSearchSetFill(wxCommandEvent& event) {
+    AskFillPattern();
+}
+
+void HexBedMainFrame::OnSearchNextNotFill(wxCommandEvent& event) {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (!ed || (!context_->state.skipFill && !AskFillPattern())) return;
+    const EditorState& state = context_->state;
+    HexBedDocument& doc = ed->document();
+    bufsize sel, seln, end = doc.size();
+    bool seltext;
+    ed->GetSelection(sel, seln, seltext);
+    SearchResult res{};
+    HexBedTask task(context_.get(), 0, true);
+    task.run([&](HexBedTask& task) {
+        res = searchForwardNotFill(task, doc, sel + seln, end,
+                                   *state.skipFill);
+        if (!res) return;
+        // the data goes on until the next run long enough to be padding
+        SearchResult pad =
+            searchForwardFillRun(task, doc, res.offset, end,
+                                 *state.skipFill, state.skipFillMinimum);
+        res.length = (pad ? pad.offset : end) - res.offset;
+    });
+    if (task.isCancelled()) return;
+    if (!res) {
+        NoMoreResults();
+        return;
+    }
+    ed->SelectBytes(res.offset, res.length,
+                    SelectFlags().caretAtEnd().highlightBeginning());
+}
+
+void HexBedMainFrame::OnSearchNextFillRun(wxCommandEvent& event) {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (!ed || (!context_->state.skipFill && !AskFillPattern())) return;
+    const EditorState& state = context_->state;
+    HexBedDocument& doc = ed->document();
+    bufsize sel, seln;
+    bool seltext;
+    ed->GetSelection(sel, seln, seltext);
+    SearchResult res{};
+    HexBedTask task(context_.get(), 0, true);
+    task.run([&](HexBedTask& task) {
+        res = searchForwardFillRun(task, doc, sel + seln, doc.size(),
+                                   *state.skipFill, state.skipFillMinimum);
+    });
+    if (task.isCancelled()) return;
+    if (!res) {
+        NoMoreResults();
+        return;
+    }
+    ed->SelectBytes(res.offset, res.length,
+                    SelectFlags().caretAtEnd().highlightBeginning());
+}
+
+void HexBedMainFrame::OnSearchListDataRegions(wxCommandEvent& event) {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (!ed || (!context_->state.skipFill && !AskFillPattern())) return;
+    EnsureFindAllTool().Start(ed->copyDocument(), context_->state.skipFill,
+                              context_->state.skipFillMinimum);
+}
+
+void HexBedMainFrame::OnSearchFindInFiles(wxCommandEvent& event) {
+    if (!findInFilesTool_) {
+        findInFilesTool_ = std::make_unique<FindInFilesTool>(this);
+        findInFilesTool_->Bind(wxEVT_CLOSE_WINDOW,
+                               &HexBedMainFrame::OnFindInFilesClose, this);
+    }
+    findInFilesTool_->Show(true);
+    findInFilesTool_->Raise();
+}
+
+void HexBedMainFrame::DoFindAll() {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (!ed) return;
+    if (findDialog_) findDialog_->Recommit();
+    if (context_->state.searchFindText &&
+        context_->state.searchFindTextCaseInsensitive) {
+        wxMessageBox(_("Find all does not support case-insensitive search."),
+                     "HexBed", wxOK | wxICON_INFORMATION);
+        return;
+    }
+    if (context_->state.searchFindMasked || context_->state.searchFindRegex) {
+        wxMessageBox(_("Find all does not support hex patterns or regular "
+                       "expressions."),
+                     "HexBed", wxOK | wxICON_INFORMATION);
+        return;
+    }
+    const_bytespan search = context_->getSearchString();
+    if (search.empty()) return;
+    EnsureFindAllTool().Start(ed->copyDocument(), search);
+}
+
+bool HexBedMainFrame::ShowDocumentRange(HexBedDocument* document,
+                                        bufoffset offset, bufsize length) {
+    for (std::size_t i = 0, e = tabs_->GetPageCount(); i < e; ++i) {
+        hexbed::ui::HexBedEditor* ed = GetEditor(i);
+        if (&ed->document() != document) continue;
+        tabs_->SetSelection(i);
+        ed->SelectBytes(offset, length,
+                        SelectFlags().caretAtEnd().highlightBeginning());
+        return true;
+    }
+    return false;
+}
+
+void HexBedMainFrame::ShowFileRange(const std::filesystem::path& path,
+                                    bufoffset offset, bufsize length) {
+    hexbed::ui::HexBedEditor* found = nullptr;
+    std::size_t i = 0, e = tabs_->GetPageCount();
+    for (; i < e; ++i) {
+        hexbed::ui::HexBedEditor* ed = GetEditor(i);
+        std::error_code ec;
+        if (ed->document().path().empty() ||
+            !std::filesystem::equivalent(ed->document().path(), path, ec))
+            continue;
+        tabs_->SetSelection(i);
+        found = ed;
+        break;
+    }
+    if (!found) {
+        FileKnock(pathToWxString(path), false);
+        if (tabs_->GetPageCount() == e) return;
+        found = GetEditor();
+    }
+    if (found)
+        found->SelectBytes(offset, length,
+                           SelectFlags().caretAtEnd().highlightBeginning());
+}
+
 void HexBedMainFrame::OnCaretMoved(hexbed::ui::HexEditorParent& editor) {
     hexbed::ui::HexBedEditor* ed = GetEditor();
     if (!ed)
@@ -905,12 +1294,16 @@ void HexBedMainFrame::OnSearchFind(wxCommandEvent& event) {
 }
 
 void HexBedMainFrame::OnSearchFindNext(wxCommandEvent& event) {
-    if (!searchDocument_->size()) return OnSearchFind(event);
+    if (!searchDocument_->size() && !context_->state.searchFindMasked &&
+        !context_->state.searchFindRegex)
+        return OnSearchFind(event);
     DoFindNext();
 }
 
 void HexBedMainFrame::OnSearchFindPrevious(wxCommandEvent& event) {
-    if (!searchDocument_->size()) return OnSearchFind(event);
+    if (!searchDocument_->size() && !context_->state.searchFindMasked &&
+        !context_->state.searchFindRegex)
+        return OnSearchFind(event);
     DoFindPrevious();
 }
 
@@ -994,6 +1387,87 @@ void HexBedMainFrame::OnEditInsertRandom(wxCommandEvent& event) {
     }
 }
 
+void HexBedMainFrame::OnEditInsertFile(wxCommandEvent& event) {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (!ed) return;
+    bufsize sel, seln;
+    bool seltext;
+    ed->GetSelection(sel, seln, seltext);
+    wxFileDialog dial(this, _("Insert a file"), "", "",
+                      _("All files (*.*)") + "|*",
+                      wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+    if (dial.ShowModal() == wxID_CANCEL) return;
+    try {
+        // the file is referenced rather than copied into memory
+        HexBedDocument& document = ed->document();
+        bufsize z = document.size();
+        if (document.insertFile(sel, seln,
+                                pathFromWxString(dial.GetPath())))
+            ed->SelectBytes(sel, document.size() + seln - z,
+                            SelectFlags().caretAtBeginning().highlightCaret());
+    } catch (...) {
+        try {
+            wxMessageBox(wxString::Format(_("Insert failed: %s"),
+                                          currentExceptionAsString()),
+                         "HexBed", wxOK | wxICON_ERROR);
+        } catch (...) {
+        }
+    }
+}
+
+void HexBedMainFrame::OnEditMoveBlock(wxCommandEvent& event) {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (!ed) return;
+    bufsize sel, seln;
+    bool seltext;
+    ed->GetSelection(sel, seln, seltext);
+    if (!seln) return;
+    GoToDialog g(this, sel, ed->document().size(), _("Move to"));
+    if (g.ShowModal() != wxID_OK) return;
+    bufsize o = g.GetOffset();
+    if (o > sel && o < sel + seln) {
+        wxMessageBox(_("Cannot move a block into itself."), "HexBed",
+                     wxOK | wxICON_ERROR);
+        return;
+    }
+    try {
+        if (ed->document().move(sel, seln, o))
+            ed->SelectBytes(o > sel ? o - seln : o, seln,
+                            SelectFlags().caretAtBeginning().highlightCaret());
+    } catch (...) {
+        try {
+            wxMessageBox(wxString::Format(_("Move failed: %s"),
+                                          currentExceptionAsString()),
+                         "HexBed", wxOK | wxICON_ERROR);
+        } catch (...) {
+        }
+    }
+}
+
+void HexBedMainFrame::OnEditDuplicateBlock(wxCommandEvent& event) {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (!ed) return;
+    bufsize sel, seln;
+    bool seltext;
+    ed->GetSelection(sel, seln, seltext);
+    if (!seln) return;
+    GoToDialog g(this, sel + seln, ed->document().size(), _("Copy to"));
+    if (g.ShowModal() != wxID_OK) return;
+    bufsize o = g.GetOffset();
+    try {
+        if (ed->document().duplicate(sel, seln, o))
+            ed->SelectBytes(o, seln,
+                            SelectFlags().caretAtBeginning().highlightCaret());
+    } catch (...) {
+        try {
+            wxMessageBox(wxString::Format(_("Copy failed: %s"),
+                                          currentExceptionAsString()),
+                         "HexBed", wxOK | wxICON_ERROR);
+        } catch (...) {
+        }
+    }
+}
+
 void HexBedMainFrame::OnEditBitwiseBinaryOp(wxCommandEvent& event) {
     hexbed::ui::HexBedEditor* ed = GetEditor();
     bufsize sel, seln;
@@ -1291,6 +1765,33 @@ void HexBedMainFrame::OnFileOpen(wxCommandEvent& event) {
     for (const wxString& file : files) FileKnock(file, readOnly);
 }
 
+void HexBedMainFrame::OnFileOpenSplit(wxCommandEvent& event) {
+    wxFileDialog dial(this, _("Open a split file"), "", "",
+                      _("All files (*.*)") + "|*",
+                      wxFD_OPEN | wxFD_FILE_MUST_EXIST | wxFD_MULTIPLE);
+    dial.SetExtraControlCreator(&MakeCheckBoxWindow);
+    if (dial.ShowModal() == wxID_CANCEL) return;
+    bool readOnly = false;
+    wxArrayString files;
+    dial.GetPaths(files);
+    wxWindow* check = dial.GetExtraControl();
+    if (check) readOnly = dynamic_cast<wxCheckBox*>(check)->GetValue();
+    std::vector<std::filesystem::path> parts;
+    if (files.size() == 1) {
+        // pick up name.002, name.003, ... automatically
+        parts = findSplitParts(pathFromWxString(files[0]));
+        if (parts.empty()) {
+            FileKnock(files[0], readOnly);
+            return;
+        }
+    } else {
+        for (const wxString& file : files)
+            parts.push_back(pathFromWxString(file));
+        std::sort(parts.begin(), parts.end());
+    }
+    FileKnockParts(parts, readOnly);
+}
+
 void HexBedMainFrame::OnFileSave(wxCommandEvent& event) {
     if (tabs_->GetCurrentPage()) FileSave(tabs_->GetSelection(), false);
 }
@@ -1318,6 +1819,19 @@ void HexBedMainFrame::OnFileReload(wxCommandEvent& event) {
     if (tabs_->GetCurrentPage()) FileReload(tabs_->GetSelection());
 }
 
+void HexBedMainFrame::OnFileFollow(wxCommandEvent& event) {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (ed) {
+        ed->SetFollow(event.IsChecked(), ed->IsFollowingToEnd());
+        GetMenuBar()->Check(hexbed::menu::MenuFile_Follow, ed->IsFollowing());
+    }
+}
+
+void HexBedMainFrame::OnFileFollowScroll(wxCommandEvent& event) {
+    hexbed::ui::HexBedEditor* ed = GetEditor();
+    if (ed) ed->SetFollow(ed->IsFollowing(), event.IsChecked());
+}
+
 void HexBedMainFrame::OnFileCloseAll(wxCommandEvent& event) { FileCloseAll(); }
 
 void HexBedMainFrame::OnFileMenuImport(wxCommandEvent& event) {
@@ -27,8 +27,10 @@
 #include <wx/frame.h>
 #include <wx/menu.h>
 #include <wx/statusbr.h>
+#include <wx/timer.h>
 #include <wx/toolbar.h>
 
+#include <filesystem>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -39,6 +41,8 @@
 #include "ui/editor-fwd.hh"
 #include "ui/menus.hh"
 #include "ui/tools/bitedit.hh"
+#include "ui/tools/findall.hh"
+#include "ui/tools/findfiles.hh"
 #include "ui/tools/inspector.hh"
 #include "ui/tools/textconv.hh"
 
@@ -51,6 +55,8 @@ class HexBedMainFrame : public wxFrame {
     HexBedMainFrame();
 
     void FileKnock(const wxString& s, bool readOnly);
+    void FileKnockParts(const std::vector<std::filesystem::path>& parts,
+                        bool readOnly);
     void ApplyConfig();
 
     void UpdateMenuEnabled(hexbed::ui::HexEditorParent& editor);
@@ -62,6 +68,14 @@ class HexBedMainFrame : public wxFrame {
     hexbed::ui::HexEditorParent* GetCurrentEditor();
     bool DoFindNext();
     bool DoFindPrevious();
+    void RefreshMatchIndexesLater();
+    void DoFindIncremental(bool partial);
+    void DoFindAll();
+    void DoFindAllBits(std::shared_ptr<const BitPattern> pattern);
+    bool ShowDocumentRange(HexBedDocument* document, bufoffset offset,
+                           bufsize length);
+    void ShowFileRange(const std::filesystem::path& path, bufoffset offset,
+                       bufsize length);
     void OnReplaceDone(bufsize count);
     void OnActiveEditorResize();
     wxMenu* GetEditorContextMenu();
@@ -80,12 +94,15 @@ class HexBedMainFrame : public wxFrame {
 
     void OnFileNew(wxCommandEvent& event);
     void OnFileOpen(wxCommandEvent& event);
+    void OnFileOpenSplit(wxCommandEvent& event);
     void OnFileSave(wxCommandEvent& event);
     void OnFileSaveAs(wxCommandEvent& event);
     void OnFileClose(wxCommandEvent& event);
     void OnFileSaveAll(wxCommandEvent& event);
     void OnFileCloseAll(wxCommandEvent& event);
     void OnFileReload(wxCommandEvent& event);
+    void OnFileFollow(wxCommandEvent& event);
+    void OnFileFollowScroll(wxCommandEvent& event);
     void OnFileMenuImport(wxCommandEvent& event);
     void OnFileMenuExport(wxCommandEvent& event);
 
@@ -102,6 +119,9 @@ class HexBedMainFrame : public wxFrame {
     void OnEditInsertToggle(wxCommandEvent& event);
     void OnEditInsertOrReplace(wxCommandEvent& event);
     void OnEditInsertRandom(wxCommandEvent& event);
+    void OnEditInsertFile(wxCommandEvent& event);
+    void OnEditMoveBlock(wxCommandEvent& event);
+    void OnEditDuplicateBlock(wxCommandEvent& event);
     void OnEditBitwiseBinaryOp(wxCommandEvent& event);
     void OnEditBitwiseUnaryOp(wxCommandEvent& event);
     void OnEditBitwiseShiftOp(wxCommandEvent& event);
@@ -116,6 +136,17 @@ class HexBedMainFrame : public wxFrame {
     void OnSearchFindNext(wxCommandEvent& event);
     void OnSearchFindPrevious(wxCommandEvent& event);
     void OnSearchReplace(wxCommandEvent& event);
+    void OnSearchFindSignatures(wxCommandEvent& event);
+    void OnSearchFindValues(wxCommandEvent& event);
+    void OnSearchFindSimilar(wxCommandEvent& event);
+    void OnSearchFindText(wxCommandEvent& event);
+    void OnSearchFindBits(wxCommandEvent& event);
+    void OnSearchSetFill(wxCommandEvent& event);
+    void OnSearchNextNotFill(wxCommandEvent& event);
+    void OnSearchNextFillRun(wxCommandEvent& event);
+    void OnSearchListDataRegions(wxCommandEvent& event);
+    void OnSearchFindInFiles(wxCommandEvent& event);
+    bool AskFillPattern();
     void OnSearchGoTo(wxCommandEvent& event);
 
     void OnViewColumnsBoth(wxCommandEvent& event);
@@ -136,8 +167,13 @@ class HexBedMainFrame : public wxFrame {
     void OnViewNewSubView(wxCommandEvent& event);
 
     void UpdateMenuEnabledSelect(hexbed::ui::HexEditorParent& editor);
+    FindAllTool& EnsureFindAllTool();
+    void OnMatchIndexTimer(wxTimerEvent& event);
+    void OnIncrementalTimer(wxTimerEvent& event);
 
     void OnFindClose(wxCloseEvent& event);
+    void OnFindAllClose(wxCloseEvent& event);
+    void OnFindInFilesClose(wxCloseEvent& event);
     void OnBitEditorClose(wxCloseEvent& event);
     void OnDataInspectorClose(wxCloseEvent& event);
     void OnTextConverterClose(wxCloseEvent& event);
@@ -174,11 +210,16 @@ class HexBedMainFrame : public wxFrame {
     std::shared_ptr<HexBedDocument> binaryOpDocument_;
     std::shared_ptr<HexBedDocument> textConvDocument_;
     std::unique_ptr<FindDialog> findDialog_;
+    std::unique_ptr<FindAllTool> findAllTool_;
+    std::unique_ptr<FindInFilesTool> findInFilesTool_;
     std::unique_ptr<BitEditorTool> bitEditorTool_;
     std::unique_ptr<DataInspector> dataInspector_;
     std::unique_ptr<TextConverterTool> textConverter_;
     hexbed::menu::MenuIds menuIds_;
     std::unique_ptr<wxMenu> editContextMenu_;
+    wxTimer matchIndexTimer_;
+    wxTimer incrementalTimer_;
+    IncrementalSearch incremental_;
 };
 
 };  // namespace ui
@@ -78,6 +78,8 @@ class HexEditor : public wxWindow {
     void GetSelection(bufsize& start, bufsize& length, bool& text);
     bufsize GetCaretPosition();
     HexBedPeekRegion PeekBufferAtCursor();
+    // whether only the first hex digit of the byte at the caret is typed
+    inline bool IsTypingByte() const noexcept { return curnibble_; }
     void HintByteChanged(bufsize offset);
     void HintBytesChanged(bufsize begin);
     void HintBytesChanged(bufsize begin, bufsize end);
@@ -61,6 +61,15 @@ wxMenu* createEditMenu(wxMenuBar* menuBar, std::vector<wxMenuItem*>& fileOnly,
     fileOnly.push_back(addItem(
         menuEdit, MenuEdit_InsertRandom, _("Insert rando&m..."),
         _("Inserts or replaces the selection with a random block of bytes")));
+    fileOnly.push_back(addItem(
+        menuEdit, MenuEdit_InsertFile, _("Insert &file..."),
+        _("Inserts or replaces the selection with the contents of a file")));
+    fileOnly.push_back(
+        addItem(menuEdit, MenuEdit_MoveBlock, _("Mo&ve selection..."),
+                _("Moves the selected block to another offset")));
+    fileOnly.push_back(addItem(
+        menuEdit, MenuEdit_DuplicateBlock, _("Dup&licate selection..."),
+        _("Inserts a copy of the selected block at another offset")));
     wxMenu* editOps = new wxMenu;
     wxMenu* editSwapOps = new wxMenu;
     fileOnly.push_back(addItem(
@@ -31,6 +31,8 @@ wxMenu* createFileMenu(wxMenuBar* menuBar, std::vector<wxMenuItem*>& fileOnly,
             wxACCEL_CTRL, 'N');
     addItem(menuFile, wxID_OPEN, _("&Open..."), _("Opens an existing file"),
             wxACCEL_CTRL, 'O');
+    addItem(menuFile, MenuFile_OpenSplit, _("Open s&plit file..."),
+            _("Opens several files as one file, joined end to end"));
     fileOnly.push_back(addItem(menuFile, wxID_SAVE, _("&Save"),
                                _("Saves the file in the current location"),
                                wxACCEL_CTRL, 'S'));
@@ -38,6 +40,12 @@ wxMenu* createFileMenu(wxMenuBar* menuBar, std::vector<wxMenuItem*>& fileOnly,
                                _("Saves the file in a new location")));
     fileOnly.push_back(addItem(menuFile, MenuFile_Reload, _("&Reload"),
                                _("Reload the open file and discard changes")));
+    fileOnly.push_back(
+        addCheckItem(menuFile, MenuFile_Follow, _("&Follow changes"),
+                     _("Shows new data appended to the file as it grows")));
+    fileOnly.push_back(addCheckItem(
+        menuFile, MenuFile_FollowScroll, _("Follow &to end"),
+        _("Scrolls to the end of the file when new data is appended")));
     fileOnly.push_back(addItem(menuFile, wxID_CLOSE, _("&Close"),
                                _("Closes the current file"), wxACCEL_CTRL,
                                WXK_F4));
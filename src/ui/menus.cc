@@ -38,6 +38,11 @@ wxMenuItem* addItem(wxMenu* menu, int id, const wxString& text,
     return item;
 }
 
+wxMenuItem* addCheckItem(wxMenu* menu, int id, const wxString& text,
+                         const wxString& tip) {
+    return menu->AppendCheckItem(id, text, tip);
+}
+
 wxMenuItem* addCheckItem(wxMenu* menu, int id, const wxString& text,
                          const wxString& tip, int flags, int keyCode) {
     wxMenuItem* item = menu->AppendCheckItem(id, text, tip);
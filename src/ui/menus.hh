@@ -40,6 +40,9 @@ enum {
     MenuFile_SaveAll = 0x100,
     MenuFile_CloseAll,
     MenuFile_Reload,
+    MenuFile_Follow,
+    MenuFile_FollowScroll,
+    MenuFile_OpenSplit,
 
     MenuEdit_PasteReplace = 0x200,
     MenuEdit_InsertMode,
@@ -55,10 +58,23 @@ enum {
     MenuEdit_ByteSwap16,
     MenuEdit_Reverse,
     MenuEdit_CopyOffset,
+    MenuEdit_InsertFile,
+    MenuEdit_MoveBlock,
+    MenuEdit_DuplicateBlock,
 
     MenuSearch_FindNext = 0x300,
     MenuSearch_FindPrevious,
     MenuSearch_GoTo,
+    MenuSearch_FindSignatures,
+    MenuSearch_FindValues,
+    MenuSearch_FindSimilar,
+    MenuSearch_FindText,
+    MenuSearch_FindBits,
+    MenuSearch_SetFill,
+    MenuSearch_NextNotFill,
+    MenuSearch_NextFillRun,
+    MenuSearch_ListDataRegions,
+    MenuSearch_FindInFiles,
 
     MenuView_ShowColumnsBoth = 0x400,
     MenuView_ShowColumnsHex,
@@ -81,6 +97,8 @@ wxMenuItem* addItem(wxMenu* menu, int id, const wxString& text,
                     const wxString& tip);
 wxMenuItem* addItem(wxMenu* menu, int id, const wxString& text,
                     const wxString& tip, int flags, int keyCode);
+wxMenuItem* addCheckItem(wxMenu* menu, int id, const wxString& text,
+                         const wxString& tip);
 wxMenuItem* addCheckItem(wxMenu* menu, int id, const wxString& text,
                          const wxString& tip, int flags, int keyCode);
 
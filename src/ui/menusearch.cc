@@ -40,6 +40,40 @@ wxMenu* createSearchMenu(wxMenuBar* menuBar, std::vector<wxMenuItem*>& fileOnly,
     fileOnly.push_back(addItem(menuSearch, wxID_REPLACE, _("&Replace..."),
                                _("Finds and replaces data in the file"),
                                wxACCEL_CTRL, 'H'));
+    fileOnly.push_back(addItem(
+        menuSearch, MenuSearch_FindSignatures, _("Find &signatures..."),
+        _("Finds every match for a set of patterns loaded from a file")));
+    fileOnly.push_back(addItem(
+        menuSearch, MenuSearch_FindValues, _("Find &values..."),
+        _("Finds every number of a given type within a range of values")));
+    fileOnly.push_back(addItem(
+        menuSearch, MenuSearch_FindSimilar, _("Find si&milar..."),
+        _("Finds every block that differs from the given bytes by at most "
+          "a few bytes")));
+    fileOnly.push_back(addItem(
+        menuSearch, MenuSearch_FindText, _("Find text in any &encoding..."),
+        _("Finds every match for text in all character encodings at once")));
+    fileOnly.push_back(
+        addItem(menuSearch, MenuSearch_FindBits, _("Find &bits..."),
+                _("Finds every match for a bit string at any bit offset")));
+    menuSearch->AppendSeparator();
+    fileOnly.push_back(addItem(
+        menuSearch, MenuSearch_SetFill, _("Set fill pa&ttern..."),
+        _("Sets the fill bytes that padding is made of")));
+    fileOnly.push_back(addItem(
+        menuSearch, MenuSearch_NextNotFill, _("Skip to next &data"),
+        _("Selects the next region of data that is not fill"), wxACCEL_CTRL,
+        WXK_F3));
+    fileOnly.push_back(addItem(
+        menuSearch, MenuSearch_NextFillRun, _("Skip to next pa&dding"),
+        _("Selects the next run of fill that counts as padding"),
+        wxACCEL_CTRL | wxACCEL_SHIFT, WXK_F3));
+    fileOnly.push_back(addItem(
+        menuSearch, MenuSearch_ListDataRegions, _("&List data regions"),
+        _("Lists every region of the file that is not padding")));
+    menuSearch->AppendSeparator();
+    addItem(menuSearch, MenuSearch_FindInFiles, _("Find in f&iles..."),
+            _("Searches for bytes in every file within a folder"));
     menuSearch->AppendSeparator();
     fileOnly.push_back(addItem(menuSearch, MenuSearch_GoTo, _("&Go to..."),
                                _("Goes to a specific offset in the file"),
@@ -132,6 +132,10 @@ void HexBedStandaloneEditor::Selected() {
 
 void HexBedStandaloneEditor::FocusEditor() { hexEdit_->SetFocus(); }
 
+bool HexBedStandaloneEditor::IsTypingByte() const noexcept {
+    return hexEdit_->IsTypingByte();
+}
+
 void HexBedStandaloneEditor::FileSizeUpdate() {
     fsize_ = document().size();
     frows_ = fsize_ / config().hexColumns + rows_;
@@ -36,6 +36,7 @@ class HexBedStandaloneEditor : public wxPanel, public HexEditorParent {
     inline std::shared_ptr<HexBedDocument> copyDocument() { return document_; }
 
     void Selected();
+    bool IsTypingByte() const noexcept;
 
     void FullUpdate();
     void LayoutUpdate();
@@ -48,6 +48,13 @@ HexBedPrefsGeneral::HexBedPrefsGeneral(wxWindow* parent,
     PREFS_HEADING(col, _("Backup"));
     PREFS_SETTING_BOOL(col, _("Back up files (.bak) before overwriting"),
                        backupFiles);
+    PREFS_HEADING(col, _("Compressed files"));
+    PREFS_SETTING_BOOL(
+        col, _("Open gzip files decompressed (read-only, can be saved as)"),
+        decompressFiles);
+    PREFS_HEADING(col, _("Streamed input"));
+    PREFS_SETTING_INT(col, _("Most data read from a pipe or device (MiB)"),
+                      streamMaximum, 1, std::numeric_limits<int>::max());
     PREFS_FINISHCOLUMN(col);
 }
 
@@ -25,6 +25,7 @@
 #include <wx/string.h>
 
 #include <filesystem>
+#include <type_traits>
 
 #include "common/charconv.hh"
 #include "common/types.hh"
@@ -36,6 +37,18 @@ inline std::u32string u32StringFromWx(const wxString& s) {
     return wstringToU32string(static_cast<std::wstring>(s));
 }
 
+inline wxString pathToWxString(const std::filesystem::path& p) {
+    if constexpr (std::is_same_v<strchar, wchar_t>)
+        return wxString(p.native());
+    else
+#if defined(__unix__) || defined(__unix)
+        return wxString::FromUTF8(
+            reinterpret_cast<const char*>(p.u8string().data()));
+#else
+        return wxString::FromUTF8(p.native());
+#endif
+}
+
 };  // namespace hexbed
 
 #endif /* HEXBED_UI_STRING_HH */
@@ -21,8 +21,13 @@
 
 #include "ui/tools/bitedit.hh"
 
+#include <wx/sizer.h>
+#include <wx/utils.h>
+
 #include "app/config.hh"
 #include "common/hexconv.hh"
+#include "file/document.hh"
+#include "ui/dialogs/findbits.hh"
 #include "ui/hexbed.hh"
 
 namespace hexbed {
@@ -35,7 +40,10 @@ BitEditorTool::BitEditorTool(HexBedMainFrame* parent,
                              std::shared_ptr<HexBedContextMain> context)
     : wxDialog(parent, wxID_ANY, _("Bit editor"), wxDefaultPosition,
                wxDefaultSize, wxDEFAULT_DIALOG_STYLE),
-      HexBedViewer(1) {
+      HexBedViewer(1),
+      parent_(parent),
+      context_(context) {
+    wxBoxSizer* top = new wxBoxSizer(wxVERTICAL);
     wxGridSizer* sizer = new wxGridSizer(2, 10, 3, 3);
     for (int i = 0; i < 8; ++i) {
         sizer->Add(
@@ -60,7 +68,28 @@ BitEditorTool::BitEditorTool(HexBedMainFrame* parent,
     byteLabel_->SetFont(wxFont(orig.GetPointSize(), wxFONTFAMILY_TELETYPE,
                                orig.GetStyle(), orig.GetWeight()));
     byteLabel_->SetLabel("FF");
-    SetSizer(sizer);
+
+    wxBoxSizer* find = new wxBoxSizer(wxHORIZONTAL);
+    findInput_ = new wxTextCtrl(this, wxID_ANY);
+    findInput_->SetToolTip(_("Bits to find at any bit offset"));
+    wxButton* prevButton = new wxButton(this, wxID_ANY, _("&Previous"));
+    wxButton* nextButton = new wxButton(this, wxID_ANY, _("&Next"));
+    wxButton* allButton = new wxButton(this, wxID_ANY, _("Find &all"));
+    prevButton->Bind(wxEVT_BUTTON,
+                     [this](wxCommandEvent& event) { FindBits(false); });
+    nextButton->Bind(wxEVT_BUTTON,
+                     [this](wxCommandEvent& event) { FindBits(true); });
+    allButton->Bind(wxEVT_BUTTON, &BitEditorTool::OnFindAll, this);
+    find->Add(findInput_, wxSizerFlags().Center().Proportion(1));
+    find->Add(prevButton);
+    find->Add(nextButton);
+    find->Add(allButton);
+    findStatus_ = new wxStaticText(this, wxID_ANY, wxEmptyString);
+
+    top->Add(sizer, wxSizerFlags().Center());
+    top->Add(find, wxSizerFlags().Expand());
+    top->Add(findStatus_, wxSizerFlags().Expand());
+    SetSizer(top);
     Layout();
     Fit();
     wasAllowed_ = true;
@@ -107,6 +136,60 @@ void BitEditorTool::OnBitFlip(int bit, bool newState) {
     }
 }
 
+bool BitEditorTool::UpdatePattern() {
+    wxString text = findInput_->GetValue();
+    if (!pattern_ || text != patternText_) {
+        pattern_ = FindBitsDialog::MakePattern(text);
+        patternText_ = text;
+        matchDocument_ = nullptr;
+    }
+    return pattern_ != nullptr;
+}
+
+void BitEditorTool::FindBits(bool forward) {
+    if (!document_ || !UpdatePattern()) return;
+    HexBedDocument* document = document_;
+    const BitPattern& pattern = *pattern_;
+    bufsize n = pattern.length(), total = document->size() * 8;
+    bufsize cur = offset_ * 8;
+    bool stepPast = false;
+    // continue from the last match for as long as the cursor is on it
+    if (matchDocument_ == document && offset_ >= match_.offset &&
+        offset_ <= match_.offset + (match_.shift + n + 7) / 8) {
+        cur = match_.offset * 8 + match_.shift;
+        stepPast = true;
+    }
+    BitSearchResult res{};
+    HexBedTask task(context_.get(), 0, true);
+    task.run([&](HexBedTask& task) {
+        if (forward)
+            res = searchForwardBits(task, *document, stepPast ? cur + 1 : cur,
+                                    total, pattern);
+        else
+            res = searchBackwardBits(task, *document, 0,
+                                     std::min(total, cur + n - 1), pattern);
+    });
+    if (task.isCancelled()) return;
+    if (!res) {
+        findStatus_->SetLabel(_("No more matches"));
+        wxBell();
+        return;
+    }
+    matchDocument_ = document;
+    match_ = res;
+    findStatus_->SetLabel(wxString::Format(
+        _("Match at %s, bit %u"),
+        wxString(convertBaseTo(res.offset, config().offsetRadix,
+                               config().uppercase)),
+        res.shift));
+    parent_->ShowDocumentRange(document, res.offset,
+                               (res.shift + n + 7) / 8);
+}
+
+void BitEditorTool::OnFindAll(wxCommandEvent& event) {
+    if (UpdatePattern()) parent_->DoFindAllBits(pattern_);
+}
+
 };  // namespace ui
 
 };  // namespace hexbed
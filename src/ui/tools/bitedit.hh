@@ -26,8 +26,12 @@
 #include <wx/checkbox.h>
 #include <wx/dialog.h>
 #include <wx/stattext.h>
+#include <wx/textctrl.h>
+
+#include <memory>
 
 #include "common/types.hh"
+#include "file/bitsearch.hh"
 #include "ui/context.hh"
 
 namespace hexbed {
@@ -42,14 +46,27 @@ class BitEditorTool : public wxDialog, public HexBedViewer {
 
   private:
     void OnBitFlip(int bit, bool newState);
+    bool UpdatePattern();
+    void FindBits(bool forward);
+    void OnFindAll(wxCommandEvent& event);
+
+    HexBedMainFrame* parent_;
+    std::shared_ptr<HexBedContextMain> context_;
     HexBedDocument* document_;
     bufsize offset_;
     wxCheckBox* bitChecks_[8];
     wxStaticText* bitLabels_[8];
     wxStaticText* byteLabel_;
+    wxTextCtrl* findInput_;
+    wxStaticText* findStatus_;
     byte buf_;
     HexBedViewerRegistration reg_;
     bool wasAllowed_;
+    wxString patternText_;
+    std::shared_ptr<const BitPattern> pattern_;
+    // the last match found, so that Find next can step past it
+    HexBedDocument* matchDocument_{nullptr};
+    BitSearchResult match_;
 };
 
 };  // namespace ui
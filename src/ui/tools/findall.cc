@@ -0,0 +1,437 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// ui/tools/findall.cc -- impl for the Find all results tool
+
+#include "ui/tools/findall.hh"
+
+#include <wx/msgdlg.h>
+#include <wx/sizer.h>
+
+#include <chrono>
+
+#include "app/config.hh"
+#include "common/hexconv.hh"
+#include "common/logger.hh"
+#include "file/document.hh"
+#include "file/task.hh"
+#include "ui/hexbed.hh"
+
+namespace hexbed {
+
+namespace ui {
+
+// bytes searched per call and the time spent per timer tick; the search
+// runs on the UI thread in slices, so that the document can be edited
+// while it runs, and waits while a task has the document (see HexBedTask)
+static constexpr bufsize FIND_ALL_SLICE = 1 << 20;
+static constexpr auto FIND_ALL_TICK = std::chrono::milliseconds(40);
+static constexpr int FIND_ALL_INTERVAL = 10;
+// most matches kept from a search that runs to completion
+static constexpr std::size_t FIND_ALL_KEPT_MAXIMUM = 1 << 20;
+// bytes shown per match in the list
+static constexpr bufsize FIND_ALL_PREVIEW = 16;
+
+FindAllList::FindAllList(FindAllTool* parent)
+    : wxListView(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize,
+                 wxLC_REPORT | wxLC_VIRTUAL | wxLC_SINGLE_SEL),
+      tool_(parent) {}
+
+wxString FindAllList::OnGetItemText(long item, long column) const {
+    return tool_->GetItemText(item, column);
+}
+
+FindAllTool::FindAllTool(HexBedMainFrame* parent,
+                         std::shared_ptr<HexBedContextMain> context)
+    : wxDialog(parent, wxID_ANY, _("Find all"), wxDefaultPosition,
+               wxSize(400, 400), wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER),
+      HexBedViewer(0),
+      parent_(parent),
+      context_(context),
+      timer_(this, wxID_ANY) {
+    wxBoxSizer* sizer = new wxBoxSizer(wxVERTICAL);
+    wxBoxSizer* bottom = new wxBoxSizer(wxHORIZONTAL);
+    listView_ = new FindAllList(this);
+    SetColumns();
+    status_ = new wxStaticText(this, wxID_ANY, wxEmptyString,
+                               wxDefaultPosition, wxDefaultSize,
+                               wxST_ELLIPSIZE_END | wxST_NO_AUTORESIZE);
+    stopButton_ = new wxButton(this, wxID_ANY, _("&Stop"));
+    bottom->Add(status_, wxSizerFlags().Center().Proportion(1));
+    bottom->Add(stopButton_);
+    sizer->Add(listView_, wxSizerFlags().Expand().Proportion(1));
+    sizer->Add(bottom, wxSizerFlags().Expand());
+    SetSizer(sizer);
+    Layout();
+    reg_ = HexBedViewerRegistration(context, this);
+    Bind(wxEVT_TIMER, &FindAllTool::OnTimer, this);
+    stopButton_->Bind(wxEVT_BUTTON, &FindAllTool::OnStopOrRestart, this);
+    listView_->Bind(wxEVT_LIST_ITEM_SELECTED, &FindAllTool::OnSelectItem,
+                    this);
+    listView_->Bind(wxEVT_LIST_ITEM_ACTIVATED, &FindAllTool::OnSelectItem,
+                    this);
+}
+
+void FindAllTool::onUpdateCursor(HexBedPeekRegion peek) {}
+
+void FindAllTool::onBytesChanged(HexBedDocument* document, bufsize start) {
+    if (stale_ || document != document_.get()) return;
+    // offsets may have shifted, so the results can no longer be trusted
+    stale_ = true;
+    Stop();
+}
+
+void FindAllTool::Start(std::shared_ptr<HexBedDocument> document,
+                        const_bytespan data) {
+    document_ = document;
+    needle_.assign(data.begin(), data.end());
+    patterns_ = nullptr;
+    query_ = nullptr;
+    approx_ = nullptr;
+    bits_ = nullptr;
+    fill_ = nullptr;
+    SetColumns();
+    Restart();
+}
+
+void FindAllTool::Start(std::shared_ptr<HexBedDocument> document,
+                        std::shared_ptr<const MultiPattern> patterns) {
+    document_ = document;
+    needle_.clear();
+    patterns_ = patterns;
+    query_ = nullptr;
+    approx_ = nullptr;
+    bits_ = nullptr;
+    fill_ = nullptr;
+    SetColumns();
+    Restart();
+}
+
+void FindAllTool::Start(std::shared_ptr<HexBedDocument> document,
+                        std::shared_ptr<const NumericQuery> query) {
+    document_ = document;
+    needle_.clear();
+    patterns_ = nullptr;
+    query_ = query;
+    approx_ = nullptr;
+    bits_ = nullptr;
+    fill_ = nullptr;
+    SetColumns();
+    Restart();
+}
+
+void FindAllTool::Start(std::shared_ptr<HexBedDocument> document,
+                        std::shared_ptr<const ApproximatePattern> pattern) {
+    document_ = document;
+    needle_.clear();
+    patterns_ = nullptr;
+    query_ = nullptr;
+    approx_ = pattern;
+    bits_ = nullptr;
+    fill_ = nullptr;
+    SetColumns();
+    Restart();
+}
+
+void FindAllTool::Start(std::shared_ptr<HexBedDocument> document,
+                        std::shared_ptr<const BitPattern> pattern) {
+    document_ = document;
+    needle_.clear();
+    patterns_ = nullptr;
+    query_ = nullptr;
+    approx_ = nullptr;
+    bits_ = pattern;
+    fill_ = nullptr;
+    SetColumns();
+    Restart();
+}
+
+void FindAllTool::Start(std::shared_ptr<HexBedDocument> document,
+                        std::shared_ptr<const FillPattern> fill,
+                        bufsize minimum) {
+    document_ = document;
+    needle_.clear();
+    patterns_ = nullptr;
+    query_ = nullptr;
+    approx_ = nullptr;
+    bits_ = nullptr;
+    fill_ = fill;
+    fillMinimum_ = minimum;
+    SetColumns();
+    Restart();
+}
+
+void FindAllTool::SetColumns() {
+    listView_->ClearAll();
+    listView_->AppendColumn(_("Offset"), wxLIST_FORMAT_RIGHT, 150);
+    if (patterns_)
+        listView_->AppendColumn(_("Pattern"), wxLIST_FORMAT_LEFT, 150);
+    if (query_) listView_->AppendColumn(_("Value"), wxLIST_FORMAT_LEFT, 150);
+    if (approx_)
+        listView_->AppendColumn(_("Distance"), wxLIST_FORMAT_RIGHT, 80);
+    if (bits_) listView_->AppendColumn(_("Bit"), wxLIST_FORMAT_RIGHT, 50);
+    if (fill_)
+        listView_->AppendColumn(_("Length"), wxLIST_FORMAT_RIGHT, 100);
+    listView_->AppendColumn(_("Data"), wxLIST_FORMAT_LEFT, 400);
+}
+
+void FindAllTool::Restart() {
+    matches_.clear();
+    matchLittleEndian_.clear();
+    ranked_.clear();
+    regionLengths_.clear();
+    truncated_ = false;
+    state_ = 0;
+    next_ = 0;
+    stale_ = false;
+    running_ =
+        document_ && (patterns_ || query_ || bits_ || !needle_.empty());
+    listView_->SetItemCount(0);
+    listView_->Refresh();
+    if (document_ && approx_) {
+        SearchApproximate();
+        listView_->SetItemCount(ranked_.size());
+    } else if (document_ && fill_) {
+        SearchRegions();
+        listView_->SetItemCount(matches_.size());
+    } else if (running_)
+        timer_.Start(FIND_ALL_INTERVAL);
+    UpdateStatus();
+}
+
+void FindAllTool::SearchApproximate() {
+    HexBedTask task(context_.get(), document_->size(), true);
+    bool complete = true;
+    try {
+        task.run([this, &complete](HexBedTask& task) {
+            complete = document_->searchApproximate(
+                task, 0, document_->size(), *approx_,
+                FIND_ALL_KEPT_MAXIMUM, ranked_);
+        });
+    } catch (...) {
+        ranked_.clear();
+        wxMessageBox(wxString::Format(_("Find all failed: %s"),
+                                      currentExceptionAsString()),
+                     "HexBed", wxOK | wxICON_ERROR);
+    }
+    truncated_ = !complete && !task.isCancelled();
+}
+
+void FindAllTool::SearchRegions() {
+    HexBedTask task(context_.get(), document_->size(), true);
+    try {
+        task.run([this](HexBedTask& task) {
+            searchDataRegions(
+                task, *document_, 0, document_->size(), *fill_, fillMinimum_,
+                [this](bufoffset offset, bufsize length) {
+                    if (regionLengths_.size() >= FIND_ALL_KEPT_MAXIMUM) {
+                        truncated_ = true;
+                        return false;
+                    }
+                    matches_.add(offset);
+                    regionLengths_.push_back(length);
+                    return true;
+                });
+        });
+    } catch (...) {
+        matches_.clear();
+        regionLengths_.clear();
+        wxMessageBox(wxString::Format(_("Find all failed: %s"),
+                                      currentExceptionAsString()),
+                     "HexBed", wxOK | wxICON_ERROR);
+    }
+}
+
+std::size_t FindAllTool::MatchCount() const noexcept {
+    return approx_ ? ranked_.size() : matches_.size();
+}
+
+void FindAllTool::Stop() {
+    running_ = false;
+    timer_.Stop();
+    UpdateStatus();
+}
+
+void FindAllTool::UpdateStatus() {
+    std::size_t n = MatchCount();
+    wxString text = wxString::Format(
+        wxPLURAL("%llu match", "%llu matches", n),
+        static_cast<unsigned long long>(n));
+    if (running_) {
+        bufsize total = document_->size() * (bits_ ? 8 : 1);
+        text = wxString::Format(_("Searching (%d%%)... %s"),
+                                total ? static_cast<int>(next_ * 100 / total)
+                                      : 100,
+                                text);
+    } else if (stale_) {
+        text = wxString::Format(_("%s (document changed)"), text);
+    } else if (truncated_) {
+        text = wxString::Format(_("%s (limit reached)"), text);
+    }
+    status_->SetLabel(text);
+    stopButton_->SetLabel(running_ ? _("&Stop") : _("&Search again"));
+    stopButton_->Enable(running_ || document_);
+}
+
+void FindAllTool::OnTimer(wxTimerEvent& event) {
+    if (!running_ || context_->taskRunning()) return;
+    auto deadline = std::chrono::steady_clock::now() + FIND_ALL_TICK;
+    HexBedTask task(context_.get(), 0, true);
+    bufsize end = document_->size() * (bits_ ? 8 : 1);
+    try {
+        do {
+            if (next_ >= end) {
+                running_ = false;
+                break;
+            }
+            SearchSlice(task, end);
+        } while (std::chrono::steady_clock::now() < deadline);
+    } catch (...) {
+        running_ = false;
+        wxMessageBox(wxString::Format(_("Find all failed: %s"),
+                                      currentExceptionAsString()),
+                     "HexBed", wxOK | wxICON_ERROR);
+    }
+    if (!running_) {
+        next_ = end;
+        timer_.Stop();
+    }
+    listView_->SetItemCount(matches_.size());
+    UpdateStatus();
+}
+
+void FindAllTool::SearchSlice(HexBedTask& task, bufsize end) {
+    if (patterns_) {
+        // the automaton carries its state over, so slices need no overlap
+        bufoffset e =
+            end - next_ > FIND_ALL_SLICE ? next_ + FIND_ALL_SLICE : end;
+        document_->searchMulti(task, next_, e, *patterns_, state_,
+                               [this](std::size_t p, bufoffset o) {
+                                   matches_.add(
+                                       o, static_cast<std::uint32_t>(p));
+                               });
+        next_ = e;
+        return;
+    }
+    bufsize z = bits_    ? bits_->length()
+                : query_ ? query_->width()
+                         : needle_.size();
+    bufsize slice = bits_ ? FIND_ALL_SLICE * 8 : FIND_ALL_SLICE;
+    if (end - next_ < z) {
+        next_ = end;
+        return;
+    }
+    bufoffset e =
+        end - next_ - (z - 1) > slice ? next_ + slice + z - 1 : end;
+    if (bits_)
+        searchAllBits(task, *document_, next_, e, *bits_,
+                      [this](bufoffset o, unsigned shift) {
+                          matches_.add(o * 8 + shift);
+                      });
+    else if (query_)
+        document_->searchNumeric(task, next_, e, *query_,
+                                 [this](bufoffset o, bool littleEndian) {
+                                     matches_.add(o);
+                                     matchLittleEndian_.push_back(
+                                         littleEndian);
+                                 });
+    else
+        document_->searchAll(task, next_, e,
+                             const_bytespan(needle_.data(), z),
+                             [this](bufoffset o) { matches_.add(o); });
+    next_ = e == end ? end : e - z + 1;
+}
+
+bufoffset FindAllTool::GetMatch(std::size_t index, bufsize& length) const {
+    if (approx_) {
+        length = ranked_[index].length;
+        return ranked_[index].offset;
+    }
+    if (query_) {
+        length = query_->width();
+        return matches_[index];
+    }
+    if (fill_) {
+        length = regionLengths_[index];
+        return matches_[index];
+    }
+    if (bits_) {
+        bufoffset bit = matches_[index];
+        length = (bit % 8 + bits_->length() + 7) / 8;
+        return bit / 8;
+    }
+    if (!patterns_) {
+        length = needle_.size();
+        return matches_[index];
+    }
+    length = patterns_->pattern(matches_.tag(index)).size();
+    return matches_[index] - length + 1;
+}
+
+void FindAllTool::OnStopOrRestart(wxCommandEvent& event) {
+    if (running_)
+        Stop();
+    else
+        Restart();
+}
+
+void FindAllTool::OnSelectItem(wxListEvent& event) {
+    long i = event.GetIndex();
+    if (i < 0 || static_cast<std::size_t>(i) >= MatchCount()) return;
+    bufsize length;
+    bufoffset offset = GetMatch(i, length);
+    parent_->ShowDocumentRange(document_.get(), offset, length);
+}
+
+wxString FindAllTool::GetItemText(long item, long column) const {
+    if (item < 0 || static_cast<std::size_t>(item) >= MatchCount())
+        return wxEmptyString;
+    bufsize length;
+    bufoffset offset = GetMatch(item, length);
+    if (column == 0)
+        return convertBaseTo(offset, config().offsetRadix, config().uppercase);
+    if (patterns_ && column == 1)
+        return wxString::FromUTF8(patterns_->name(matches_.tag(item)));
+    if (approx_ && column == 1)
+        return wxString::Format("%llu", static_cast<unsigned long long>(
+                                            ranked_[item].distance));
+    if (bits_ && column == 1)
+        return wxString::Format("%u", static_cast<unsigned>(
+                                          matches_[item] % 8));
+    if (fill_ && column == 1)
+        return convertBaseTo(length, config().offsetRadix, config().uppercase);
+    if (stale_) return wxEmptyString;
+    byte buf[FIND_ALL_PREVIEW];
+    bufsize n = document_->read(
+        offset, bytespan(buf, std::min<bufsize>(length, sizeof(buf))));
+    if (query_ && column == 1) {
+        if (n < length) return wxEmptyString;
+        bool le = matchLittleEndian_[item];
+        wxString text = wxString::FromUTF8(query_->format(buf, le));
+        if (length > 1) text += le ? _(" (LE)") : _(" (BE)");
+        return text;
+    }
+    wxString text = hexFromBytes(n, buf, config().uppercase);
+    if (length > n) text += " ...";
+    return text;
+}
+
+};  // namespace ui
+
+};  // namespace hexbed
@@ -0,0 +1,132 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// ui/tools/findall.hh -- header for the Find all results tool
+
+#ifndef HEXBED_UI_TOOLS_FINDALL_HH
+#define HEXBED_UI_TOOLS_FINDALL_HH
+
+#include <wx/button.h>
+#include <wx/dialog.h>
+#include <wx/listctrl.h>
+#include <wx/stattext.h>
+#include <wx/timer.h>
+
+#include <vector>
+
+#include "common/types.hh"
+#include "file/approxsearch.hh"
+#include "file/bitsearch.hh"
+#include "file/fillscan.hh"
+#include "file/matchlist.hh"
+#include "file/multisearch.hh"
+#include "file/numsearch.hh"
+#include "ui/context.hh"
+
+namespace hexbed {
+
+namespace ui {
+
+class FindAllTool;
+
+class FindAllList : public wxListView {
+  public:
+    FindAllList(FindAllTool* parent);
+
+  protected:
+    wxString OnGetItemText(long item, long column) const override;
+
+  private:
+    FindAllTool* tool_;
+};
+
+class FindAllTool : public wxDialog, public HexBedViewer {
+  public:
+    FindAllTool(HexBedMainFrame* parent,
+                std::shared_ptr<HexBedContextMain> context);
+    void onUpdateCursor(HexBedPeekRegion peek) override;
+    void onBytesChanged(HexBedDocument* document, bufsize start) override;
+
+    void Start(std::shared_ptr<HexBedDocument> document, const_bytespan data);
+    void Start(std::shared_ptr<HexBedDocument> document,
+               std::shared_ptr<const MultiPattern> patterns);
+    void Start(std::shared_ptr<HexBedDocument> document,
+               std::shared_ptr<const NumericQuery> query);
+    void Start(std::shared_ptr<HexBedDocument> document,
+               std::shared_ptr<const ApproximatePattern> pattern);
+    void Start(std::shared_ptr<HexBedDocument> document,
+               std::shared_ptr<const BitPattern> pattern);
+    void Start(std::shared_ptr<HexBedDocument> document,
+               std::shared_ptr<const FillPattern> fill, bufsize minimum);
+    wxString GetItemText(long item, long column) const;
+
+  private:
+    void Restart();
+    void SetColumns();
+    void SearchSlice(HexBedTask& task, bufsize end);
+    void SearchApproximate();
+    void SearchRegions();
+    std::size_t MatchCount() const noexcept;
+    bufoffset GetMatch(std::size_t index, bufsize& length) const;
+    void Stop();
+    void UpdateStatus();
+    void OnTimer(wxTimerEvent& event);
+    void OnStopOrRestart(wxCommandEvent& event);
+    void OnSelectItem(wxListEvent& event);
+
+    HexBedMainFrame* parent_;
+    std::shared_ptr<HexBedContextMain> context_;
+    std::shared_ptr<HexBedDocument> document_;
+    HexBedViewerRegistration reg_;
+    std::vector<byte> needle_;
+    // for multi-pattern searches, matches_ has the offsets of the last
+    // bytes of matches, since those are found in order, tagged with the
+    // index of the pattern
+    std::shared_ptr<const MultiPattern> patterns_;
+    MultiPattern::State state_{0};
+    // for numeric searches, the byte order of every match
+    std::shared_ptr<const NumericQuery> query_;
+    std::vector<bool> matchLittleEndian_;
+    // approximate searches run to completion, since their results are
+    // ranked by distance
+    std::shared_ptr<const ApproximatePattern> approx_;
+    std::vector<ApproximateMatch> ranked_;
+    bool truncated_{false};
+    // for bit searches, matches_ has bit positions and next_ counts bits
+    std::shared_ptr<const BitPattern> bits_;
+    // data region listings also run to completion. matches_ has the
+    // offsets of the regions
+    std::shared_ptr<const FillPattern> fill_;
+    bufsize fillMinimum_{0};
+    std::vector<bufsize> regionLengths_;
+    MatchList matches_;
+    bufoffset next_{0};
+    bool running_{false};
+    bool stale_{false};
+    wxTimer timer_;
+    FindAllList* listView_;
+    wxStaticText* status_;
+    wxButton* stopButton_;
+};
+
+};  // namespace ui
+
+};  // namespace hexbed
+
+#endif /* HEXBED_UI_TOOLS_FINDALL_HH */
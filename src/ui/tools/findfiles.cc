@@ -0,0 +1,237 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// ui/tools/findfiles.cc -- impl for the Search in Files tool
+
+#include "ui/tools/findfiles.hh"
+
+#include <wx/msgdlg.h>
+#include <wx/sizer.h>
+
+#include "app/config.hh"
+#include "common/hexconv.hh"
+#include "common/logger.hh"
+#include "ui/hexbed.hh"
+#include "ui/string.hh"
+
+namespace hexbed {
+
+namespace ui {
+
+static constexpr int FIND_IN_FILES_INTERVAL = 100;
+
+FindInFilesList::FindInFilesList(FindInFilesTool* parent)
+    : wxListView(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize,
+                 wxLC_REPORT | wxLC_VIRTUAL | wxLC_SINGLE_SEL),
+      tool_(parent) {}
+
+wxString FindInFilesList::OnGetItemText(long item, long column) const {
+    return tool_->GetItemText(item, column);
+}
+
+FindInFilesTool::FindInFilesTool(HexBedMainFrame* parent)
+    : wxDialog(parent, wxID_ANY, _("Search in files"), wxDefaultPosition,
+               wxSize(500, 500), wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER),
+      parent_(parent),
+      timer_(this, wxID_ANY) {
+    wxBoxSizer* sizer = new wxBoxSizer(wxVERTICAL);
+    wxFlexGridSizer* form = new wxFlexGridSizer(2, 3, 3);
+    wxBoxSizer* needleRow = new wxBoxSizer(wxHORIZONTAL);
+    wxBoxSizer* sizeRow = new wxBoxSizer(wxHORIZONTAL);
+    wxBoxSizer* bottom = new wxBoxSizer(wxHORIZONTAL);
+    form->AddGrowableCol(1);
+
+    folderInput_ = new wxDirPickerCtrl(this, wxID_ANY);
+    needleInput_ = new wxTextCtrl(this, wxID_ANY);
+    hexCheck_ = new wxCheckBox(this, wxID_ANY, _("&Hex"));
+    hexCheck_->SetValue(true);
+    globInput_ = new wxTextCtrl(this, wxID_ANY, "*");
+    globInput_->SetToolTip(_("Separate several patterns with semicolons"));
+    minimumInput_ = new wxTextCtrl(this, wxID_ANY);
+    maximumInput_ = new wxTextCtrl(this, wxID_ANY);
+    needleRow->Add(needleInput_, wxSizerFlags().Center().Proportion(1));
+    needleRow->Add(hexCheck_, wxSizerFlags().Center());
+    sizeRow->Add(minimumInput_, wxSizerFlags().Center().Proportion(1));
+    sizeRow->Add(new wxStaticText(this, wxID_ANY, _(" to ")),
+                 wxSizerFlags().Center());
+    sizeRow->Add(maximumInput_, wxSizerFlags().Center().Proportion(1));
+    sizeRow->Add(new wxStaticText(this, wxID_ANY, _(" bytes")),
+                 wxSizerFlags().Center());
+
+    form->Add(new wxStaticText(this, wxID_ANY, _("Folder:")),
+              wxSizerFlags().CenterVertical());
+    form->Add(folderInput_, wxSizerFlags().Expand());
+    form->Add(new wxStaticText(this, wxID_ANY, _("Find:")),
+              wxSizerFlags().CenterVertical());
+    form->Add(needleRow, wxSizerFlags().Expand());
+    form->Add(new wxStaticText(this, wxID_ANY, _("File names:")),
+              wxSizerFlags().CenterVertical());
+    form->Add(globInput_, wxSizerFlags().Expand());
+    form->Add(new wxStaticText(this, wxID_ANY, _("File size:")),
+              wxSizerFlags().CenterVertical());
+    form->Add(sizeRow, wxSizerFlags().Expand());
+
+    listView_ = new FindInFilesList(this);
+    listView_->AppendColumn(_("File"), wxLIST_FORMAT_LEFT, 350);
+    listView_->AppendColumn(_("Offset"), wxLIST_FORMAT_RIGHT, 120);
+    status_ = new wxStaticText(this, wxID_ANY, wxEmptyString,
+                               wxDefaultPosition, wxDefaultSize,
+                               wxST_ELLIPSIZE_END | wxST_NO_AUTORESIZE);
+    searchButton_ = new wxButton(this, wxID_ANY, _("&Search"));
+    bottom->Add(status_, wxSizerFlags().Center().Proportion(1));
+    bottom->Add(searchButton_);
+
+    sizer->Add(form, wxSizerFlags().Expand());
+    sizer->Add(listView_, wxSizerFlags().Expand().Proportion(1));
+    sizer->Add(bottom, wxSizerFlags().Expand());
+    SetSizer(sizer);
+    Layout();
+
+    Bind(wxEVT_TIMER, &FindInFilesTool::OnTimer, this);
+    searchButton_->Bind(wxEVT_BUTTON, &FindInFilesTool::OnSearchOrStop, this);
+    listView_->Bind(wxEVT_LIST_ITEM_ACTIVATED,
+                    &FindInFilesTool::OnActivateItem, this);
+}
+
+FindInFilesTool::~FindInFilesTool() { timer_.Stop(); }
+
+static bool parseFileSize(const wxString& text, bufsize& out) {
+    string s = stringFromWx(text.Strip(wxString::both));
+    return s.empty() || convertBaseFrom(out, s, 10);
+}
+
+bool FindInFilesTool::MakeSearch(std::vector<byte>& needle,
+                                 FileSearchFilter& filter) {
+    wxString text = needleInput_->GetValue();
+    if (hexCheck_->GetValue()) {
+        bufsize n = text.length();
+        needle.resize(n);
+        if (!hexToBytes(n, needle.data(), stringFromWx(text))) {
+            wxMessageBox(_("The bytes to find are not valid hex."), "HexBed",
+                         wxOK | wxICON_ERROR);
+            return false;
+        }
+        needle.resize(n);
+    } else {
+        wxScopedCharBuffer utf8 = text.ToUTF8();
+        needle.assign(reinterpret_cast<const byte*>(utf8.data()),
+                      reinterpret_cast<const byte*>(utf8.data()) +
+                          utf8.length());
+    }
+    if (needle.empty()) {
+        wxMessageBox(_("Enter something to find."), "HexBed",
+                     wxOK | wxICON_ERROR);
+        return false;
+    }
+    if (!parseFileSize(minimumInput_->GetValue(), filter.minimumSize) ||
+        !parseFileSize(maximumInput_->GetValue(), filter.maximumSize)) {
+        wxMessageBox(_("File sizes must be given in bytes."), "HexBed",
+                     wxOK | wxICON_ERROR);
+        return false;
+    }
+    filter.glob = globInput_->GetValue().ToStdString(wxConvUTF8);
+    return true;
+}
+
+void FindInFilesTool::OnSearchOrStop(wxCommandEvent& event) {
+    if (search_ && search_->running()) {
+        Stop();
+        return;
+    }
+    std::vector<byte> needle;
+    FileSearchFilter filter;
+    if (!MakeSearch(needle, filter)) return;
+    std::error_code ec;
+    std::filesystem::path root(stringFromWx(folderInput_->GetPath()));
+    if (root.empty() || !std::filesystem::is_directory(root, ec)) {
+        wxMessageBox(_("Choose a folder to search in."), "HexBed",
+                     wxOK | wxICON_ERROR);
+        return;
+    }
+    root_ = std::move(root);
+    needleSize_ = needle.size();
+    hits_.clear();
+    listView_->SetItemCount(0);
+    listView_->Refresh();
+    search_ = nullptr;
+    try {
+        search_ = std::make_unique<FileSearch>(root_, std::move(filter),
+                                               std::move(needle));
+    } catch (...) {
+        wxMessageBox(wxString::Format(_("Search in files failed: %s"),
+                                      currentExceptionAsString()),
+                     "HexBed", wxOK | wxICON_ERROR);
+        return;
+    }
+    timer_.Start(FIND_IN_FILES_INTERVAL);
+    UpdateStatus();
+}
+
+void FindInFilesTool::Stop() {
+    if (search_) search_->cancel();
+}
+
+void FindInFilesTool::OnTimer(wxTimerEvent& event) {
+    if (!search_) return;
+    bool running = search_->running();
+    search_->take(hits_);
+    if (!running) timer_.Stop();
+    listView_->SetItemCount(hits_.size());
+    UpdateStatus();
+}
+
+void FindInFilesTool::UpdateStatus() {
+    bool running = search_ && search_->running();
+    std::size_t files = search_ ? search_->filesSearched() : 0;
+    std::size_t failed = search_ ? search_->filesFailed() : 0;
+    wxString text = wxString::Format(
+        wxPLURAL("%llu match", "%llu matches", hits_.size()),
+        static_cast<unsigned long long>(hits_.size()));
+    text += wxString::Format(wxPLURAL(" in %llu file", " in %llu files", files),
+                             static_cast<unsigned long long>(files));
+    if (running)
+        text = wxString::Format(_("Searching... %s"), text);
+    else if (search_ && search_->truncated())
+        text = wxString::Format(_("%s (limit reached)"), text);
+    if (failed)
+        text += wxString::Format(
+            wxPLURAL(", %llu could not be read", ", %llu could not be read",
+                     failed),
+            static_cast<unsigned long long>(failed));
+    status_->SetLabel(search_ ? text : wxString());
+    searchButton_->SetLabel(running ? _("&Stop") : _("&Search"));
+}
+
+void FindInFilesTool::OnActivateItem(wxListEvent& event) {
+    long i = event.GetIndex();
+    if (i < 0 || static_cast<std::size_t>(i) >= hits_.size()) return;
+    parent_->ShowFileRange(hits_[i].path, hits_[i].offset, needleSize_);
+}
+
+wxString FindInFilesTool::GetItemText(long item, long column) const {
+    if (item < 0 || static_cast<std::size_t>(item) >= hits_.size())
+        return wxEmptyString;
+    const FileSearchHit& hit = hits_[item];
+    if (column == 0) return pathToWxString(hit.path.lexically_relative(root_));
+    return convertBaseTo(hit.offset, config().offsetRadix, config().uppercase);
+}
+
+};  // namespace ui
+
+};  // namespace hexbed
@@ -0,0 +1,93 @@
+/****************************************************************************/
+/*                                                                          */
+/* HexBed -- Hex editor                                                     */
+/* Copyright (c) 2021-2022 Sampo Hippeläinen (hisahi)                       */
+/*                                                                          */
+/* This program is free software: you can redistribute it and/or modify     */
+/* it under the terms of the GNU General Public License as published by     */
+/* the Free Software Foundation, either version 3 of the License, or        */
+/* (at your option) any later version.                                      */
+/*                                                                          */
+/* This program is distributed in the hope that it will be useful,          */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/* GNU General Public License for more details.                             */
+/*                                                                          */
+/* You should have received a copy of the GNU General Public License        */
+/* along with this program.  If not, see <https://www.gnu.org/licenses/>.   */
+/*                                                                          */
+/****************************************************************************/
+// ui/tools/findfiles.hh -- header for the Search in Files tool
+
+#ifndef HEXBED_UI_TOOLS_FINDFILES_HH
+#define HEXBED_UI_TOOLS_FINDFILES_HH
+
+#include <wx/button.h>
+#include <wx/checkbox.h>
+#include <wx/dialog.h>
+#include <wx/filepicker.h>
+#include <wx/listctrl.h>
+#include <wx/stattext.h>
+#include <wx/textctrl.h>
+#include <wx/timer.h>
+
+#include <memory>
+#include <vector>
+
+#include "common/types.hh"
+#include "file/filesearch.hh"
+#include "ui/hexbed-fwd.hh"
+
+namespace hexbed {
+
+namespace ui {
+
+class FindInFilesTool;
+
+class FindInFilesList : public wxListView {
+  public:
+    FindInFilesList(FindInFilesTool* parent);
+
+  protected:
+    wxString OnGetItemText(long item, long column) const override;
+
+  private:
+    FindInFilesTool* tool_;
+};
+
+class FindInFilesTool : public wxDialog {
+  public:
+    FindInFilesTool(HexBedMainFrame* parent);
+    ~FindInFilesTool();
+    wxString GetItemText(long item, long column) const;
+
+  private:
+    bool MakeSearch(std::vector<byte>& needle, FileSearchFilter& filter);
+    void Stop();
+    void UpdateStatus();
+    void OnTimer(wxTimerEvent& event);
+    void OnSearchOrStop(wxCommandEvent& event);
+    void OnActivateItem(wxListEvent& event);
+
+    HexBedMainFrame* parent_;
+    std::filesystem::path root_;
+    bufsize needleSize_{0};
+    std::unique_ptr<FileSearch> search_;
+    std::vector<FileSearchHit> hits_;
+    wxTimer timer_;
+    wxDirPickerCtrl* folderInput_;
+    wxTextCtrl* needleInput_;
+    wxCheckBox* hexCheck_;
+    wxTextCtrl* globInput_;
+    wxTextCtrl* minimumInput_;
+    wxTextCtrl* maximumInput_;
+    FindInFilesList* listView_;
+    wxStaticText* status_;
+    wxButton* searchButton_;
+};
+
+};  // namespace ui
+
+};  // namespace hexbed
+
+#endif /* HEXBED_UI_TOOLS_FINDFILES_HH */